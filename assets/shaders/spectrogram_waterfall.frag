@@ -0,0 +1,41 @@
+precision highp float;
+
+// Waterfall over the native spectrogram history in HistoryFormat.rgba8,
+// uploaded as an image with decodeImageFromPixels. Each texel packs four
+// consecutive bins (r, g, b, a), so a row of uBins bins is ceil(uBins / 4)
+// texels wide. Row uHead is the newest spectrum; older rows follow it
+// cyclically, so the texture never has to be re-ordered.
+uniform sampler2D uHistory;
+uniform float uRows;
+uniform float uHead;
+uniform float uBins;
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / vec2(1920.0, 1080.0);
+
+    // newest row at the bottom of the screen, scrolling up
+    float age = floor((1.0 - uv.y) * uRows);
+    float row = mod(uHead - age + uRows, uRows);
+
+    // bin -> texel and the component within it
+    float bin = min(floor(uv.x * uBins), uBins - 1.0);
+    float texels = ceil(uBins / 4.0);
+    float texel = floor(bin / 4.0);
+    float lane = mod(bin, 4.0);
+    vec4 packed = texture2D(uHistory, vec2((texel + 0.5) / texels, (row + 0.5) / uRows));
+    vec4 pick = vec4(
+        lane < 0.5 ? 1.0 : 0.0,
+        lane >= 0.5 && lane < 1.5 ? 1.0 : 0.0,
+        lane >= 1.5 && lane < 2.5 ? 1.0 : 0.0,
+        lane >= 2.5 ? 1.0 : 0.0
+    );
+    float amp = dot(packed, pick);
+
+    vec3 color = mix(
+        vec3(0.1, 0.7, 1.0),
+        vec3(0.6, 0.2, 1.0),
+        amp
+    );
+
+    gl_FragColor = vec4(color * amp * 1.8, 1.0);
+}
@@ -0,0 +1,267 @@
+import 'dart:typed_data';
+
+import 'bin_decoder.dart';
+
+/// Per-band stereo analysis sent alongside the mono bins.
+class StereoBands {
+  /// Left (or mid) band levels, same scale as [AnalysisFrame.bins].
+  final List<double> first;
+
+  /// Right (or side) band levels.
+  final List<double> second;
+
+  /// Inter-channel correlation per band, -1..1.
+  final List<double> correlation;
+
+  /// Balance per band, -1 (left) .. 1 (right).
+  final List<double> balance;
+
+  /// True when [first]/[second] hold mid/side instead of left/right.
+  final bool midSide;
+
+  const StereoBands({
+    required this.first,
+    required this.second,
+    required this.correlation,
+    required this.balance,
+    required this.midSide,
+  });
+}
+
+/// One tracked spectral peak. [id] stays the same while the peak persists,
+/// so effects can follow it from frame to frame.
+class SpectralPeak {
+  final int id;
+
+  /// Frames since [id] was assigned.
+  final int age;
+
+  /// Sub-bin accurate frequency in Hz.
+  final double frequency;
+
+  /// dBFS at the interpolated peak.
+  final double levelDb;
+
+  const SpectralPeak({
+    required this.id,
+    required this.age,
+    required this.frequency,
+    required this.levelDb,
+  });
+}
+
+/// Pitch-class profile of the current frame.
+class Chroma {
+  /// 12 values (C, C#, ... B), 0..1 relative to the strongest class.
+  final List<double> classes;
+
+  /// Strongest pitch class (0 = C), or -1 when silent.
+  final int pitchClass;
+
+  /// Estimated tuning offset from A4 = 440 Hz, in cents.
+  final double tuningCents;
+
+  const Chroma({
+    required this.classes,
+    required this.pitchClass,
+    required this.tuningCents,
+  });
+}
+
+/// BS.1770 / EBU R128 loudness measured on the raw capture stream.
+///
+/// Values are LUFS (true peak in dBTP) and are `-infinity` until there is
+/// signal above the gates.
+class LoudnessReading {
+  /// 400 ms window.
+  final double momentary;
+
+  /// 3 s window.
+  final double shortTerm;
+
+  /// Gated, since start or the last [SystemAudioVisualizer.resetLoudness].
+  final double integrated;
+
+  /// Highest inter-sample peak since the last reset.
+  final double truePeak;
+
+  const LoudnessReading({
+    required this.momentary,
+    required this.shortTerm,
+    required this.integrated,
+    required this.truePeak,
+  });
+
+  factory LoudnessReading.decode(Map<dynamic, dynamic> map) {
+    return LoudnessReading(
+      momentary: (map['momentary'] as num).toDouble(),
+      shortTerm: (map['shortTerm'] as num).toDouble(),
+      integrated: (map['integrated'] as num).toDouble(),
+      truePeak: (map['truePeak'] as num).toDouble(),
+    );
+  }
+}
+
+/// Ready-to-draw buffers built natively for the viewport passed to
+/// [SystemAudioVisualizer.setGeometry]; x, y pairs in logical pixels.
+/// Only the buffers of the configured layout are present.
+class FrameGeometry {
+  /// Bar bodies, for `Vertices.raw(VertexMode.triangles, ...)`.
+  final Float32List? triangles;
+
+  /// Peak caps, for `Vertices.raw(VertexMode.triangles, ...)`.
+  final Float32List? caps;
+
+  /// Bar outlines or petal strokes, for `drawRawPoints(PointMode.lines, ...)`.
+  final Float32List? lines;
+
+  /// The wave, for `drawRawPoints(PointMode.polygon, ...)`.
+  final Float32List? polyline;
+
+  const FrameGeometry({this.triangles, this.caps, this.lines, this.polyline});
+
+  factory FrameGeometry.decode(Map<dynamic, dynamic> map) {
+    return FrameGeometry(
+      triangles: map['triangles'] as Float32List?,
+      caps: map['caps'] as Float32List?,
+      lines: map['lines'] as Float32List?,
+      polyline: map['polyline'] as Float32List?,
+    );
+  }
+}
+
+/// One native analysis frame.
+///
+/// The event channel sends a bare list of bins when nothing else is enabled,
+/// or a map with the bins under `bins` plus the optional analysis outputs.
+/// With a packed bin encoding the bins arrive as a [Uint8List] packet that
+/// needs the stream's [BinDecoder].
+class AnalysisFrame {
+  /// With a packed bin encoding this is the stream's [BinDecoder.values]
+  /// and is overwritten by the next frame; copy it to keep it.
+  final List<double> bins;
+  final StereoBands? stereo;
+
+  /// Quantized spectrogram rows added since the previous frame, oldest
+  /// first ([historyCount] of them, more than one after a catch-up), and
+  /// the native ring index of the newest. [historyRows] is the size of the
+  /// native ring that index refers to.
+  final Uint8List? historyRow;
+  final int? historyHead;
+  final int historyCount;
+  final int? historyRows;
+
+  final LoudnessReading? loudness;
+
+  final Chroma? chroma;
+
+  /// Harmonic (tonal) and percussive (drum) layers of [bins], same bands
+  /// and scale; null unless separation is enabled.
+  final List<double>? harmonic;
+  final List<double>? percussive;
+
+  /// Strongest peaks first; null unless peak tracking is enabled.
+  final List<SpectralPeak>? peaks;
+
+  /// Position in seconds within a replayed session; null for live frames.
+  final double? replayTime;
+
+  /// Native draw buffers; null unless geometry is enabled and a viewport
+  /// is set.
+  final FrameGeometry? geometry;
+
+  const AnalysisFrame({
+    required this.bins,
+    this.stereo,
+    this.historyRow,
+    this.historyHead,
+    this.historyCount = 1,
+    this.historyRows,
+    this.loudness,
+    this.chroma,
+    this.peaks,
+    this.harmonic,
+    this.percussive,
+    this.replayTime,
+    this.geometry,
+  });
+
+  factory AnalysisFrame.decode(dynamic event, [BinDecoder? decoder]) {
+    if (event is! Map) {
+      return AnalysisFrame(bins: _bins(event, decoder));
+    }
+
+    StereoBands? stereo;
+    if (event.containsKey('correlation')) {
+      final midSide = event.containsKey('mid');
+      stereo = StereoBands(
+        first: _doubles(event[midSide ? 'mid' : 'left']),
+        second: _doubles(event[midSide ? 'side' : 'right']),
+        correlation: _doubles(event['correlation']),
+        balance: _doubles(event['balance']),
+        midSide: midSide,
+      );
+    }
+
+    return AnalysisFrame(
+      bins: _bins(event['bins'], decoder),
+      stereo: stereo,
+      historyRow: event['historyRow'] as Uint8List?,
+      historyHead: event['historyHead'] as int?,
+      historyCount: event['historyCount'] as int? ?? 1,
+      historyRows: event['historyRows'] as int?,
+      loudness: event['loudness'] is Map
+          ? LoudnessReading.decode(event['loudness'] as Map)
+          : null,
+      chroma: event.containsKey('chroma')
+          ? Chroma(
+              classes: _doubles(event['chroma']),
+              pitchClass: event['pitchClass'] as int,
+              tuningCents: (event['tuningCents'] as num).toDouble(),
+            )
+          : null,
+      peaks: event.containsKey('peakIds') ? _peaks(event) : null,
+      harmonic:
+          event.containsKey('harmonic') ? _doubles(event['harmonic']) : null,
+      percussive: event.containsKey('percussive')
+          ? _doubles(event['percussive'])
+          : null,
+      replayTime: (event['replayTime'] as num?)?.toDouble(),
+      geometry: event['geometry'] is Map
+          ? FrameGeometry.decode(event['geometry'] as Map)
+          : null,
+    );
+  }
+
+  static List<SpectralPeak> _peaks(Map<dynamic, dynamic> event) {
+    final ids = event['peakIds'] as List;
+    final ages = event['peakAges'] as List;
+    final freqs = _doubles(event['peakFreqs']);
+    final levels = _doubles(event['peakLevels']);
+    return List.generate(
+      ids.length,
+      (i) => SpectralPeak(
+        id: ids[i] as int,
+        age: ages[i] as int,
+        frequency: freqs[i],
+        levelDb: levels[i],
+      ),
+      growable: false,
+    );
+  }
+
+  // packed bins are the decoder's buffer itself, updated in place
+  static List<double> _bins(dynamic value, BinDecoder? decoder) {
+    if (value is! Uint8List) return _doubles(value);
+    if (decoder == null) {
+      throw ArgumentError('packed bins need a BinDecoder');
+    }
+    decoder.decode(value);
+    return decoder.values;
+  }
+
+  static List<double> _doubles(dynamic value) {
+    if (value is List<double>) return value;
+    return (value as List<dynamic>).map((e) => (e as num).toDouble()).toList();
+  }
+}
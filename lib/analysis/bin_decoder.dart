@@ -0,0 +1,79 @@
+import 'dart:typed_data';
+
+/// Receiver side of the packed bin encodings (`binEncoding: u8/u16` in
+/// `SystemAudioVisualizer.start`).
+///
+/// A packet is a little-endian header (version, flags, band count,
+/// sequence, scale, entry count) followed by either one quantized value per
+/// band (keyframe) or `(band, value)` pairs for the bands that changed
+/// (delta). [values] holds the reconstructed levels and is updated in place.
+class BinDecoder {
+  static const int _headerBytes = 14;
+  static const int _flagKeyframe = 1;
+  static const int _flagWide = 2;
+
+  Float32List values = Float32List(0);
+  int _sequence = -1;
+  bool _synced = false;
+
+  /// Applies [packet] to [values]. Returns false while no keyframe has been
+  /// seen since a gap in the sequence, or for a malformed packet (entries
+  /// that overrun it or name a band past the band count); [values] then
+  /// keeps the last good state until the next keyframe arrives.
+  bool decode(Uint8List packet) {
+    final data = ByteData.sublistView(packet);
+    if (packet.length < _headerBytes || data.getUint8(0) != 1) return false;
+
+    final flags = data.getUint8(1);
+    final bands = data.getUint16(2, Endian.little);
+    final sequence = data.getUint32(4, Endian.little);
+    final scale = data.getFloat32(8, Endian.little);
+    final entries = data.getUint16(12, Endian.little);
+
+    final wide = flags & _flagWide != 0;
+    final step = scale / (wide ? 65535.0 : 255.0);
+    final keyframe = flags & _flagKeyframe != 0;
+    final valueBytes = wide ? 2 : 1;
+    final entryBytes = keyframe ? valueBytes : 2 + valueBytes;
+    if ((keyframe && entries != bands) ||
+        packet.length < _headerBytes + entries * entryBytes) {
+      _sequence = -1;
+      return _synced = false;
+    }
+
+    if (sequence == _sequence) return _synced;
+    final inOrder = _sequence >= 0 && sequence == (_sequence + 1) & 0xffffffff;
+    _sequence = sequence;
+
+    if (keyframe) {
+      if (values.length != bands) values = Float32List(bands);
+      var offset = _headerBytes;
+      for (var b = 0; b < entries; b++) {
+        values[b] = _read(data, offset, wide) * step;
+        offset += valueBytes;
+      }
+      return _synced = true;
+    }
+
+    if (!_synced || !inOrder || values.length != bands) {
+      return _synced = false;
+    }
+    // checked before anything is applied, so a bad packet never leaves
+    // half of its deltas behind
+    for (var i = 0; i < entries; i++) {
+      final band =
+          data.getUint16(_headerBytes + i * entryBytes, Endian.little);
+      if (band >= bands) return _synced = false;
+    }
+    var offset = _headerBytes;
+    for (var i = 0; i < entries; i++) {
+      final band = data.getUint16(offset, Endian.little);
+      values[band] = _read(data, offset + 2, wide) * step;
+      offset += entryBytes;
+    }
+    return true;
+  }
+
+  static int _read(ByteData data, int offset, bool wide) =>
+      wide ? data.getUint16(offset, Endian.little) : data.getUint8(offset);
+}
@@ -0,0 +1,60 @@
+import 'dart:typed_data';
+
+import 'analysis_frame.dart';
+
+/// Dart-side mirror of the native spectrogram ring.
+///
+/// The buffer is allocated once; each frame copies only its new rows into
+/// their slots, so the history is never rebuilt. [pixels] is row-major and can
+/// be handed straight to `decodeImageFromPixels` (rgba8) or a shader, using
+/// [head] as the row offset of the newest spectrum.
+///
+/// [rows] always matches the native ring: [seed] and every frame carry it.
+/// If the ring is reconfigured (a restart with another size or format), the
+/// mirror starts over at the new layout rather than wrapping rows into the
+/// wrong slots.
+class SpectrogramHistory {
+  SpectrogramHistory([this.rows = 0]);
+
+  int rows;
+  Uint8List pixels = Uint8List(0);
+  int rowBytes = 0;
+  int head = -1;
+
+  /// Seeds the mirror from `SystemAudioVisualizer.getSpectrogram()`.
+  void seed(Map<String, dynamic> snapshot) {
+    rows = snapshot['rows'] as int;
+    rowBytes = snapshot['rowBytes'] as int;
+    head = snapshot['head'] as int;
+    pixels = Uint8List.fromList(snapshot['pixels'] as Uint8List);
+  }
+
+  /// Patches the rows a frame carries; returns false if it had none.
+  bool update(AnalysisFrame frame) {
+    final block = frame.historyRow;
+    final rowHead = frame.historyHead;
+    if (block == null || rowHead == null) return false;
+
+    final ringRows = frame.historyRows ?? rows;
+    final count = frame.historyCount;
+    if (ringRows <= 0 || count <= 0 || count > ringRows) return false;
+
+    final bytes = block.length ~/ count;
+    if (ringRows != rows ||
+        bytes != rowBytes ||
+        pixels.length != rows * bytes) {
+      rows = ringRows;
+      rowBytes = bytes;
+      pixels = Uint8List(rows * rowBytes);
+    }
+
+    // oldest first, ending at the head
+    for (var i = 0; i < count; i++) {
+      final index = (rowHead - count + 1 + i) % rows;
+      pixels.setRange(
+          index * rowBytes, (index + 1) * rowBytes, block, i * rowBytes);
+    }
+    head = rowHead;
+    return true;
+  }
+}
@@ -0,0 +1,34 @@
+/// Decimated time-domain frame from the native waveform stream.
+///
+/// Raw samples never leave the plugin; each frame carries a fixed number of
+/// points regardless of the device sample rate.
+class WaveformFrame {
+  /// Per-segment minimum of the mono mix (oscilloscope lower edge), -1..1.
+  final List<double> min;
+
+  /// Per-segment maximum of the mono mix (oscilloscope upper edge), -1..1.
+  final List<double> max;
+
+  /// Left channel of the vectorscope point cloud.
+  final List<double> scopeL;
+
+  /// Right channel of the vectorscope point cloud.
+  final List<double> scopeR;
+
+  const WaveformFrame({
+    required this.min,
+    required this.max,
+    required this.scopeL,
+    required this.scopeR,
+  });
+
+  factory WaveformFrame.decode(dynamic event) {
+    final map = event as Map<dynamic, dynamic>;
+    return WaveformFrame(
+      min: map['min'] as List<double>,
+      max: map['max'] as List<double>,
+      scopeL: map['scopeL'] as List<double>,
+      scopeR: map['scopeR'] as List<double>,
+    );
+  }
+}
@@ -1,6 +1,63 @@
 import 'dart:async';
+import 'dart:typed_data';
 import 'package:flutter/services.dart';
 
+import 'analysis/analysis_frame.dart';
+import 'analysis/bin_decoder.dart';
+import 'analysis/waveform_frame.dart';
+
+export 'analysis/analysis_frame.dart';
+export 'analysis/bin_decoder.dart';
+export 'analysis/spectrogram_history.dart';
+export 'analysis/waveform_frame.dart';
+
+/// Analysis window applied before the FFT. Amplitudes are gain-compensated
+/// natively, so switching windows does not change the level of a tone.
+enum FftWindow { hann, hamming, blackmanHarris, kaiser, flatTop }
+
+/// How native band levels are mapped to 0..1.
+enum BinScale {
+  /// Relative to the loudest bin of each frame (legacy behaviour).
+  normalized,
+
+  /// Absolute dBFS between a floor and a ceiling, optionally with a slow
+  /// auto-gain that tracks a running percentile of levels.
+  dbfs,
+}
+
+/// Stereo analysis mode.
+enum StereoMode {
+  off,
+
+  /// Left/right spectra plus per-band correlation and balance.
+  leftRight,
+
+  /// Mid/side spectra plus per-band correlation and balance.
+  midSide,
+}
+
+/// Scheduling class of the native capture/analysis thread (MMCSS on
+/// Windows, SCHED_FIFO or nice elsewhere).
+enum RealtimePriority { off, audio, proAudio }
+
+/// Quantization of the native spectrogram history.
+enum HistoryFormat { r8, r16, rgba8 }
+
+/// Shape of the native draw buffers (see [SystemAudioVisualizer.setGeometry]).
+enum GeometryLayout { none, bars, petals, wave }
+
+/// Wire format of the bins on the frame stream.
+enum BinEncoding {
+  /// Typed list of floats (no packing).
+  float,
+
+  /// One byte per band, scaled to the frame's peak.
+  u8,
+
+  /// Two bytes per band, scaled to the frame's peak.
+  u16,
+}
+
 class SystemAudioVisualizer {
   static const MethodChannel _method = MethodChannel(
     'system_audio_visualizer/methods',
@@ -10,17 +67,299 @@ class SystemAudioVisualizer {
     'system_audio_visualizer/fft',
   );
 
+  static const EventChannel _waveformChannel = EventChannel(
+    'system_audio_visualizer/waveform',
+  );
+
   /// Start capture with optional FFT config.
-  static Future<void> start({int fftSize = 2048, int bins = 64}) {
-    return _method.invokeMethod('start', {'fftSize': fftSize, 'bins': bins});
+  ///
+  /// [fftSize] may be any 2^a * 3^b * 5^c size, so frame-aligned sizes such
+  /// as 960 or 1920 (20/40 ms at 48 kHz) work natively.
+  ///
+  /// When [cpuBudget] is set (share of one core, e.g. 0.25) the native
+  /// quality governor steps FFT size, frame rate and band count down/up to
+  /// stay within it. The current mode is reported by [getStats].
+  ///
+  /// [fastMath] selects the fused SIMD magnitude/log kernels (bounded
+  /// error, about 1e-5 dB); pass false for exact libm math.
+  ///
+  /// [window] picks the analysis window; [kaiserBeta] shapes
+  /// [FftWindow.kaiser].
+  ///
+  /// [scale] selects [BinScale.normalized] or [BinScale.dbfs]; the latter
+  /// maps [floorDb]..[ceilingDb] to 0..1 and, with [autoGain], boosts quiet
+  /// material slowly instead of normalizing every frame.
+  ///
+  /// [stereo] enables per-channel spectra with inter-channel correlation and
+  /// balance, delivered through [frameStream].
+  ///
+  /// [waveformSpanMs] of audio is reduced to [waveformPoints] min/max pairs
+  /// and [scopePoints] L/R pairs for [waveformStream].
+  ///
+  /// [historyRows] > 0 keeps a native ring of that many past spectra,
+  /// quantized as [historyFormat]; frames then carry the newest row for a
+  /// [SpectrogramHistory] mirror.
+  ///
+  /// [chroma] adds a 12-class pitch profile with tuning estimation to every
+  /// frame (see [AnalysisFrame.chroma]; `VisualizerTheme.keyTinted` maps it to colors).
+  ///
+  /// [peaks] > 0 tracks that many of the strongest spectral peaks (above
+  /// [peakFloorDb] dBFS) with stable ids (see [AnalysisFrame.peaks]).
+  ///
+  /// [hpss] splits the spectrum into harmonic and percussive band vectors
+  /// (median lengths [hpssTimeFrames] frames and [hpssFreqBins] bins), see
+  /// [AnalysisFrame.harmonic] and [AnalysisFrame.percussive].
+  ///
+  /// [loudness] adds momentary, short-term and integrated LUFS plus true
+  /// peak to every frame (see [AnalysisFrame.loudness]).
+  ///
+  /// [realtime] promotes the capture thread; [getStats] reports the mode
+  /// that was granted plus deadline misses and worst lateness.
+  ///
+  /// [microphone] mixes the default recording device (scaled by
+  /// [microphoneGain]) into the analysed output. Its clock drift against the
+  /// output device is tracked and resampled away natively; [getStats]
+  /// reports the estimate and whether a microphone was opened.
+  ///
+  /// [hop] > 0 takes a spectrum every [hop] analysis samples instead of once
+  /// per capture packet. A backlog that arrives at once after a stall is then
+  /// analysed frame by frame, so the spectrogram history and the native
+  /// features see every hop, while only its newest frame is sent;
+  /// [getStats] counts the others as `catchUpFrames`.
+  ///
+  /// [maxExtrapolationMs] bounds how far [sampleSpectrum] runs ahead of the
+  /// newest analysis frame before it holds that frame.
+  ///
+  /// [binEncoding] packs the bins into 8 or 16 bits per band (about a
+  /// quarter or half of the float bytes); [frameStream] decodes them. With
+  /// [deltaThreshold] > 0 only bands that moved more than that (0..1 scale)
+  /// are sent, with a full keyframe every [keyframeInterval] frames.
+  /// [getStats] reports `binBytesPerSec` next to `floatBinBytesPerSec`.
+  ///
+  /// [geometry] builds draw buffers natively for the viewport given to
+  /// [setGeometry] (see [AnalysisFrame.geometry]).
+  ///
+  /// [stages] picks the analysis stages by name instead of the feature
+  /// flags above: `loudness`, `waveform`, `chroma`, `peaks`, `hpss`,
+  /// `history` and `geometry`. The spectrum always runs; stages a requested
+  /// one depends on are added automatically, and [getStats] lists the
+  /// active ones under `stages`. Use [setStages] to change the set while
+  /// capture runs.
+  ///
+  /// Devices running above [analysisRate] (e.g. 96/192 kHz) are decimated
+  /// natively before the FFT so bin spacing is the same on every device.
+  /// Rates below 8000 are raised to 8000, and a rate whose ratio to the
+  /// device rate does not reduce to a small fraction (e.g. 47999 against
+  /// 48000) is moved to the nearest one that does; [getStats] reports the
+  /// rate in use as `analysisRate`.
+  static Future<void> start({
+    int fftSize = 2048,
+    int bins = 64,
+    int hop = 0,
+    double maxExtrapolationMs = 50.0,
+    BinEncoding binEncoding = BinEncoding.float,
+    double deltaThreshold = 0.0,
+    int keyframeInterval = 30,
+    double? cpuBudget,
+    int analysisRate = 48000,
+    bool fastMath = true,
+    FftWindow window = FftWindow.hann,
+    double kaiserBeta = 8.6,
+    BinScale scale = BinScale.normalized,
+    double floorDb = -90.0,
+    double ceilingDb = 0.0,
+    bool autoGain = false,
+    StereoMode stereo = StereoMode.off,
+    int waveformSpanMs = 50,
+    int waveformPoints = 512,
+    int scopePoints = 256,
+    int historyRows = 0,
+    HistoryFormat historyFormat = HistoryFormat.r8,
+    bool loudness = false,
+    bool geometry = false,
+    bool chroma = false,
+    int peaks = 0,
+    double peakFloorDb = -80.0,
+    bool hpss = false,
+    int hpssTimeFrames = 17,
+    int hpssFreqBins = 17,
+    RealtimePriority realtime = RealtimePriority.audio,
+    bool microphone = false,
+    double microphoneGain = 1.0,
+    List<String>? stages,
+  }) {
+    return _method.invokeMethod('start', {
+      'fftSize': fftSize,
+      'bins': bins,
+      'hop': hop,
+      'maxExtrapolationMs': maxExtrapolationMs,
+      'binEncoding': binEncoding.name,
+      'deltaThreshold': deltaThreshold,
+      'keyframeInterval': keyframeInterval,
+      'analysisRate': analysisRate,
+      'fastMath': fastMath,
+      'window': window.name,
+      'kaiserBeta': kaiserBeta,
+      'scale': scale.name,
+      'floorDb': floorDb,
+      'ceilingDb': ceilingDb,
+      'autoGain': autoGain,
+      'stereo': stereo.name,
+      'waveformSpanMs': waveformSpanMs,
+      'waveformPoints': waveformPoints,
+      'scopePoints': scopePoints,
+      'historyRows': historyRows,
+      'historyFormat': historyFormat.name,
+      'loudness': loudness,
+      'geometry': geometry,
+      'chroma': chroma,
+      'peaks': peaks,
+      'peakFloorDb': peakFloorDb,
+      'hpss': hpss,
+      'hpssTimeFrames': hpssTimeFrames,
+      'hpssFreqBins': hpssFreqBins,
+      'realtime': realtime.name,
+      'microphone': microphone,
+      'microphoneGain': microphoneGain,
+      if (cpuBudget != null) 'cpuBudget': cpuBudget,
+      if (stages != null) 'stages': stages,
+    });
   }
 
   static Future<void> stop() => _method.invokeMethod('stop');
 
-  /// FFT bin stream
-  static Stream<List<double>> get fftStream =>
-      _fftChannel.receiveBroadcastStream().map((dynamic event) {
-        final list = event as List<dynamic>;
-        return list.map((e) => (e as num).toDouble()).toList();
-      });
+  /// Replaces the running analysis stages (see [start]) without stopping
+  /// capture. Unknown names are rejected and leave the current set running.
+  static Future<void> setStages(List<String> stages) =>
+      _method.invokeMethod('setStages', {'stages': stages});
+
+  /// Viewport for the native draw buffers, in logical pixels. Call it again
+  /// when the visualizer is resized; [GeometryLayout.none] stops the work.
+  ///
+  /// [GeometryLayout.bars] averages the bins into [count] bars ([barFill]
+  /// of each slot, [cornerRadius] corners) with caps [capHeight] high that
+  /// fall by [capDecay] per frame; [GeometryLayout.petals] draws [count]
+  /// strokes out of a ring of [ringRadius] times the shorter side, with
+  /// levels raised to [petalShape]; [GeometryLayout.wave] is a smoothed
+  /// polyline of [count] points through every bin. [intensity] scales
+  /// lengths like `VisualizerConfig.intensity`. Without [count] the layout
+  /// picks the count of the Dart painter it replaces: 12 bars, 51 petals
+  /// and 12 wave points.
+  static Future<void> setGeometry({
+    required GeometryLayout layout,
+    required double width,
+    required double height,
+    int? count,
+    double pad = 20.0,
+    double intensity = 1.0,
+    double cornerRadius = 12.0,
+    double barFill = 0.7,
+    double capHeight = 4.0,
+    double capDecay = 0.02,
+    double ringRadius = 0.27,
+    double petalShape = 1.8,
+  }) {
+    return _method.invokeMethod('setGeometry', {
+      'layout': layout.name,
+      'width': width,
+      'height': height,
+      if (count != null) 'count': count,
+      'pad': pad,
+      'intensity': intensity,
+      'cornerRadius': cornerRadius,
+      'barFill': barFill,
+      'capHeight': capHeight,
+      'capDecay': capDecay,
+      'ringRadius': ringRadius,
+      'petalShape': petalShape,
+    });
+  }
+
+  /// Spectrum resampled to display time, for a once-per-vsync ticker.
+  ///
+  /// Analysis frames are stamped with the capture time of their window
+  /// centre; the result is interpolated between the two frames around
+  /// `now - delayMs` (or briefly extrapolated past the newest one), so bars
+  /// move smoothly at any refresh rate. A [delayMs] near the output latency
+  /// minus the display latency lines the picture up with what is heard.
+  /// Null before the first frame. [getStats] counts interpolated,
+  /// extrapolated and held samples and reports `displayLeadMs`.
+  static Future<Float32List?> sampleSpectrum({double delayMs = 0.0}) =>
+      _method.invokeMethod<Float32List>(
+          'sampleSpectrum', {'delayMs': delayMs});
+
+  /// Native pipeline statistics (timings, quality mode, ...).
+  static Future<Map<String, dynamic>> getStats() async {
+    final stats = await _method.invokeMapMethod<String, dynamic>('getStats');
+    return stats ?? const {};
+  }
+
+  /// Restarts integrated loudness and the true-peak hold.
+  static Future<void> resetLoudness() => _method.invokeMethod('resetLoudness');
+
+  /// Full snapshot of the native spectrogram ring (rows, rowBytes, format,
+  /// head, pixels), for seeding a [SpectrogramHistory].
+  static Future<Map<String, dynamic>> getSpectrogram() async {
+    final snapshot =
+        await _method.invokeMapMethod<String, dynamic>('getSpectrogram');
+    return snapshot ?? const {};
+  }
+
+  /// Records every analysis frame (bins, peaks, loudness and chroma when
+  /// enabled) to a session file at [path] until [stopRecording] or [stop].
+  /// Capture must be running.
+  static Future<void> startRecording(String path) =>
+      _method.invokeMethod('startRecording', {'path': path});
+
+  static Future<void> stopRecording() => _method.invokeMethod('stopRecording');
+
+  /// Plays a recorded session back through [frameStream] at its original
+  /// pace ([speed] scales it), starting at [position] seconds. Replayed
+  /// frames carry [AnalysisFrame.replayTime]. Not available while capture
+  /// is running; [start] ends a replay.
+  static Future<void> startReplay(
+    String path, {
+    double position = 0.0,
+    double speed = 1.0,
+    bool loop = false,
+  }) {
+    return _method.invokeMethod('startReplay', {
+      'path': path,
+      'position': position,
+      'speed': speed,
+      'loop': loop,
+    });
+  }
+
+  /// Jumps the running replay to [position] seconds.
+  static Future<void> seekReplay(double position) =>
+      _method.invokeMethod('seekReplay', {'position': position});
+
+  static Future<void> stopReplay() => _method.invokeMethod('stopReplay');
+
+  /// Full analysis frames (bins plus any enabled extras).
+  static Stream<AnalysisFrame> get frameStream {
+    final decoder = BinDecoder();
+    return _fftChannel
+        .receiveBroadcastStream()
+        .map((dynamic event) => AnalysisFrame.decode(event, decoder));
+  }
+
+  /// Oscilloscope envelope and vectorscope points, one frame per analysis
+  /// frame. The native side only does the work while this is listened to.
+  static Stream<WaveformFrame> get waveformStream => _waveformChannel
+      .receiveBroadcastStream()
+      .map((dynamic event) => WaveformFrame.decode(event));
+
+  /// FFT bin stream. Every event owns its list, also with a packed
+  /// [BinEncoding] where [frameStream] reuses one buffer.
+  static Stream<List<double>> get fftStream {
+    final decoder = BinDecoder();
+    return _fftChannel.receiveBroadcastStream().map((dynamic event) {
+      final bins = AnalysisFrame.decode(event, decoder).bins;
+      return identical(bins, decoder.values)
+          ? Float32List.fromList(bins)
+          : bins;
+    });
+  }
 }
@@ -1,4 +1,7 @@
+import 'dart:math' as math;
+
 import 'package:flutter/material.dart';
+import '../../analysis/analysis_frame.dart';
 import 'visualizer_config.dart';
 
 class VisualizerTheme {
@@ -23,4 +26,32 @@ class VisualizerTheme {
         thickness: 4,
         radius: 12,
       );
+
+  /// Pulls the hues of [base] toward the key that is playing. Pitch classes
+  /// are placed on the circle of fifths, so related keys get neighbouring
+  /// hues; a flat (atonal/noisy) profile leaves the colors unchanged.
+  static VisualizerConfig keyTinted(
+    VisualizerConfig base,
+    Chroma chroma, {
+    double strength = 0.6,
+  }) {
+    double x = 0, y = 0, total = 0;
+    for (int c = 0; c < chroma.classes.length; c++) {
+      final angle = ((c * 7) % 12) * math.pi / 6;
+      x += chroma.classes[c] * math.cos(angle);
+      y += chroma.classes[c] * math.sin(angle);
+      total += chroma.classes[c];
+    }
+    if (total <= 0) return base;
+
+    final keyHue = (math.atan2(y, x) * 180 / math.pi + 360) % 360;
+    final amount = strength * math.sqrt(x * x + y * y) / total;
+
+    final colors = base.colors.map((color) {
+      final hsv = HSVColor.fromColor(color);
+      final delta = ((keyHue - hsv.hue + 540) % 360) - 180;
+      return hsv.withHue((hsv.hue + delta * amount + 360) % 360).toColor();
+    }).toList();
+    return base.copyWith(colors: colors);
+  }
 }
@@ -8,11 +8,19 @@ class AnimeWaveVisualizer extends StatefulWidget {
     super.key,
     required this.bins,
     required this.config,
+    this.harmonic,
+    this.percussive,
   });
 
   final List<double> bins;
   final VisualizerConfig config;
 
+  /// Optional separated layers (AnalysisFrame.harmonic / .percussive).
+  /// When given, tonal content drives the voice wave and drums drive the
+  /// bass pulse and the treble wave.
+  final List<double>? harmonic;
+  final List<double>? percussive;
+
   @override
   State<AnimeWaveVisualizer> createState() => _AnimeWaveVisualizerState();
 }
@@ -47,6 +55,8 @@ class _AnimeWaveVisualizerState extends State<AnimeWaveVisualizer>
             widget.bins,
             widget.config,
             _controller.value, // flowing gradient phase
+            widget.harmonic,
+            widget.percussive,
           ),
           size: Size.infinite,
         );
@@ -59,16 +69,25 @@ class _TripleWavePainter extends CustomPainter {
   final List<double> bins;
   final VisualizerConfig config;
   final double flow;
+  final List<double>? harmonic;
+  final List<double>? percussive;
 
-  _TripleWavePainter(this.bins, this.config, this.flow);
+  _TripleWavePainter(
+    this.bins,
+    this.config,
+    this.flow,
+    this.harmonic,
+    this.percussive,
+  );
 
   // Safe average even if bins are small
-  double _avg(int start, int end) {
-    if (bins.isEmpty) return 0.0;
+  double _avg(int start, int end, [List<double>? source]) {
+    final values = source ?? bins;
+    if (values.isEmpty) return 0.0;
     double sum = 0;
-    final safeEnd = math.min(end, bins.length);
+    final safeEnd = math.min(end, values.length);
     for (int i = start; i < safeEnd; i++) {
-      sum += bins[i];
+      sum += values[i];
     }
     return sum / (safeEnd - start).clamp(1, 999999);
   }
@@ -85,9 +104,10 @@ class _TripleWavePainter extends CustomPainter {
     final double width = size.width - pad * 2;
 
     // FREQUENCY GROUPING
-    final double voice = _avg(10, 35); // mids
+    // (tonal mids and drum lows/highs when separated layers are given)
+    final double voice = _avg(10, 35, harmonic); // mids
     final double bass = _avg(0, 10); // low frequencies
-    final double trebleRaw = _avg(35, 64); // high frequencies
+    final double trebleRaw = _avg(35, 64, percussive); // high frequencies
 
     // Boost treble so it becomes visible
     final double treble = math.pow(trebleRaw, 0.5) * 2.3;
@@ -98,7 +118,8 @@ class _TripleWavePainter extends CustomPainter {
     final double Atreble = treble * size.height * 0.12 * config.intensity;
 
     // Bass center pulse effect
-    final double bassPulse = bass * 22.0;
+    final double bassPulse =
+        (percussive != null ? _avg(0, 10, percussive) : bass) * 22.0;
 
     const int steps = 260;
     const double freq = 8.0; // more waves across the width
@@ -1,5 +1,8 @@
 import 'dart:math';
+import 'dart:ui' as ui;
+
 import 'package:flutter/material.dart';
+import '../../analysis/analysis_frame.dart';
 import '../core/visualizer_config.dart';
 
 class CircleSpectrumVisualizer extends StatefulWidget {
@@ -7,11 +10,16 @@ class CircleSpectrumVisualizer extends StatefulWidget {
     super.key,
     required this.bins,
     required this.config,
+    this.geometry,
   });
 
   final List<double> bins;
   final VisualizerConfig config;
 
+  /// Native petal strokes (`GeometryLayout.petals` set to this widget's
+  /// size); when given, [bins] is not laid out in Dart.
+  final FrameGeometry? geometry;
+
   @override
   State<CircleSpectrumVisualizer> createState() =>
       _CircleSpectrumVisualizerState();
@@ -46,6 +54,7 @@ class _CircleSpectrumVisualizerState extends State<CircleSpectrumVisualizer>
             widget.bins,
             widget.config,
             _controller.value * 2 * pi, // 0 → 2π rotation
+            widget.geometry,
           ),
           size: Size.infinite,
         );
@@ -58,14 +67,23 @@ class _PetalRingPainter extends CustomPainter {
   final List<double> bins;
   final VisualizerConfig config;
   final double rotation; // flowing radial gradient rotation
+  final FrameGeometry? geometry;
 
-  _PetalRingPainter(this.bins, this.config, this.rotation);
+  _PetalRingPainter(this.bins, this.config, this.rotation, this.geometry);
 
   @override
   void paint(Canvas canvas, Size size) {
     final center = size.center(Offset.zero);
     final radius = min(size.width, size.height) * 0.27;
 
+    final petals = geometry?.lines;
+    if (petals != null) {
+      canvas.drawRawPoints(
+          ui.PointMode.lines, petals, _petalPaint(center, radius));
+      _paintInnerRing(canvas, center, radius);
+      return;
+    }
+
     final int count = 51;
     final stride = bins.length ~/ count;
     final List<double> reduced = [];
@@ -80,15 +98,6 @@ class _PetalRingPainter extends CustomPainter {
 
     final step = 2 * pi / count;
 
-    // IG-style neon rotating gradient palette
-    final List<Color> igColors = [
-      const Color(0xFFFF512F),
-      const Color(0xFFDD2476),
-      const Color(0xFFFF6FD8),
-      const Color(0xFFF83600),
-      const Color(0xFFFE8C00),
-    ];
-
     for (int i = 0; i < count; i++) {
       double prev = reduced[(i - 1) % count];
       double next = reduced[(i + 1) % count];
@@ -118,22 +127,37 @@ class _PetalRingPainter extends CustomPainter {
         ..moveTo(start.dx, start.dy)
         ..quadraticBezierTo(mid.dx, mid.dy, end.dx, end.dy);
 
-      // Dynamic radial flowing sweep gradient
-      final paint = Paint()
-        ..strokeWidth = config.thickness * 0.9
-        ..style = PaintingStyle.stroke
-        ..strokeCap = StrokeCap.round
-        ..shader = SweepGradient(
-          colors: igColors,
-          startAngle: rotation, // this rotates the gradient!
-          endAngle: rotation + 2 * pi, // full spin
-          tileMode: TileMode.repeated,
-        ).createShader(Rect.fromCircle(center: center, radius: radius * 1.2));
-
-      canvas.drawPath(path, paint);
+      canvas.drawPath(path, _petalPaint(center, radius));
     }
 
-    // Soft inner ring shimmer
+    _paintInnerRing(canvas, center, radius);
+  }
+
+  // IG-style neon rotating gradient palette
+  static const List<Color> _igColors = [
+    Color(0xFFFF512F),
+    Color(0xFFDD2476),
+    Color(0xFFFF6FD8),
+    Color(0xFFF83600),
+    Color(0xFFFE8C00),
+  ];
+
+  // Dynamic radial flowing sweep gradient
+  Paint _petalPaint(Offset center, double radius) {
+    return Paint()
+      ..strokeWidth = config.thickness * 0.9
+      ..style = PaintingStyle.stroke
+      ..strokeCap = StrokeCap.round
+      ..shader = SweepGradient(
+        colors: _igColors,
+        startAngle: rotation, // this rotates the gradient!
+        endAngle: rotation + 2 * pi, // full spin
+        tileMode: TileMode.repeated,
+      ).createShader(Rect.fromCircle(center: center, radius: radius * 1.2));
+  }
+
+  // Soft inner ring shimmer
+  void _paintInnerRing(Canvas canvas, Offset center, double radius) {
     final innerPaint = Paint()
       ..strokeWidth = config.thickness * 0.55
       ..style = PaintingStyle.stroke
@@ -1,18 +1,26 @@
+import 'dart:ui' as ui;
+
 import 'package:flutter/material.dart';
+import '../../analysis/analysis_frame.dart';
 import '../core/visualizer_base.dart';
 import '../core/visualizer_config.dart';
 
 class NeonBarsVisualizer extends AudioVisualizerWidget {
+  /// Native bar buffers (`GeometryLayout.bars` set to this widget's size);
+  /// when given, [bins] is not laid out in Dart.
+  final FrameGeometry? geometry;
+
   const NeonBarsVisualizer({
     super.key,
     required super.bins,
     required super.config,
+    this.geometry,
   });
 
   @override
   Widget build(_) {
     return CustomPaint(
-      painter: _HologramBarsPainter(bins, config),
+      painter: _HologramBarsPainter(bins, config, geometry),
       size: Size.infinite,
     );
   }
@@ -21,11 +29,18 @@ class NeonBarsVisualizer extends AudioVisualizerWidget {
 class _HologramBarsPainter extends CustomPainter {
   final List<double> bins;
   final VisualizerConfig config;
+  final FrameGeometry? geometry;
 
-  _HologramBarsPainter(this.bins, this.config);
+  _HologramBarsPainter(this.bins, this.config, this.geometry);
 
   @override
   void paint(Canvas canvas, Size size) {
+    final geometry = this.geometry;
+    if (geometry != null && geometry.triangles != null) {
+      _paintGeometry(canvas, size, geometry);
+      return;
+    }
+
     final pad = 20.0;
 
     // Reduce bar count to 12
@@ -77,6 +92,41 @@ class _HologramBarsPainter extends CustomPainter {
     }
   }
 
+  // Same look from the native buffers: one gradient over the whole height
+  // instead of one per bar, so every bar is a single draw call in total.
+  void _paintGeometry(Canvas canvas, Size size, FrameGeometry geometry) {
+    final fillPaint = Paint()..color = Colors.white.withValues(alpha: 0.07);
+    canvas.drawVertices(
+      ui.Vertices.raw(ui.VertexMode.triangles, geometry.triangles!),
+      BlendMode.dst,
+      fillPaint,
+    );
+
+    final gradient = LinearGradient(
+      colors: config.colors,
+      begin: Alignment.topCenter,
+      end: Alignment.bottomCenter,
+    ).createShader(Offset.zero & size);
+
+    final lines = geometry.lines;
+    if (lines != null) {
+      final borderPaint = Paint()
+        ..strokeWidth = 3
+        ..strokeCap = StrokeCap.round
+        ..shader = gradient;
+      canvas.drawRawPoints(ui.PointMode.lines, lines, borderPaint);
+    }
+
+    final caps = geometry.caps;
+    if (caps != null) {
+      canvas.drawVertices(
+        ui.Vertices.raw(ui.VertexMode.triangles, caps),
+        BlendMode.dst,
+        Paint()..shader = gradient,
+      );
+    }
+  }
+
   @override
   bool shouldRepaint(_) => true;
 }
@@ -0,0 +1,214 @@
+#include "analysis_graph.h"
+
+#include <algorithm>
+
+const char *const AnalysisGraph::kInput = "input";
+
+GraphStage::GraphStage(std::string name, std::vector<std::string> inputs, std::vector<std::string> outputs)
+    : name_(std::move(name)),
+      inputs_(std::move(inputs)),
+      outputs_(std::move(outputs))
+{
+}
+
+GraphStage::~GraphStage() = default;
+
+void GraphStage::Prepare(const GraphFormat &, const std::vector<GraphSignal *> &)
+{
+}
+
+bool GraphStage::Advance(const std::vector<GraphSignal *> &)
+{
+    return false;
+}
+
+AnalysisGraph::AnalysisGraph() = default;
+
+AnalysisGraph::~AnalysisGraph() = default;
+
+void AnalysisGraph::Add(std::unique_ptr<GraphStage> stage)
+{
+    stages_.push_back(std::move(stage));
+}
+
+void AnalysisGraph::Clear()
+{
+    order_.clear();
+    signals_.clear();
+    stages_.clear();
+}
+
+bool AnalysisGraph::Build(const std::vector<std::string> &requested, const GraphFormat &format, std::string &error)
+{
+    order_.clear();
+    signals_.clear();
+
+    std::map<std::string, size_t> byName;
+    std::map<std::string, size_t> producers;
+    for (size_t i = 0; i < stages_.size(); ++i)
+    {
+        byName.emplace(stages_[i]->name(), i);
+        for (const std::string &output : stages_[i]->outputs())
+            producers.emplace(output, i);
+    }
+
+    // depth-first post-order: a stage is placed after all its producers
+    enum Mark
+    {
+        kUnvisited,
+        kVisiting,
+        kPlaced
+    };
+    std::vector<Mark> marks(stages_.size(), kUnvisited);
+    std::vector<size_t> placed;
+
+    // explicit stack of (stage, next input to resolve) to avoid recursion
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (const std::string &name : requested)
+    {
+        auto it = byName.find(name);
+        if (it == byName.end())
+        {
+            error = "unknown stage '" + name + "'";
+            return false;
+        }
+        if (marks[it->second] == kPlaced)
+            continue;
+
+        stack.emplace_back(it->second, 0);
+        marks[it->second] = kVisiting;
+        while (!stack.empty())
+        {
+            size_t current = stack.back().first;
+            size_t &next = stack.back().second;
+            const std::vector<std::string> &inputs = stages_[current]->inputs();
+            if (next == inputs.size())
+            {
+                marks[current] = kPlaced;
+                placed.push_back(current);
+                stack.pop_back();
+                continue;
+            }
+
+            const std::string &input = inputs[next++];
+            if (input == kInput)
+                continue;
+            auto producer = producers.find(input);
+            if (producer == producers.end())
+            {
+                error = "no stage produces '" + input + "' for '" + stages_[current]->name() + "'";
+                return false;
+            }
+            if (marks[producer->second] == kVisiting)
+            {
+                error = "stage '" + stages_[producer->second]->name() + "' depends on itself";
+                return false;
+            }
+            if (marks[producer->second] == kUnvisited)
+            {
+                marks[producer->second] = kVisiting;
+                stack.emplace_back(producer->second, 0);
+            }
+        }
+    }
+
+    // one buffer per name; allocations happen here, not per run
+    GraphSignal *input = signalFor(kInput);
+    input->samples.reserve(static_cast<size_t>(format.maxBlockFrames) * std::max(1, format.channels));
+    for (size_t index : placed)
+    {
+        Node node{stages_[index].get(), {}, {}};
+        for (const std::string &name : node.stage->inputs())
+            node.in.push_back(signalFor(name));
+        for (const std::string &name : node.stage->outputs())
+            node.out.push_back(signalFor(name));
+        node.stage->Prepare(format, node.out);
+        order_.push_back(std::move(node));
+    }
+    return true;
+}
+
+void AnalysisGraph::Run(const float *samples, int frames, int channels)
+{
+    for (auto &entry : signals_)
+        entry.second->fresh = false;
+
+    auto it = signals_.find(kInput);
+    if (it == signals_.end())
+        return; // not built
+    GraphSignal *input = it->second.get();
+    input->samples.assign(samples, samples + static_cast<size_t>(frames) * channels);
+    input->channels = channels;
+    input->fresh = true;
+
+    runFrom(0);
+}
+
+void AnalysisGraph::runFrom(size_t first)
+{
+    for (size_t i = first; i < order_.size(); ++i)
+    {
+        Node &node = order_[i];
+        if (!node.in.empty() && !node.in[0]->fresh)
+            continue;
+        bool produced = node.stage->Process(node.in, node.out);
+        for (GraphSignal *out : node.out)
+            out->fresh = produced;
+        if (!produced)
+            continue;
+
+        // The rest of the graph takes this frame before the stage may hand
+        // out another one; each further frame replays everything after it.
+        // Only its outputs are fresh then, so stages fed by anything else
+        // (the raw block, say) do not see their input twice.
+        runFrom(i + 1);
+        while (node.stage->Advance(node.out))
+        {
+            for (auto &entry : signals_)
+                entry.second->fresh = false;
+            for (GraphSignal *out : node.out)
+                out->fresh = true;
+            runFrom(i + 1);
+        }
+        return;
+    }
+}
+
+const GraphStage *AnalysisGraph::find(const std::string &stage) const
+{
+    for (const auto &candidate : stages_)
+    {
+        if (candidate->name() == stage)
+            return candidate.get();
+    }
+    return nullptr;
+}
+
+bool AnalysisGraph::active(const std::string &stage) const
+{
+    return std::any_of(order_.begin(), order_.end(), [&](const Node &node)
+                       { return node.stage->name() == stage; });
+}
+
+std::vector<std::string> AnalysisGraph::order() const
+{
+    std::vector<std::string> names;
+    names.reserve(order_.size());
+    for (const Node &node : order_)
+        names.push_back(node.stage->name());
+    return names;
+}
+
+const GraphSignal *AnalysisGraph::signal(const std::string &name) const
+{
+    auto it = signals_.find(name);
+    return it == signals_.end() ? nullptr : it->second.get();
+}
+
+GraphSignal *AnalysisGraph::signalFor(const std::string &name)
+{
+    std::unique_ptr<GraphSignal> &slot = signals_[name];
+    if (!slot)
+        slot = std::make_unique<GraphSignal>();
+    return slot.get();
+}
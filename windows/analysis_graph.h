@@ -0,0 +1,112 @@
+#ifndef ANALYSIS_GRAPH_H_
+#define ANALYSIS_GRAPH_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dsp_types.h"
+
+// A named buffer passed between stages. Time-domain signals use samples
+// (interleaved by channels); spectra, bands and features use values.
+struct GraphSignal
+{
+    std::vector<float> samples;
+    int channels = 1;
+    std::vector<Real> values;
+    bool fresh = false; // written during the current run
+    int remaining = 0;  // frames still to follow in this run (catch-up)
+};
+
+// Sizes used to preallocate signals when a graph is built
+struct GraphFormat
+{
+    int channels = 2;
+    int maxBlockFrames = 4096; // largest capture packet expected
+    int fftSize = 2048;
+    int bins = 64;
+};
+
+// One processing step. A stage reads the signals named by inputs() and
+// writes the ones named by outputs(); the graph resolves the names to
+// buffers once at build time. A stage runs when its first input was
+// written in the current run (stages without inputs run every time), and
+// its outputs count as written when Process returns true. A stage that
+// holds several frames (e.g. a spectrum backlog after a stall) hands out
+// the rest through Advance; the stages after it run again for each one.
+class GraphStage
+{
+public:
+    GraphStage(std::string name, std::vector<std::string> inputs, std::vector<std::string> outputs);
+    virtual ~GraphStage();
+
+    const std::string &name() const { return name_; }
+    const std::vector<std::string> &inputs() const { return inputs_; }
+    const std::vector<std::string> &outputs() const { return outputs_; }
+
+    // called once per build, before the first Process
+    virtual void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out);
+
+    virtual bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) = 0;
+
+    // writes the next held frame to out; false when there is none
+    virtual bool Advance(const std::vector<GraphSignal *> &out);
+
+private:
+    std::string name_;
+    std::vector<std::string> inputs_;
+    std::vector<std::string> outputs_;
+};
+
+// Runs the stages needed for a requested set of outputs, in dependency
+// order, once per capture block. Every intermediate is a single buffer, so
+// a signal with several consumers (e.g. the magnitude spectrum) is
+// computed once per frame no matter how many stages read it.
+class AnalysisGraph
+{
+public:
+    // name of the raw interleaved capture block every graph starts from
+    static const char *const kInput;
+
+    AnalysisGraph();
+    ~AnalysisGraph();
+
+    // available stages; the first stage added for an output is its producer
+    void Add(std::unique_ptr<GraphStage> stage);
+    void Clear();
+
+    // Activates the requested stages plus, transitively, the producers of
+    // their inputs, orders them and allocates their signals. Returns false
+    // (with a reason in error, graph left empty) for unknown stages,
+    // inputs nobody produces and dependency cycles.
+    bool Build(const std::vector<std::string> &requested, const GraphFormat &format, std::string &error);
+
+    void Run(const float *samples, int frames, int channels);
+
+    // available stage by name (active or not), nullptr if none
+    const GraphStage *find(const std::string &stage) const;
+
+    bool active(const std::string &stage) const;
+    // active stage names in run order
+    std::vector<std::string> order() const;
+    // nullptr unless an active stage produces it
+    const GraphSignal *signal(const std::string &name) const;
+
+private:
+    struct Node
+    {
+        GraphStage *stage;
+        std::vector<GraphSignal *> in;
+        std::vector<GraphSignal *> out;
+    };
+
+    std::vector<std::unique_ptr<GraphStage>> stages_;
+    std::vector<Node> order_;
+    std::map<std::string, std::unique_ptr<GraphSignal>> signals_;
+
+    GraphSignal *signalFor(const std::string &name);
+    void runFrom(size_t first);
+};
+
+#endif // ANALYSIS_GRAPH_H_
@@ -0,0 +1,293 @@
+#include "analysis_stages.h"
+
+#include <algorithm>
+
+// ----------------------------- Downmix / split -----------------------------
+
+DownmixStage::DownmixStage()
+    : GraphStage("downmix", {AnalysisGraph::kInput}, {"mono"})
+{
+}
+
+void DownmixStage::Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out)
+{
+    out[0]->samples.reserve(static_cast<size_t>(format.maxBlockFrames));
+}
+
+bool DownmixStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const GraphSignal &input = *in[0];
+    int ch = std::max(1, input.channels);
+    int frames = static_cast<int>(input.samples.size()) / ch;
+    const float *samples = input.samples.data();
+    std::vector<float> &mono = out[0]->samples;
+
+    mono.resize(static_cast<size_t>(frames));
+    if (ch >= 2)
+    {
+        for (int i = 0; i < frames; ++i)
+            mono[i] = 0.5f * (samples[i * ch] + samples[i * ch + 1]);
+    }
+    else
+    {
+        std::copy(samples, samples + frames, mono.begin());
+    }
+    return true;
+}
+
+SplitStage::SplitStage()
+    : GraphStage("split", {AnalysisGraph::kInput}, {"left", "right"})
+{
+}
+
+void SplitStage::Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out)
+{
+    out[0]->samples.reserve(static_cast<size_t>(format.maxBlockFrames));
+    out[1]->samples.reserve(static_cast<size_t>(format.maxBlockFrames));
+}
+
+bool SplitStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const GraphSignal &input = *in[0];
+    int ch = std::max(1, input.channels);
+    int frames = static_cast<int>(input.samples.size()) / ch;
+    const float *samples = input.samples.data();
+    std::vector<float> &left = out[0]->samples;
+    std::vector<float> &right = out[1]->samples;
+
+    left.resize(static_cast<size_t>(frames));
+    right.resize(static_cast<size_t>(frames));
+    int rightOffset = ch >= 2 ? 1 : 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        left[i] = samples[i * ch];
+        right[i] = samples[i * ch + rightOffset];
+    }
+    return true;
+}
+
+// ----------------------------- Decimation -----------------------------
+
+DecimateStage::DecimateStage(const char *name, const char *input, const char *output, PolyphaseDecimator &decimator)
+    : GraphStage(name, {input}, {output}),
+      decimator_(decimator)
+{
+}
+
+void DecimateStage::Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out)
+{
+    out[0]->samples.reserve(static_cast<size_t>(format.maxBlockFrames));
+}
+
+bool DecimateStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const std::vector<float> &samples = in[0]->samples;
+    decimator_.Process(samples.data(), static_cast<int>(samples.size()), out[0]->samples);
+    return true;
+}
+
+// ----------------------------- Spectrum -----------------------------
+
+SpectrumStage::SpectrumStage(FFTProcessor &fft, bool stereo, std::function<bool()> frame_due)
+    : GraphStage("spectrum",
+                 stereo ? std::vector<std::string>{"analysis", "analysisRight"}
+                        : std::vector<std::string>{"analysis"},
+                 {"bands", "magnitudes"}),
+      fft_(fft),
+      stereo_(stereo),
+      frameDue_(std::move(frame_due))
+{
+}
+
+void SpectrumStage::Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out)
+{
+    out[0]->values.reserve(static_cast<size_t>(format.bins));
+    out[1]->values.reserve(static_cast<size_t>(format.fftSize / 2 + 1));
+}
+
+bool SpectrumStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const std::vector<float> &first = in[0]->samples;
+    if (stereo_)
+    {
+        const std::vector<float> &second = in[1]->samples;
+        int count = static_cast<int>(std::min(first.size(), second.size()));
+        fft_.PushStereoSamples(first.data(), second.data(), count);
+    }
+    else
+    {
+        fft_.PushSamples(first.data(), static_cast<int>(first.size()));
+    }
+
+    if (fft_.hop() > 0)
+        return emit(fft_.NextFrame(out[0]->values), out);
+    if (frameDue_ && !frameDue_())
+        return false;
+    return emit(fft_.GetBins(out[0]->values), out);
+}
+
+bool SpectrumStage::Advance(const std::vector<GraphSignal *> &out)
+{
+    return fft_.hop() > 0 && emit(fft_.NextFrame(out[0]->values), out);
+}
+
+bool SpectrumStage::emit(bool ready, const std::vector<GraphSignal *> &out)
+{
+    if (!ready)
+        return false;
+
+    const std::vector<Real> &mags = fft_.magnitudes();
+    out[1]->values.assign(mags.begin(), mags.end());
+    out[0]->remaining = out[1]->remaining = fft_.pending_frames();
+    return true;
+}
+
+// ----------------------------- Raw-stream meters -----------------------------
+
+LoudnessStage::LoudnessStage(LoudnessMeter &meter, std::atomic<bool> &reset)
+    : GraphStage("loudness", {AnalysisGraph::kInput}, {"loudness"}),
+      meter_(meter),
+      reset_(reset)
+{
+}
+
+void LoudnessStage::Prepare(const GraphFormat &, const std::vector<GraphSignal *> &out)
+{
+    out[0]->values.assign(4, Real(0));
+}
+
+// Measured on the raw device stream (all channels, device rate) so
+// K-weighting and true peak match BS.1770.
+bool LoudnessStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const GraphSignal &input = *in[0];
+    if (reset_.exchange(false))
+        meter_.Reset();
+    meter_.Process(input.samples.data(), static_cast<int>(input.samples.size()) / std::max(1, input.channels));
+
+    std::vector<Real> &values = out[0]->values;
+    values[0] = static_cast<Real>(meter_.momentary());
+    values[1] = static_cast<Real>(meter_.short_term());
+    values[2] = static_cast<Real>(meter_.integrated());
+    values[3] = static_cast<Real>(meter_.true_peak_db());
+    return true;
+}
+
+WaveformStage::WaveformStage(WaveformStream &waveform, const std::atomic<bool> &active)
+    : GraphStage("waveform", {AnalysisGraph::kInput}, {"waveform"}),
+      waveform_(waveform),
+      active_(active)
+{
+}
+
+bool WaveformStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &)
+{
+    if (!active_)
+        return false;
+    const GraphSignal &input = *in[0];
+    int ch = std::max(1, input.channels);
+    waveform_.Push(input.samples.data(), static_cast<int>(input.samples.size()) / ch, ch);
+    return true;
+}
+
+// ----------------------------- Spectral features -----------------------------
+
+ChromaStage::ChromaStage(ChromaExtractor &chroma)
+    : GraphStage("chroma", {"magnitudes"}, {"chroma"}),
+      chroma_(chroma)
+{
+}
+
+void ChromaStage::Prepare(const GraphFormat &, const std::vector<GraphSignal *> &out)
+{
+    out[0]->values.reserve(12);
+}
+
+bool ChromaStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const std::vector<Real> &mags = in[0]->values;
+    chroma_.Process(mags.data(), static_cast<int>(mags.size()));
+    const std::vector<Real> &classes = chroma_.chroma();
+    out[0]->values.assign(classes.begin(), classes.end());
+    return true;
+}
+
+PeaksStage::PeaksStage(PeakTracker &peaks)
+    : GraphStage("peaks", {"magnitudes"}, {"peaks"}),
+      peaks_(peaks)
+{
+}
+
+bool PeaksStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &)
+{
+    const std::vector<Real> &mags = in[0]->values;
+    peaks_.Process(mags.data(), static_cast<int>(mags.size()));
+    return true;
+}
+
+HpssStage::HpssStage(HarmonicPercussive &hpss, FFTProcessor &fft)
+    : GraphStage("hpss", {"magnitudes"}, {"harmonic", "percussive"}),
+      hpss_(hpss),
+      fft_(fft)
+{
+}
+
+void HpssStage::Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out)
+{
+    out[0]->values.reserve(static_cast<size_t>(format.bins));
+    out[1]->values.reserve(static_cast<size_t>(format.bins));
+}
+
+bool HpssStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    const std::vector<Real> &mags = in[0]->values;
+    hpss_.Process(mags.data(), static_cast<int>(mags.size()));
+    fft_.MapSpectrum(hpss_.harmonic(), out[0]->values);
+    fft_.MapSpectrum(hpss_.percussive(), out[1]->values);
+    return true;
+}
+
+// ----------------------------- History -----------------------------
+
+HistoryStage::HistoryStage(SpectrogramHistory &history, std::mutex &mutex)
+    : GraphStage("history", {"bands"}, {"historyRow"}),
+      history_(history),
+      mutex_(mutex)
+{
+}
+
+bool HistoryStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &)
+{
+    if (!history_.enabled())
+        return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_.Append(in[0]->values);
+    return true;
+}
+
+// ----------------------------- Geometry -----------------------------
+
+GeometryStage::GeometryStage(RenderGeometry &geometry)
+    : GraphStage("geometry", {"bands"}, {"geometry"}),
+      geometry_(geometry)
+{
+}
+
+bool GeometryStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &)
+{
+    return geometry_.Build(in[0]->values);
+}
+
+// ----------------------------- Callback -----------------------------
+
+CallbackStage::CallbackStage(std::string name, std::vector<std::string> inputs, std::vector<std::string> outputs,
+                             Callback callback)
+    : GraphStage(std::move(name), std::move(inputs), std::move(outputs)),
+      callback_(std::move(callback))
+{
+}
+
+bool CallbackStage::Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out)
+{
+    return callback_(in, out);
+}
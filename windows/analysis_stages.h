@@ -0,0 +1,181 @@
+#ifndef ANALYSIS_STAGES_H_
+#define ANALYSIS_STAGES_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "analysis_graph.h"
+#include "chroma_extractor.h"
+#include "fft_processor.h"
+#include "harmonic_percussive.h"
+#include "loudness_meter.h"
+#include "peak_tracker.h"
+#include "polyphase_decimator.h"
+#include "render_geometry.h"
+#include "spectrogram_history.h"
+#include "waveform_stream.h"
+
+// Graph stages over the plugin's analysis components. Stages only borrow
+// the components: configuration (device format, quality mode) stays with
+// their owner, so rebuilding a graph never resets analysis state.
+//
+// Signals:
+//   input                raw interleaved capture block (device rate)
+//   mono | left, right   first two channels, downmixed or split
+//   analysis[Right]      decimated to the analysis rate
+//   magnitudes           |X[k]| of the newest frame, shared by every
+//                        spectral feature
+//   bands                mapped and scaled bands (frame rate); temporal
+//                        smoothing is left to Dart (SmoothFilter)
+//   loudness             momentary, short-term, integrated, true peak
+//   chroma, harmonic, percussive, peaks, historyRow, waveform, geometry
+
+// input -> mono: average of the first two channels
+class DownmixStage : public GraphStage
+{
+public:
+    DownmixStage();
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+};
+
+// input -> left, right (mono devices feed both)
+class SplitStage : public GraphStage
+{
+public:
+    SplitStage();
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+};
+
+class DecimateStage : public GraphStage
+{
+public:
+    DecimateStage(const char *name, const char *input, const char *output, PolyphaseDecimator &decimator);
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    PolyphaseDecimator &decimator_;
+};
+
+// analysis[, analysisRight] -> bands, magnitudes. Samples are pushed every
+// block. Without a hop the newest window is taken while frame_due allows it
+// (governor pacing); in hop mode every due frame is emitted, oldest first,
+// and "remaining" says how many of the block's frames are still to come.
+class SpectrumStage : public GraphStage
+{
+public:
+    SpectrumStage(FFTProcessor &fft, bool stereo, std::function<bool()> frame_due);
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+    bool Advance(const std::vector<GraphSignal *> &out) override;
+
+private:
+    FFTProcessor &fft_;
+    bool stereo_;
+    std::function<bool()> frameDue_;
+
+    bool emit(bool ready, const std::vector<GraphSignal *> &out);
+};
+
+class LoudnessStage : public GraphStage
+{
+public:
+    LoudnessStage(LoudnessMeter &meter, std::atomic<bool> &reset);
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    LoudnessMeter &meter_;
+    std::atomic<bool> &reset_;
+};
+
+// feeds the waveform reducer while someone listens; built at frame rate
+// by the publisher
+class WaveformStage : public GraphStage
+{
+public:
+    WaveformStage(WaveformStream &waveform, const std::atomic<bool> &active);
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    WaveformStream &waveform_;
+    const std::atomic<bool> &active_;
+};
+
+class ChromaStage : public GraphStage
+{
+public:
+    explicit ChromaStage(ChromaExtractor &chroma);
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    ChromaExtractor &chroma_;
+};
+
+// "peaks" only marks a new set; ids and ages stay on the tracker
+class PeaksStage : public GraphStage
+{
+public:
+    explicit PeaksStage(PeakTracker &peaks);
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    PeakTracker &peaks_;
+};
+
+// magnitudes -> harmonic, percussive, mapped onto the same bands as "bands"
+class HpssStage : public GraphStage
+{
+public:
+    HpssStage(HarmonicPercussive &hpss, FFTProcessor &fft);
+    void Prepare(const GraphFormat &format, const std::vector<GraphSignal *> &out) override;
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    HarmonicPercussive &hpss_;
+    FFTProcessor &fft_;
+};
+
+// appends bands to the history ring; "historyRow" marks the new row
+class HistoryStage : public GraphStage
+{
+public:
+    HistoryStage(SpectrogramHistory &history, std::mutex &mutex);
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    SpectrogramHistory &history_;
+    std::mutex &mutex_;
+};
+
+// bands -> "geometry" marks new draw buffers on the builder; nothing is
+// built until a viewport is configured
+class GeometryStage : public GraphStage
+{
+public:
+    explicit GeometryStage(RenderGeometry &geometry);
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    RenderGeometry &geometry_;
+};
+
+// Adapter for sinks that live with their owner (e.g. publishing to Dart)
+class CallbackStage : public GraphStage
+{
+public:
+    using Callback = std::function<bool(const std::vector<GraphSignal *> &, const std::vector<GraphSignal *> &)>;
+
+    CallbackStage(std::string name, std::vector<std::string> inputs, std::vector<std::string> outputs,
+                  Callback callback);
+    bool Process(const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &out) override;
+
+private:
+    Callback callback_;
+};
+
+#endif // ANALYSIS_STAGES_H_
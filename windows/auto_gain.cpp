@@ -0,0 +1,24 @@
+#include "auto_gain.h"
+
+#include <algorithm>
+
+AutoGain::AutoGain(double percentile, double step_db)
+    : percentile_(std::clamp(percentile, 0.5, 0.999)),
+      step_(std::max(0.01, step_db)),
+      level_(-30.0)
+{
+}
+
+void AutoGain::Reset(double level_db)
+{
+    level_ = level_db;
+}
+
+double AutoGain::Update(double level_db)
+{
+    if (level_db > level_)
+        level_ += step_ * percentile_;
+    else
+        level_ -= step_ * (1.0 - percentile_);
+    return level_;
+}
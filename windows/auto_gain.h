@@ -0,0 +1,27 @@
+#ifndef AUTO_GAIN_H_
+#define AUTO_GAIN_H_
+
+// Slow auto-gain. Tracks a running percentile of per-frame levels (dB) with
+// an O(1) stochastic quantile update: the estimate moves up by step*p when a
+// frame is above it and down by step*(1-p) when below, so it settles where a
+// fraction p of frames fall below. With p near 1 it attacks quickly and
+// releases slowly, which keeps normalization stable across frames.
+class AutoGain
+{
+public:
+    explicit AutoGain(double percentile = 0.95, double step_db = 0.5);
+
+    void Reset(double level_db);
+
+    // feed one frame level; returns the tracked percentile
+    double Update(double level_db);
+
+    double level() const { return level_; }
+
+private:
+    double percentile_;
+    double step_;
+    double level_;
+};
+
+#endif // AUTO_GAIN_H_
@@ -0,0 +1,191 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "batch_fft.h"
+
+#include <utility>
+
+#if !defined(SAV_DSP_DOUBLE) && (defined(_M_X64) || defined(__SSE2__))
+#include <xmmintrin.h>
+#define SAV_BATCH_SSE 1
+#endif
+
+namespace
+{
+    const int kLanes = BatchFFT::kLanes;
+
+#ifdef SAV_BATCH_SSE
+    static_assert(BatchFFT::kLanes == 4, "one __m128 per interleaved point");
+
+    using Vec = __m128;
+    inline Vec load(const Real *p) { return _mm_loadu_ps(p); }
+    inline void store(Real *p, Vec v) { _mm_storeu_ps(p, v); }
+    inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+#else
+    // portable lanes; simple enough for the compiler to vectorize
+    struct Vec
+    {
+        Real v[BatchFFT::kLanes];
+    };
+    inline Vec load(const Real *p)
+    {
+        Vec r;
+        for (int l = 0; l < kLanes; ++l)
+            r.v[l] = p[l];
+        return r;
+    }
+    inline void store(Real *p, const Vec &a)
+    {
+        for (int l = 0; l < kLanes; ++l)
+            p[l] = a.v[l];
+    }
+    inline Vec add(const Vec &a, const Vec &b)
+    {
+        Vec r;
+        for (int l = 0; l < kLanes; ++l)
+            r.v[l] = a.v[l] + b.v[l];
+        return r;
+    }
+    inline Vec sub(const Vec &a, const Vec &b)
+    {
+        Vec r;
+        for (int l = 0; l < kLanes; ++l)
+            r.v[l] = a.v[l] - b.v[l];
+        return r;
+    }
+    inline Vec mul(const Vec &a, const Vec &b)
+    {
+        Vec r;
+        for (int l = 0; l < kLanes; ++l)
+            r.v[l] = a.v[l] * b.v[l];
+        return r;
+    }
+#endif
+
+    inline void swapPoints(Real *x, int i, int j)
+    {
+        for (int l = 0; l < kLanes; ++l)
+            std::swap(x[i * kLanes + l], x[j * kLanes + l]);
+    }
+}
+
+BatchFFT::BatchFFT() : n_(0) {}
+
+bool BatchFFT::Plan(int n)
+{
+    n_ = 0;
+    rev_.clear();
+    tw_.clear();
+
+    if (n < 4 || (n & (n - 1)) != 0)
+        return false;
+
+    int bits = 0;
+    while ((1 << bits) < n)
+        ++bits;
+    rev_.assign(n, 0);
+    for (int i = 1; i < n; ++i)
+        rev_[i] = (rev_[i >> 1] >> 1) | ((i & 1) << (bits - 1));
+
+    // evaluated in double and rounded once, like the single-frame tables
+    tw_.resize(static_cast<size_t>(n) * kLanes);
+    for (int k = 0; k < n / 2; ++k)
+    {
+        double angle = -2.0 * M_PI * k / n;
+        for (int l = 0; l < kLanes; ++l)
+        {
+            tw_[2 * kLanes * k + l] = static_cast<Real>(cos(angle));
+            tw_[2 * kLanes * k + kLanes + l] = static_cast<Real>(sin(angle));
+        }
+    }
+
+    n_ = n;
+    return true;
+}
+
+void BatchFFT::Transform(Real *re, Real *im) const
+{
+    int n = n_;
+    if (n == 0)
+        return;
+
+    for (int i = 0; i < n; ++i)
+    {
+        int j = rev_[i];
+        if (i < j)
+        {
+            swapPoints(re, i, j);
+            swapPoints(im, i, j);
+        }
+    }
+
+    // Two radix-2 DIT stages (len = 2M, then 4M) per pass over the data,
+    // as in the single-frame kernels, with a trailing radix-2 stage for odd
+    // log2(n). Twiddles are stored pre-broadcast, one copy per lane.
+    int m = 1;
+    for (; 4 * m <= n; m *= 4)
+    {
+        int s1 = n / (2 * m);
+        int s2 = n / (4 * m);
+        for (int i = 0; i < n; i += 4 * m)
+        {
+            for (int j = 0; j < m; ++j)
+            {
+                const Real *t1 = tw_.data() + 2 * kLanes * (j * s1);
+                const Real *t2 = tw_.data() + 2 * kLanes * (j * s2);
+                Vec w1r = load(t1), w1i = load(t1 + kLanes);
+                Vec w2r = load(t2), w2i = load(t2 + kLanes);
+
+                Real *pa = re + (i + j) * kLanes, *qa = im + (i + j) * kLanes;
+                Real *pb = pa + m * kLanes, *qb = qa + m * kLanes;
+                Real *pc = pa + 2 * m * kLanes, *qc = qa + 2 * m * kLanes;
+                Real *pe = pa + 3 * m * kLanes, *qe = qa + 3 * m * kLanes;
+
+                // stage len = 2M
+                Vec ar = load(pa), ai = load(qa);
+                Vec br = load(pb), bi = load(qb);
+                Vec cr = load(pc), ci = load(qc);
+                Vec er = load(pe), ei = load(qe);
+                Vec tbr = sub(mul(br, w1r), mul(bi, w1i)), tbi = add(mul(br, w1i), mul(bi, w1r));
+                Vec ter = sub(mul(er, w1r), mul(ei, w1i)), tei = add(mul(er, w1i), mul(ei, w1r));
+                Vec a1r = add(ar, tbr), a1i = add(ai, tbi);
+                Vec b1r = sub(ar, tbr), b1i = sub(ai, tbi);
+                Vec c1r = add(cr, ter), c1i = add(ci, tei);
+                Vec d1r = sub(cr, ter), d1i = sub(ci, tei);
+
+                // stage len = 4M; the odd half uses W^(j+M) = W^j * -i
+                Vec tcr = sub(mul(c1r, w2r), mul(c1i, w2i)), tci = add(mul(c1r, w2i), mul(c1i, w2r));
+                Vec tdr = sub(mul(d1r, w2r), mul(d1i, w2i)), tdi = add(mul(d1r, w2i), mul(d1i, w2r));
+                store(pa, add(a1r, tcr));
+                store(qa, add(a1i, tci));
+                store(pc, sub(a1r, tcr));
+                store(qc, sub(a1i, tci));
+                store(pb, add(b1r, tdi));
+                store(qb, sub(b1i, tdr));
+                store(pe, sub(b1r, tdi));
+                store(qe, add(b1i, tdr));
+            }
+        }
+    }
+
+    if (2 * m <= n)
+    {
+        int stride = n / (2 * m);
+        for (int j = 0; j < m; ++j)
+        {
+            const Real *t = tw_.data() + 2 * kLanes * (j * stride);
+            Vec wr = load(t), wi = load(t + kLanes);
+            Real *pa = re + j * kLanes, *qa = im + j * kLanes;
+            Real *pb = pa + m * kLanes, *qb = qa + m * kLanes;
+            Vec xr = load(pb), xi = load(qb);
+            Vec vr = sub(mul(xr, wr), mul(xi, wi));
+            Vec vi = add(mul(xr, wi), mul(xi, wr));
+            Vec ur = load(pa), ui = load(qa);
+            store(pa, add(ur, vr));
+            store(qa, add(ui, vi));
+            store(pb, sub(ur, vr));
+            store(qb, sub(ui, vi));
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef BATCH_FFT_H_
+#define BATCH_FFT_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+
+// Forward FFT of kLanes equal-size frames at once, for catching up on a
+// backlog of hop frames. The frames are interleaved point by point in split
+// real/imaginary arrays (re[i * kLanes + lane]), so every butterfly works on
+// one SIMD register per operand: the vector lanes span frames, and no
+// shuffles are needed at any stage. Power-of-two sizes only.
+class BatchFFT
+{
+public:
+    static const int kLanes = 4;
+
+    BatchFFT();
+
+    // returns false (and leaves the plan empty) unless n is a power of two >= 4
+    bool Plan(int n);
+    int size() const { return n_; }
+
+    // in-place forward transform of kLanes interleaved frames of size() points
+    void Transform(Real *re, Real *im) const;
+
+private:
+    int n_;
+    std::vector<int> rev_; // bit-reversed index of every point
+    // e^{-2*pi*i*k/N}, k < N/2: kLanes copies of the real part, then of
+    // the imaginary part
+    std::vector<Real> tw_;
+};
+
+#endif // BATCH_FFT_H_
@@ -0,0 +1,191 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "chroma_extractor.h"
+
+#include <algorithm>
+
+namespace
+{
+    const int kClasses = 12;
+    const double kMinHz = 65.0;   // ~C2
+    const double kMaxHz = 4200.0; // ~C8
+    // bins wider than this many semitones carry no pitch information
+    const double kMaxSpanSemitones = 3.0;
+
+    // tuning peaks come from bins fine enough for sub-semitone precision
+    const double kTuningMinHz = 200.0;
+    const double kTuningMaxHz = 4000.0;
+    const double kTuningSmoothing = 0.95;
+    const double kTuningRebuild = 0.05; // semitones
+    const Real kPeakThreshold = Real(0.05);
+
+    const Real kChromaSmoothing = Real(0.7);
+
+    // fractional MIDI note of a frequency (A4 = 69)
+    double pitchOf(double hz) { return 69.0 + 12.0 * log2(hz / 440.0); }
+}
+
+ChromaExtractor::ChromaExtractor()
+    : sampleRate_(48000),
+      binCount_(0),
+      builtTuning_(0.0),
+      peakLo_(0),
+      peakHi_(0),
+      tuningRe_(1.0),
+      tuningIm_(0.0),
+      tuningCents_(0.0),
+      chroma_(kClasses, Real(0)),
+      pitchClass_(-1)
+{
+}
+
+void ChromaExtractor::Configure(int sample_rate)
+{
+    sampleRate_ = std::max(1, sample_rate);
+    binCount_ = 0; // rebuilt on the next frame
+    tuningRe_ = 1.0;
+    tuningIm_ = 0.0;
+    tuningCents_ = 0.0;
+    std::fill(chroma_.begin(), chroma_.end(), Real(0));
+    pitchClass_ = -1;
+}
+
+// Each bin covers pitches [p(k - 1/2), p(k + 1/2)); it is shared between the
+// semitones it overlaps in proportion to the overlap, so narrow high bins
+// split between neighbours and wide low bins spread over up to three.
+void ChromaExtractor::buildMatrix(double tuning)
+{
+    builtTuning_ = tuning;
+    double hzPerBin = static_cast<double>(sampleRate_) / (2.0 * binCount_);
+
+    int lo = std::max(1, static_cast<int>(ceil(kMinHz / hzPerBin)));
+    int hi = std::min(binCount_ - 1, static_cast<int>(kMaxHz / hzPerBin));
+
+    // entries are generated in bin order, then bucketed by row
+    std::vector<int> rows;
+    std::vector<int> cols;
+    std::vector<Real> values;
+    for (int k = lo; k <= hi; ++k)
+    {
+        double p0 = pitchOf((k - 0.5) * hzPerBin) - tuning;
+        double p1 = pitchOf((k + 0.5) * hzPerBin) - tuning;
+        double span = p1 - p0;
+        if (span > kMaxSpanSemitones)
+            continue;
+
+        for (int n = static_cast<int>(floor(p0 + 0.5)); n - 0.5 < p1; ++n)
+        {
+            double overlap = std::min(p1, n + 0.5) - std::max(p0, n - 0.5);
+            if (overlap <= 0.0)
+                continue;
+            rows.push_back(((n % kClasses) + kClasses) % kClasses);
+            cols.push_back(k);
+            values.push_back(static_cast<Real>(overlap / span));
+        }
+    }
+
+    rowStart_.assign(kClasses + 1, 0);
+    for (int r : rows)
+        rowStart_[r + 1]++;
+    for (int c = 0; c < kClasses; ++c)
+        rowStart_[c + 1] += rowStart_[c];
+
+    std::vector<int> fill(rowStart_.begin(), rowStart_.end() - 1);
+    column_.assign(rows.size(), 0);
+    weight_.assign(rows.size(), Real(0));
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        int slot = fill[rows[i]]++;
+        column_[slot] = cols[i];
+        weight_[slot] = values[i];
+    }
+}
+
+void ChromaExtractor::Process(const Real *mags, int bin_count)
+{
+    if (bin_count != binCount_)
+    {
+        binCount_ = bin_count;
+        double hzPerBin = static_cast<double>(sampleRate_) / (2.0 * binCount_);
+        peakLo_ = std::max(2, static_cast<int>(ceil(kTuningMinHz / hzPerBin)));
+        peakHi_ = std::min(binCount_ - 2, static_cast<int>(kTuningMaxHz / hzPerBin));
+        buildMatrix(tuningCents_ / 100.0);
+    }
+
+    trackTuning(mags);
+
+    // one sparse mat-vec: chroma[c] = sum_j W[c, j] * |X[j]|
+    Real frame[kClasses];
+    Real peak = 0;
+    for (int c = 0; c < kClasses; ++c)
+    {
+        Real sum = 0;
+        for (int i = rowStart_[c]; i < rowStart_[c + 1]; ++i)
+            sum += weight_[i] * mags[column_[i]];
+        frame[c] = sum;
+        peak = std::max(peak, sum);
+    }
+
+    Real norm = peak > Real(1e-9) ? Real(1) / peak : Real(0);
+    Real best = 0;
+    pitchClass_ = -1;
+    for (int c = 0; c < kClasses; ++c)
+    {
+        chroma_[c] = kChromaSmoothing * chroma_[c] + (Real(1) - kChromaSmoothing) * frame[c] * norm;
+        if (chroma_[c] > best)
+        {
+            best = chroma_[c];
+            pitchClass_ = c;
+        }
+    }
+}
+
+// Peaks are refined with a parabola through the log magnitudes; their
+// deviation from the nearest semitone is averaged as a unit vector so that
+// +49 and -49 cents do not cancel into 0.
+void ChromaExtractor::trackTuning(const Real *mags)
+{
+    if (peakHi_ <= peakLo_)
+        return;
+
+    Real maxMag = 0;
+    for (int k = peakLo_; k <= peakHi_; ++k)
+        maxMag = std::max(maxMag, mags[k]);
+    if (maxMag <= Real(1e-9))
+        return;
+
+    double hzPerBin = static_cast<double>(sampleRate_) / (2.0 * binCount_);
+    Real threshold = kPeakThreshold * maxMag;
+    double re = 0.0;
+    double im = 0.0;
+    double total = 0.0;
+
+    for (int k = peakLo_; k <= peakHi_; ++k)
+    {
+        Real m = mags[k];
+        if (m < threshold || m <= mags[k - 1] || m < mags[k + 1])
+            continue;
+
+        double a = log(mags[k - 1] + 1e-12);
+        double b = log(m + 1e-12);
+        double c = log(mags[k + 1] + 1e-12);
+        double denom = a - 2.0 * b + c;
+        double offset = denom < 0.0 ? 0.5 * (a - c) / denom : 0.0;
+
+        double pitch = pitchOf((k + offset) * hzPerBin);
+        double deviation = pitch - floor(pitch + 0.5);
+        re += m * cos(2.0 * M_PI * deviation);
+        im += m * sin(2.0 * M_PI * deviation);
+        total += m;
+    }
+    if (total <= 0.0)
+        return;
+
+    tuningRe_ = kTuningSmoothing * tuningRe_ + (1.0 - kTuningSmoothing) * re / total;
+    tuningIm_ = kTuningSmoothing * tuningIm_ + (1.0 - kTuningSmoothing) * im / total;
+    double tuning = atan2(tuningIm_, tuningRe_) / (2.0 * M_PI);
+    tuningCents_ = 100.0 * tuning;
+
+    if (std::fabs(tuning - builtTuning_) > kTuningRebuild)
+        buildMatrix(tuning);
+}
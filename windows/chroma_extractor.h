@@ -0,0 +1,57 @@
+#ifndef CHROMA_EXTRACTOR_H_
+#define CHROMA_EXTRACTOR_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+
+// Folds the FFT magnitude spectrum into 12 pitch classes (C = 0). The bin ->
+// pitch-class weights live in a sparse CSR matrix built once per (size,
+// rate, tuning), so a frame costs one sparse mat-vec over the bins already
+// computed by the FFT. Tuning is tracked from the deviation of spectral
+// peaks against the equal-tempered grid (A4 = 440 Hz), and the matrix is
+// rebuilt when the estimate drifts by more than a few cents.
+class ChromaExtractor
+{
+public:
+    ChromaExtractor();
+
+    // analysis rate of the spectrum passed to Process
+    void Configure(int sample_rate);
+
+    // mags = |X[k]| for k < bin_count (N/2); rebuilds on a size change
+    void Process(const Real *mags, int bin_count);
+
+    // 0..1, normalized to the strongest class, smoothed across frames
+    const std::vector<Real> &chroma() const { return chroma_; }
+
+    // strongest pitch class, or -1 when silent
+    int pitch_class() const { return pitchClass_; }
+
+    // estimated reference offset from A4 = 440 Hz, -50..50 cents
+    double tuning_cents() const { return tuningCents_; }
+
+private:
+    int sampleRate_;
+    int binCount_;
+
+    // CSR: 12 rows (pitch classes), columns are FFT bins
+    std::vector<int> rowStart_;
+    std::vector<int> column_;
+    std::vector<Real> weight_;
+    double builtTuning_; // semitones the matrix was built for
+
+    int peakLo_; // bin range searched for tuning peaks
+    int peakHi_;
+    double tuningRe_; // smoothed unit vector of peak deviations
+    double tuningIm_;
+    double tuningCents_;
+
+    std::vector<Real> chroma_;
+    int pitchClass_;
+
+    void buildMatrix(double tuning);
+    void trackTuning(const Real *mags);
+};
+
+#endif // CHROMA_EXTRACTOR_H_
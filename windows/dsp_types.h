@@ -0,0 +1,17 @@
+#ifndef DSP_TYPES_H_
+#define DSP_TYPES_H_
+
+#include <complex>
+
+// Sample type of the analysis pipeline (window, FFT, magnitudes, bands,
+// output). float32 matches the WASAPI mix format and doubles the SIMD width;
+// configure with SAV_DSP_DOUBLE=ON for the double-precision reference build.
+#ifdef SAV_DSP_DOUBLE
+using Real = double;
+#else
+using Real = float;
+#endif
+
+using Complex = std::complex<Real>;
+
+#endif // DSP_TYPES_H_
@@ -0,0 +1,126 @@
+#include "fft_kernels.h"
+
+#include <utility>
+
+using namespace fft_kernels_detail;
+
+namespace
+{
+    // Two fused radix-2 DIT stages (len = 2M then 4M) as one radix-4 pass.
+    // N and M are compile-time, so loop bounds, strides and the M = 1 unit
+    // twiddles fold away.
+    template <int N, int M>
+    inline void radix4Pass(Real *d)
+    {
+        constexpr int s1 = N / (2 * M);
+        constexpr int s2 = N / (4 * M);
+        const TwiddleTable<N> &tw = kTwiddles<N>;
+
+        for (int i = 0; i < N; i += 4 * M)
+        {
+            for (int j = 0; j < M; ++j)
+            {
+                const Real w1r = tw.re[j * s1], w1i = tw.im[j * s1];
+                const Real w2r = tw.re[j * s2], w2i = tw.im[j * s2];
+
+                Real *a = d + 2 * (i + j);
+                Real *b = a + 2 * M;
+                Real *c = a + 4 * M;
+                Real *e = a + 6 * M;
+
+                // stage len = 2M
+                const Real tbr = b[0] * w1r - b[1] * w1i, tbi = b[0] * w1i + b[1] * w1r;
+                const Real ter = e[0] * w1r - e[1] * w1i, tei = e[0] * w1i + e[1] * w1r;
+                const Real a1r = a[0] + tbr, a1i = a[1] + tbi;
+                const Real b1r = a[0] - tbr, b1i = a[1] - tbi;
+                const Real c1r = c[0] + ter, c1i = c[1] + tei;
+                const Real d1r = c[0] - ter, d1i = c[1] - tei;
+
+                // stage len = 4M; the odd half uses W^(j+M) = W^j * -i
+                const Real tcr = c1r * w2r - c1i * w2i, tci = c1r * w2i + c1i * w2r;
+                const Real tdr = d1r * w2r - d1i * w2i, tdi = d1r * w2i + d1i * w2r;
+
+                a[0] = a1r + tcr;
+                a[1] = a1i + tci;
+                c[0] = a1r - tcr;
+                c[1] = a1i - tci;
+                b[0] = b1r + tdi;
+                b[1] = b1i - tdr;
+                e[0] = b1r - tdi;
+                e[1] = b1i + tdr;
+            }
+        }
+    }
+
+    // Trailing radix-2 stage (len = 2M) for odd log2(N).
+    template <int N, int M>
+    inline void radix2Pass(Real *d)
+    {
+        constexpr int s = N / (2 * M);
+        const TwiddleTable<N> &tw = kTwiddles<N>;
+
+        for (int j = 0; j < M; ++j)
+        {
+            const Real wr = tw.re[j * s], wi = tw.im[j * s];
+            Real *a = d + 2 * j;
+            Real *b = a + 2 * M;
+            const Real tr = b[0] * wr - b[1] * wi, ti = b[0] * wi + b[1] * wr;
+            b[0] = a[0] - tr;
+            b[1] = a[1] - ti;
+            a[0] += tr;
+            a[1] += ti;
+        }
+    }
+
+    template <int N, int M>
+    inline void runPasses(Real *d)
+    {
+        if constexpr (M * 4 <= N)
+        {
+            radix4Pass<N, M>(d);
+            runPasses<N, M * 4>(d);
+        }
+        else if constexpr (M * 2 <= N)
+        {
+            radix2Pass<N, M>(d);
+        }
+    }
+
+    template <int N>
+    void fftKernel(Complex *data)
+    {
+        const std::array<uint16_t, N> &rev = kBitReverse<N>;
+        for (int i = 0; i < N; ++i)
+        {
+            int j = rev[i];
+            if (i < j)
+                std::swap(data[i], data[j]);
+        }
+
+        // std::complex<T> is layout-compatible with T[2]
+        runPasses<N, 1>(reinterpret_cast<Real *>(data));
+    }
+
+    // indexed by log2(n)
+    const FFTKernel kKernels[] = {
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+        &fftKernel<512>,
+        &fftKernel<1024>,
+        &fftKernel<2048>,
+        &fftKernel<4096>,
+    };
+}
+
+FFTKernel FindFFTKernel(int n)
+{
+    if (n <= 0 || (n & (n - 1)) != 0)
+        return nullptr;
+
+    int log2n = 0;
+    while ((1 << log2n) < n)
+        ++log2n;
+
+    if (log2n >= static_cast<int>(sizeof(kKernels) / sizeof(kKernels[0])))
+        return nullptr;
+    return kKernels[log2n];
+}
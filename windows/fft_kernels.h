@@ -0,0 +1,100 @@
+#ifndef FFT_KERNELS_H_
+#define FFT_KERNELS_H_
+
+#include <array>
+#include <cstdint>
+
+#include "dsp_types.h"
+
+// In-place forward FFT of a fixed, compile-time size.
+using FFTKernel = void (*)(Complex *data);
+
+// Specialized kernel for n (512, 1024, 2048, 4096), or nullptr when the
+// caller should use the generic path.
+FFTKernel FindFFTKernel(int n);
+
+namespace fft_kernels_detail
+{
+    constexpr double kPi = 3.14159265358979323846;
+
+    // Taylor series, accurate to double precision for |x| <= pi/4
+    constexpr double taylorCos(double x)
+    {
+        double x2 = x * x;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int k = 1; k <= 9; ++k)
+        {
+            term *= -x2 / ((2 * k - 1) * (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double taylorSin(double x)
+    {
+        double x2 = x * x;
+        double term = x;
+        double sum = x;
+        for (int k = 1; k <= 9; ++k)
+        {
+            term *= -x2 / ((2 * k) * (2 * k + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // cos(x) for x in [0, pi/2]
+    constexpr double quarterCos(double x)
+    {
+        return x <= kPi / 4 ? taylorCos(x) : taylorSin(kPi / 2 - x);
+    }
+
+    template <int N>
+    struct TwiddleTable
+    {
+        std::array<Real, N / 2> re{};
+        std::array<Real, N / 2> im{};
+    };
+
+    // e^{-2*pi*i*k/N} for k < N/2, built from one quarter-wave cosine table
+    template <int N>
+    constexpr TwiddleTable<N> makeTwiddles()
+    {
+        std::array<double, N / 4 + 1> q{};
+        for (int k = 0; k <= N / 4; ++k)
+            q[k] = quarterCos(2.0 * kPi * k / N);
+
+        TwiddleTable<N> t{};
+        for (int k = 0; k < N / 2; ++k)
+        {
+            // cos/sin of 2*pi*k/N from the quarter table
+            double c = k <= N / 4 ? q[k] : -q[N / 2 - k];
+            double s = k <= N / 4 ? q[N / 4 - k] : q[k - N / 4];
+            t.re[k] = static_cast<Real>(c);
+            t.im[k] = static_cast<Real>(-s);
+        }
+        return t;
+    }
+
+    template <int N>
+    constexpr std::array<uint16_t, N> makeBitReverse()
+    {
+        int bits = 0;
+        while ((1 << bits) < N)
+            ++bits;
+
+        std::array<uint16_t, N> rev{};
+        for (int i = 1; i < N; ++i)
+            rev[i] = static_cast<uint16_t>((rev[i >> 1] >> 1) | ((i & 1) << (bits - 1)));
+        return rev;
+    }
+
+    template <int N>
+    inline constexpr TwiddleTable<N> kTwiddles = makeTwiddles<N>();
+
+    template <int N>
+    inline constexpr std::array<uint16_t, N> kBitReverse = makeBitReverse<N>();
+}
+
+#endif // FFT_KERNELS_H_
@@ -2,25 +2,147 @@
 #include <cmath>
 #include "fft_processor.h"
 
-#include <complex>
 #include <algorithm>
 
-using Complex = std::complex<double>;
+// auto-gain keeps the tracked level this far below the ceiling
+static const double kAutoGainHeadroomDb = 6.0;
+static const double kAutoGainMaxBoostDb = 40.0;
 
 static bool isPowerOfTwo(int x) { return x > 0 && (x & (x - 1)) == 0; }
 
+static bool isSupportedSize(int x) { return x >= 16 && (isPowerOfTwo(x) || MixedRadixFFT::IsSupportedSize(x)); }
+
 FFTProcessor::FFTProcessor(int window_size, int output_bins)
     : windowSize_(window_size),
       outBinsCount_(output_bins),
       smoothingAlpha_(0.6),
+      math_(SpectrumMath::Fast),
+      windowType_(WindowType::Hann),
+      kaiserBeta_(8.6),
+      scale_(OutputScale::Normalized),
+      floorDb_(-90.0),
+      ceilingDb_(0.0),
+      autoGainEnabled_(false),
+      gainDb_(0.0),
+      stereo_(false),
+      stereoPair_(StereoPair::LeftRight),
       ringBuffer_(window_size * 2, 0.0f),
-      ringPos_(0)
+      ringPos_(0),
+      hop_(0),
+      sinceFrame_(0),
+      skippedFrames_(0),
+      batchCount_(0),
+      batchNext_(0),
+      kernel_(nullptr),
+      windowCoeffs_(nullptr),
+      lastMaxMag_(Real(1e-12))
 {
-    if (!isPowerOfTwo(windowSize_))
+    if (!isSupportedSize(windowSize_))
     {
         windowSize_ = 2048;
         ringBuffer_.assign(windowSize_ * 2, 0.0f);
     }
+    buildTables();
+}
+
+void FFTProcessor::Configure(int window_size, int output_bins)
+{
+    if (!isSupportedSize(window_size))
+        window_size = 2048;
+    if (output_bins < 1)
+        output_bins = 1;
+
+    if (window_size == windowSize_ && output_bins == outBinsCount_)
+        return;
+
+    int oldSize = static_cast<int>(ringBuffer_.size());
+    int newSize = ringCapacity(window_size);
+    resizeRing(ringBuffer_, newSize);
+    if (stereo_)
+        resizeRing(ringRight_, newSize);
+
+    ringPos_ = std::min(oldSize, newSize) % newSize;
+    windowSize_ = window_size;
+    outBinsCount_ = output_bins;
+    buildTables();
+}
+
+// two windows, or in hop mode one window plus the longest backlog
+int FFTProcessor::ringCapacity(int window_size) const
+{
+    return std::max(window_size * 2, window_size + kMaxBacklogFrames * hop_);
+}
+
+// unwrap the newest samples so they survive the resize
+void FFTProcessor::resizeRing(std::vector<float> &ring, int newSize) const
+{
+    int oldSize = static_cast<int>(ring.size());
+    int keep = std::min(oldSize, newSize);
+    std::vector<float> resized(newSize, 0.0f);
+    for (int i = 0; i < keep; ++i)
+    {
+        int idx = (ringPos_ - keep + i + oldSize) % oldSize;
+        resized[i] = ring[idx];
+    }
+    ring.swap(resized);
+}
+
+void FFTProcessor::buildTables()
+{
+    int N = windowSize_;
+    int half = N / 2;
+
+    kernel_ = FindFFTKernel(N);
+    if (isPowerOfTwo(N))
+    {
+        mixed_.Plan(0);
+        batch_.Plan(N);
+    }
+    else
+    {
+        mixed_.Plan(N);
+        batch_.Plan(0);
+    }
+    batchCount_ = 0;
+    batchNext_ = 0;
+
+    // Twiddles are evaluated in double and rounded once. The old w *= wlen
+    // recurrence drifts by ~N ulps, which is visible in float32.
+    twiddles_.resize(half);
+    for (int k = 0; k < half; ++k)
+    {
+        double angle = -2.0 * M_PI * k / N;
+        twiddles_[k] = Complex(static_cast<Real>(cos(angle)), static_cast<Real>(sin(angle)));
+    }
+
+    // log-spaced band edges over the positive bins
+    bandLo_.resize(outBinsCount_);
+    bandHi_.resize(outBinsCount_);
+    for (int b = 0; b < outBinsCount_; ++b)
+    {
+        double low = pow((double)half, (double)b / outBinsCount_);
+        double high = pow((double)half, (double)(b + 1) / outBinsCount_);
+
+        bandLo_[b] = std::max(0, static_cast<int>(floor(low)));
+        bandHi_[b] = std::min(half - 1, static_cast<int>(ceil(high)));
+    }
+
+    windowCoeffs_ = &GetWindow(windowType_, N, kaiserBeta_);
+    data_.assign(N, Complex(0, 0));
+    mags_.assign(half, Real(0));
+
+    if (stereo_)
+    {
+        specA_.assign(half, Complex(0, 0));
+        specB_.assign(half, Complex(0, 0));
+        specMono_.assign(half, Complex(0, 0));
+        magsA_.assign(half, Real(0));
+        magsB_.assign(half, Real(0));
+        stereoBands_.first.assign(outBinsCount_, Real(0));
+        stereoBands_.second.assign(outBinsCount_, Real(0));
+        stereoBands_.correlation.assign(outBinsCount_, Real(0));
+        stereoBands_.balance.assign(outBinsCount_, Real(0));
+    }
 }
 
 void FFTProcessor::SetSmoothing(double alpha)
@@ -28,6 +150,66 @@ void FFTProcessor::SetSmoothing(double alpha)
     smoothingAlpha_ = std::clamp(alpha, 0.0, 0.999);
 }
 
+void FFTProcessor::SetWindow(WindowType type, double kaiser_beta)
+{
+    windowType_ = type;
+    kaiserBeta_ = kaiser_beta;
+    windowCoeffs_ = &GetWindow(windowType_, windowSize_, kaiserBeta_);
+    batchCount_ = 0;
+    batchNext_ = 0;
+}
+
+void FFTProcessor::SetOutputScale(OutputScale scale, double floor_db, double ceiling_db, bool auto_gain)
+{
+    scale_ = scale;
+    floorDb_ = std::min(floor_db, ceiling_db - 1.0);
+    ceilingDb_ = ceiling_db;
+    autoGainEnabled_ = auto_gain && scale == OutputScale::Dbfs;
+    gainDb_ = 0.0;
+    autoGain_.Reset(ceilingDb_ - kAutoGainHeadroomDb);
+}
+
+void FFTProcessor::SetStereo(bool enabled, StereoPair pair)
+{
+    stereoPair_ = pair;
+    if (enabled == stereo_)
+        return;
+
+    stereo_ = enabled;
+    if (stereo_)
+    {
+        // until real right-channel data arrives, mirror the mono history
+        ringRight_ = ringBuffer_;
+    }
+    else
+    {
+        ringRight_.clear();
+        stereoBands_ = StereoBands();
+    }
+    buildTables();
+}
+
+void FFTProcessor::SetHop(int hop)
+{
+    hop = std::max(0, hop);
+    if (hop == hop_)
+        return;
+
+    hop_ = hop;
+    int oldSize = static_cast<int>(ringBuffer_.size());
+    int newSize = ringCapacity(windowSize_);
+    if (newSize != oldSize)
+    {
+        resizeRing(ringBuffer_, newSize);
+        if (stereo_)
+            resizeRing(ringRight_, newSize);
+        ringPos_ = std::min(oldSize, newSize) % newSize;
+    }
+    sinceFrame_ = 0;
+    batchCount_ = 0;
+    batchNext_ = 0;
+}
+
 void FFTProcessor::PushSamples(const float *samples, int sampleCount)
 {
     int bufSize = static_cast<int>(ringBuffer_.size());
@@ -36,36 +218,181 @@ void FFTProcessor::PushSamples(const float *samples, int sampleCount)
         ringBuffer_[ringPos_] = samples[i];
         ringPos_ = (ringPos_ + 1) % bufSize;
     }
+    pushed(sampleCount);
 }
 
-bool FFTProcessor::GetBins(std::vector<double> &outBins)
+void FFTProcessor::PushStereoSamples(const float *left, const float *right, int sampleCount)
+{
+    if (!stereo_)
+    {
+        SetStereo(true, stereoPair_);
+    }
+
+    int bufSize = static_cast<int>(ringBuffer_.size());
+    for (int i = 0; i < sampleCount; i++)
+    {
+        ringBuffer_[ringPos_] = left[i];
+        ringRight_[ringPos_] = right[i];
+        ringPos_ = (ringPos_ + 1) % bufSize;
+    }
+    pushed(sampleCount);
+}
+
+void FFTProcessor::pushed(int sampleCount)
+{
+    if (hop_ <= 0)
+        return;
+
+    sinceFrame_ += sampleCount;
+    int excess = sinceFrame_ / hop_ - kMaxBacklogFrames;
+    if (excess > 0)
+    {
+        // the ring no longer holds these windows
+        skippedFrames_ += excess;
+        sinceFrame_ -= excess * hop_;
+        batchCount_ = 0;
+        batchNext_ = 0;
+    }
+}
+
+bool FFTProcessor::GetBins(std::vector<Real> &outBins)
 {
     int bufSize = static_cast<int>(ringBuffer_.size());
     if (bufSize < windowSize_)
         return false;
 
-    std::vector<float> window(windowSize_);
+    loadWindow(0);
+    computeFFT();
+    finishFrame(outBins);
+    return true;
+}
 
-    int start = (ringPos_ - windowSize_ + bufSize) % bufSize;
-    for (int i = 0; i < windowSize_; ++i)
+bool FFTProcessor::NextFrame(std::vector<Real> &outBins)
+{
+    if (pending_frames() == 0)
+        return false;
+
+    if (batchNext_ >= batchCount_)
+        transformBacklog();
+
+    if (batchNext_ < batchCount_)
+    {
+        const int lanes = BatchFFT::kLanes;
+        int lane = batchNext_++;
+        for (int i = 0; i < windowSize_; ++i)
+            data_[i] = Complex(batchRe_[i * lanes + lane], batchIm_[i * lanes + lane]);
+    }
+    else
     {
-        int idx = (start + i) % bufSize;
-        window[i] = ringBuffer_[idx];
+        loadWindow(sinceFrame_ - hop_);
+        computeFFT();
     }
 
-    applyHannWindow(window);
-    computeFFT(window, outBins);
+    sinceFrame_ -= hop_;
+    finishFrame(outBins);
     return true;
 }
 
-void FFTProcessor::applyHannWindow(std::vector<float> &data)
+// Transforms the next (up to) kLanes due frames together. A lone frame, or
+// a size without a batch plan, is left to the single-frame kernels.
+void FFTProcessor::transformBacklog()
+{
+    const int lanes = BatchFFT::kLanes;
+    int count = std::min(lanes, pending_frames());
+    batchCount_ = 0;
+    batchNext_ = 0;
+    if (count < 2 || batch_.size() != windowSize_)
+        return;
+
+    int N = windowSize_;
+    batchRe_.assign(static_cast<size_t>(N) * lanes, Real(0));
+    batchIm_.assign(static_cast<size_t>(N) * lanes, Real(0));
+    for (int lane = 0; lane < count; ++lane)
+    {
+        // due frame `lane` ends this many samples before the write position
+        loadWindow(sinceFrame_ - (lane + 1) * hop_);
+        for (int i = 0; i < N; ++i)
+        {
+            batchRe_[i * lanes + lane] = data_[i].real();
+            batchIm_[i * lanes + lane] = data_[i].imag();
+        }
+    }
+
+    batch_.Transform(batchRe_.data(), batchIm_.data());
+    batchCount_ = count;
+}
+
+// Windows the N samples ending `back` samples before the write position
+// into data_, unwrapping the ring in (at most) two contiguous runs. Stereo
+// packs the right channel into the imaginary part.
+void FFTProcessor::loadWindow(int back)
+{
+    int bufSize = static_cast<int>(ringBuffer_.size());
+    const Real *w = windowCoeffs_->data();
+    int start = ((ringPos_ - back - windowSize_) % bufSize + bufSize) % bufSize;
+    int first = std::min(windowSize_, bufSize - start);
+    if (stereo_)
+    {
+        for (int i = 0; i < first; ++i)
+            data_[i] = Complex(ringBuffer_[start + i] * w[i], ringRight_[start + i] * w[i]);
+        for (int i = first; i < windowSize_; ++i)
+            data_[i] = Complex(ringBuffer_[i - first] * w[i], ringRight_[i - first] * w[i]);
+    }
+    else
+    {
+        for (int i = 0; i < first; ++i)
+            data_[i] = Complex(ringBuffer_[start + i] * w[i], Real(0));
+        for (int i = first; i < windowSize_; ++i)
+            data_[i] = Complex(ringBuffer_[i - first] * w[i], Real(0));
+    }
+}
+
+// magnitudes, bands and stereo metrics of the spectrum in data_
+void FFTProcessor::finishFrame(std::vector<Real> &outBins)
+{
+    int half = windowSize_ / 2;
+    const Complex *spectrum = data_.data();
+    if (stereo_)
+    {
+        splitStereo();
+        spectrum = specMono_.data();
+    }
+
+    Real maxMag = std::max(Real(1e-12), SpectrumPass(spectrum, half, mags_.data(), nullptr, math_));
+    lastMaxMag_ = maxMag;
+    mapBands(mags_.data(), maxMag, outBins, true);
+
+    if (stereo_)
+    {
+        stereoMetrics();
+
+        if (stereoPair_ == StereoPair::MidSide)
+        {
+            for (int k = 0; k < half; ++k)
+            {
+                Complex l = specA_[k];
+                Complex r = specB_[k];
+                specA_[k] = (l + r) * Real(0.5);
+                specB_[k] = (l - r) * Real(0.5);
+            }
+        }
+
+        // per-channel bands share the mono peak so their levels compare
+        SpectrumPass(specA_.data(), half, magsA_.data(), nullptr, math_);
+        SpectrumPass(specB_.data(), half, magsB_.data(), nullptr, math_);
+        mapBands(magsA_.data(), maxMag, stereoBands_.first, false);
+        mapBands(magsB_.data(), maxMag, stereoBands_.second, false);
+    }
+}
+
+void FFTProcessor::MapSpectrum(const std::vector<Real> &mags, std::vector<Real> &outBins)
 {
-    int N = static_cast<int>(data.size());
-    for (int n = 0; n < N; ++n)
+    if (static_cast<int>(mags.size()) != windowSize_ / 2)
     {
-        double w = 0.5 * (1.0 - cos(2.0 * M_PI * n / (N - 1)));
-        data[n] *= static_cast<float>(w);
+        outBins.assign(outBinsCount_, Real(0));
+        return;
     }
+    mapBands(mags.data(), lastMaxMag_, outBins, false);
 }
 
 static void bitReverseSwap(std::vector<Complex> &a)
@@ -86,67 +413,141 @@ static void bitReverseSwap(std::vector<Complex> &a)
     }
 }
 
-void FFTProcessor::computeFFT(const std::vector<float> &window, std::vector<double> &magOut)
+void FFTProcessor::computeFFT()
 {
     int N = windowSize_;
-    std::vector<Complex> data(N);
-    for (int i = 0; i < N; ++i)
+    std::vector<Complex> &data = data_;
+
+    if (kernel_)
     {
-        data[i] = Complex(window[i], 0.0);
+        kernel_(data.data());
     }
-
-    bitReverseSwap(data);
-
-    for (int len = 2; len <= N; len <<= 1)
+    else if (mixed_.size() == N)
+    {
+        mixed_.Transform(data.data());
+    }
+    else
     {
-        double angle = -2.0 * M_PI / len;
-        Complex wlen(cos(angle), sin(angle));
-        for (int i = 0; i < N; i += len)
+        bitReverseSwap(data);
+
+        for (int len = 2; len <= N; len <<= 1)
         {
-            Complex w(1.0, 0.0);
             int half = len >> 1;
-            for (int j = 0; j < half; ++j)
+            int stride = N / len;
+            for (int i = 0; i < N; i += len)
             {
-                Complex u = data[i + j];
-                Complex v = data[i + j + half] * w;
-                data[i + j] = u + v;
-                data[i + j + half] = u - v;
-                w *= wlen;
+                for (int j = 0; j < half; ++j)
+                {
+                    Complex u = data[i + j];
+                    Complex v = data[i + j + half] * twiddles_[j * stride];
+                    data[i + j] = u + v;
+                    data[i + j + half] = u - v;
+                }
             }
         }
     }
+}
 
+// Z = FFT(l + i r) => L[k] = (Z[k] + conj(Z[N-k])) / 2,
+//                     R[k] = (Z[k] - conj(Z[N-k])) / 2i
+void FFTProcessor::splitStereo()
+{
+    int N = windowSize_;
     int half = N / 2;
-    std::vector<double> mags(half);
-    double maxMag = 1e-12;
+    for (int k = 0; k < half; ++k)
+    {
+        Complex z = data_[k];
+        Complex zc = std::conj(data_[(N - k) % N]);
+        Complex sum = (z + zc) * Real(0.5);
+        Complex diff = (z - zc) * Real(0.5);
 
-    for (int i = 0; i < half; ++i)
+        specA_[k] = sum;
+        specB_[k] = Complex(diff.imag(), -diff.real());
+        specMono_[k] = (specA_[k] + specB_[k]) * Real(0.5);
+    }
+}
+
+// correlation = Re(sum L conj R) / sqrt(sum |L|^2 sum |R|^2)
+// balance     = (sum |R|^2 - sum |L|^2) / (sum |L|^2 + sum |R|^2)
+void FFTProcessor::stereoMetrics()
+{
+    for (int b = 0; b < outBinsCount_; ++b)
     {
-        mags[i] = std::abs(data[i]);
-        if (mags[i] > maxMag)
-            maxMag = mags[i];
+        Real cross = 0;
+        Real powerL = 0;
+        Real powerR = 0;
+
+        for (int k = bandLo_[b]; k <= bandHi_[b]; ++k)
+        {
+            const Complex &l = specA_[k];
+            const Complex &r = specB_[k];
+            cross += l.real() * r.real() + l.imag() * r.imag();
+            powerL += std::norm(l);
+            powerR += std::norm(r);
+        }
+
+        Real total = powerL + powerR;
+        if (total <= Real(1e-20))
+        {
+            stereoBands_.correlation[b] = Real(1);
+            stereoBands_.balance[b] = Real(0);
+            continue;
+        }
+
+        stereoBands_.correlation[b] =
+            std::clamp(cross / std::sqrt(std::max(powerL * powerR, Real(1e-30))), Real(-1), Real(1));
+        stereoBands_.balance[b] = (powerR - powerL) / total;
     }
+}
+
+void FFTProcessor::mapBands(const Real *mags, Real maxMag, std::vector<Real> &magOut, bool trackGain)
+{
+    int N = windowSize_;
+    magOut.assign(outBinsCount_, Real(0));
 
-    magOut.assign(outBinsCount_, 0.0);
+    // dBFS: a full-scale sine peaks at N/2 after window gain compensation.
+    // The auto-gain offset is folded into the floor, so it costs nothing per band.
+    const Real ampScale = Real(2) / static_cast<Real>(N);
+    const Real dbFloor = static_cast<Real>(floorDb_ - gainDb_);
+    const Real dbRange = static_cast<Real>(ceilingDb_ - floorDb_);
+    Real frameLevel = Real(-300);
 
     for (int b = 0; b < outBinsCount_; ++b)
     {
-        double low = pow((double)half, (double)b / outBinsCount_);
-        double high = pow((double)half, (double)(b + 1) / outBinsCount_);
-
-        int ilo = std::max(0, static_cast<int>(floor(low)));
-        int ihi = std::min(half - 1, static_cast<int>(ceil(high)));
+        int ilo = bandLo_[b];
+        int ihi = bandHi_[b];
 
-        double sum = 0.0;
+        Real sum = 0;
+        Real peak = 0;
         int count = std::max(1, ihi - ilo + 1);
 
         for (int k = ilo; k <= ihi; ++k)
+        {
             sum += mags[k];
+            peak = std::max(peak, mags[k]);
+        }
+
+        Real avg = sum / static_cast<Real>(count);
 
-        double avg = sum / count;
-        double val = avg / (maxMag + 1e-12);
+        // dBFS reads the band peak so a tone shows its level regardless of
+        // how many bins the band spans
+        if (scale_ == OutputScale::Dbfs)
+        {
+            Real db = Real(20) * SpectrumLog10(std::max(peak * ampScale, Real(1e-15)), math_);
+            frameLevel = std::max(frameLevel, db);
+            magOut[b] = std::clamp((db - dbFloor) / dbRange, Real(0), Real(1));
+            continue;
+        }
 
-        double scaled = log10(1.0 + 9.0 * val);
-        magOut[b] = std::clamp(scaled, 0.0, 1.0);
+        Real val = avg / (maxMag + Real(1e-12));
+
+        Real scaled = SpectrumLog10(Real(1) + Real(9) * val, math_);
+        magOut[b] = std::clamp(scaled, Real(0), Real(1));
+    }
+
+    if (trackGain && autoGainEnabled_)
+    {
+        double level = autoGain_.Update(frameLevel);
+        gainDb_ = std::clamp(ceilingDb_ - kAutoGainHeadroomDb - level, 0.0, kAutoGainMaxBoostDb);
     }
 }
@@ -1,35 +1,182 @@
 #ifndef FFT_PROCESSOR_H_
 #define FFT_PROCESSOR_H_
 
+#include <cstdint>
 #include <vector>
 
-// Simple FFT processor (radix-2 iterative). No external deps.
+#include "batch_fft.h"
+#include "dsp_types.h"
+#include "fft_kernels.h"
+#include "mixed_radix_fft.h"
+#include "spectrum_kernels.h"
+#include "window_functions.h"
+#include "auto_gain.h"
+
+// How band magnitudes are mapped to 0..1.
+enum class OutputScale
+{
+    Normalized, // relative to the loudest bin of the current frame
+    Dbfs,       // absolute dBFS between a floor and a ceiling
+};
+
+// Which pair of spectra the stereo mode reports.
+enum class StereoPair
+{
+    LeftRight,
+    MidSide,
+};
+
+// Per-band stereo outputs, filled by GetBins in stereo mode.
+struct StereoBands
+{
+    std::vector<Real> first;       // left or mid, same scale as the mono bins
+    std::vector<Real> second;      // right or side
+    std::vector<Real> correlation; // -1..1, normalized L/R cross-spectrum
+    std::vector<Real> balance;     // -1 (left) .. 1 (right)
+};
+
+// Simple FFT processor. Power-of-two sizes use radix-2/4 kernels, other
+// 2^a * 3^b * 5^c sizes the mixed-radix transform. No external deps.
 class FFTProcessor
 {
 public:
-    // window_size must be power of two (e.g., 1024, 2048, 4096)
+    // window_size must factor into 2, 3 and 5 (e.g., 960, 1920, 2048);
+    // anything else falls back to 2048
     explicit FFTProcessor(int window_size = 2048, int output_bins = 64);
 
-    // push interleaved stereo floats (L,R,L,R,...). This mixes to mono internally.
+    // change window size / band count at runtime. The most recent samples are
+    // kept so the next frame does not start from silence.
+    void Configure(int window_size, int output_bins);
+
+    // push mono samples
     void PushSamples(const float *samples, int sampleCount);
 
+    // push one block per channel (stereo mode)
+    void PushStereoSamples(const float *left, const float *right, int sampleCount);
+
     // returns true if a window is ready (and grabs magnitudes into outBins)
-    bool GetBins(std::vector<double> &outBins);
+    bool GetBins(std::vector<Real> &outBins);
+
+    // Hop mode (hop > 0): a frame is due every hop pushed samples and
+    // NextFrame returns the due frames oldest first, so a backlog that
+    // arrives in one block after a stall is analysed frame by frame instead
+    // of only at its newest window. Power-of-two sizes transform up to
+    // BatchFFT::kLanes backlog frames at once. A backlog beyond
+    // kMaxBacklogFrames is skipped (oldest first). 0 restores GetBins-only.
+    static const int kMaxBacklogFrames = 32;
+    void SetHop(int hop);
+    int hop() const { return hop_; }
+
+    // same outputs as GetBins for the oldest due frame; false when none is due
+    bool NextFrame(std::vector<Real> &outBins);
+
+    // due frames not yet returned by NextFrame
+    int pending_frames() const { return hop_ > 0 ? sinceFrame_ / hop_ : 0; }
+    int64_t skipped_frames() const { return skippedFrames_; }
+
+    // samples pushed after the window of the last frame (0 outside hop mode,
+    // where a frame always ends at the newest sample)
+    int frame_lag() const { return hop_ > 0 ? sinceFrame_ : 0; }
 
     // set smoothing factor 0..1 (0=no smoothing, 0.8 heavy)
     void SetSmoothing(double alpha);
 
+    // exact libm or fused SIMD magnitude/log kernels (default)
+    void SetMath(SpectrumMath math) { math_ = math; }
+
+    // analysis window (Hann by default); beta only applies to Kaiser
+    void SetWindow(WindowType type, double kaiser_beta = 8.6);
+
+    // dBFS output maps [floor_db, ceiling_db] to [0, 1]. With auto_gain the
+    // window is shifted by a slow percentile-tracking gain (boost only).
+    void SetOutputScale(OutputScale scale, double floor_db = -90.0, double ceiling_db = 0.0,
+                        bool auto_gain = false);
+
+    // Stereo mode packs L + iR into one complex FFT, so both channel spectra
+    // (and the mono bins, from (L+R)/2) cost a single transform.
+    void SetStereo(bool enabled, StereoPair pair = StereoPair::LeftRight);
+    bool stereo() const { return stereo_; }
+    const StereoBands &stereo_bands() const { return stereoBands_; }
+
+    // |X[k]| of the last frame's mono spectrum, N/2 bins (valid after GetBins)
+    const std::vector<Real> &magnitudes() const { return mags_; }
+
+    // maps another N/2 magnitude spectrum (e.g. a separated layer) onto the
+    // current bands, scaled like the last frame's bins
+    void MapSpectrum(const std::vector<Real> &mags, std::vector<Real> &outBins);
+
+    // current auto-gain boost in dB (0 when disabled)
+    double gain_db() const { return gainDb_; }
+
+    int window_size() const { return windowSize_; }
+    int output_bins() const { return outBinsCount_; }
+
 private:
     int windowSize_;
     int outBinsCount_;
     double smoothingAlpha_;
+    SpectrumMath math_;
+    WindowType windowType_;
+    double kaiserBeta_;
+
+    OutputScale scale_;
+    double floorDb_;
+    double ceilingDb_;
+    bool autoGainEnabled_;
+    double gainDb_;
+    AutoGain autoGain_;
 
-    std::vector<float> ringBuffer_;
+    bool stereo_;
+    StereoPair stereoPair_;
+    StereoBands stereoBands_;
+
+    std::vector<float> ringBuffer_; // mono, or left in stereo mode
+    std::vector<float> ringRight_;  // right channel, stereo mode only
     int ringPos_;
 
+    // hop mode: samples pushed since the end of the last returned frame
+    int hop_;
+    int sinceFrame_;
+    int64_t skippedFrames_;
+
+    // backlog frames transformed together; lanes [batchNext_, batchCount_)
+    // hold the next due frames
+    BatchFFT batch_; // planned only for power-of-two sizes
+    std::vector<Real> batchRe_;
+    std::vector<Real> batchIm_;
+    int batchCount_;
+    int batchNext_;
+
+    // per-size tables and scratch, rebuilt by Configure
+    FFTKernel kernel_;              // specialized size, or nullptr for the generic loop
+    MixedRadixFFT mixed_;           // planned only for non-power-of-two sizes
+    std::vector<Complex> twiddles_; // e^{-2*pi*i*k/N}, k < N/2
+    std::vector<int> bandLo_;
+    std::vector<int> bandHi_;
+    const std::vector<Real> *windowCoeffs_; // cached, gain-compensated
+    std::vector<Complex> data_;
+    std::vector<Real> mags_;
+    Real lastMaxMag_; // normalization reference of the last frame
+
+    // stereo scratch (N/2 bins each)
+    std::vector<Complex> specA_;
+    std::vector<Complex> specB_;
+    std::vector<Complex> specMono_;
+    std::vector<Real> magsA_;
+    std::vector<Real> magsB_;
+
     // internal
-    void computeFFT(const std::vector<float> &window, std::vector<double> &magOut);
-    void applyHannWindow(std::vector<float> &data);
+    void buildTables();
+    int ringCapacity(int window_size) const;
+    void resizeRing(std::vector<float> &ring, int newSize) const;
+    void pushed(int sampleCount);
+    void loadWindow(int back);
+    void transformBacklog();
+    void finishFrame(std::vector<Real> &outBins);
+    void computeFFT();
+    void splitStereo();
+    void mapBands(const Real *mags, Real maxMag, std::vector<Real> &magOut, bool trackGain);
+    void stereoMetrics();
 };
 
 #endif // FFT_PROCESSOR_H_
@@ -0,0 +1,112 @@
+#include "frame_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint8_t kVersion = 1;
+    const uint8_t kFlagKeyframe = 1;
+    const uint8_t kFlagWide = 2;
+}
+
+FrameEncoder::FrameEncoder()
+    : encoding_(BinEncoding::Float),
+      threshold_(0.0),
+      keyframeInterval_(30),
+      sinceKeyframe_(0),
+      sequence_(0),
+      keyframeRequested_(true)
+{
+}
+
+void FrameEncoder::Configure(BinEncoding encoding, double delta_threshold, int keyframe_interval)
+{
+    encoding_ = encoding;
+    threshold_ = std::max(0.0, delta_threshold);
+    keyframeInterval_ = std::max(1, keyframe_interval);
+    held_.clear();
+    keyframeRequested_ = true;
+}
+
+// the plugin only runs on little-endian Windows targets, so fields are
+// copied as they are
+void FrameEncoder::put(size_t offset, const void *value, size_t bytes)
+{
+    std::memcpy(packet_.data() + offset, value, bytes);
+}
+
+const std::vector<uint8_t> &FrameEncoder::Encode(const std::vector<Real> &bins)
+{
+    int bands = static_cast<int>(std::min<size_t>(bins.size(), 65535));
+    bool wide = encoding_ == BinEncoding::Q16;
+    size_t valueBytes = wide ? 2 : 1;
+    double qmax = wide ? 65535.0 : 255.0;
+
+    bool keyframe = keyframeRequested_.exchange(false) || threshold_ <= 0.0 ||
+                    static_cast<int>(held_.size()) != bands || sinceKeyframe_ >= keyframeInterval_;
+    if (keyframe)
+    {
+        held_.assign(bands, 0.0f);
+        sinceKeyframe_ = 0;
+    }
+    sinceKeyframe_++;
+
+    changed_.clear();
+    double peak = 0.0;
+    for (int b = 0; b < bands; ++b)
+    {
+        double value = std::clamp(static_cast<double>(bins[b]), 0.0, 1.0);
+        if (keyframe || std::fabs(value - held_[b]) > threshold_)
+        {
+            changed_.push_back(b);
+            peak = std::max(peak, value);
+        }
+    }
+
+    // the step is formed exactly as the decoder forms it, so held_ mirrors
+    // the decoded values bit for bit
+    float scale = static_cast<float>(peak);
+    double step = static_cast<double>(scale) / qmax;
+
+    size_t entryBytes = keyframe ? valueBytes : 2 + valueBytes;
+    packet_.resize(kHeaderBytes + changed_.size() * entryBytes);
+
+    uint8_t flags = static_cast<uint8_t>((keyframe ? kFlagKeyframe : 0) | (wide ? kFlagWide : 0));
+    uint16_t bandCount = static_cast<uint16_t>(bands);
+    uint16_t entries = static_cast<uint16_t>(changed_.size());
+    packet_[0] = kVersion;
+    packet_[1] = flags;
+    put(2, &bandCount, 2);
+    put(4, &sequence_, 4);
+    put(8, &scale, 4);
+    put(12, &entries, 2);
+    sequence_++;
+
+    size_t offset = kHeaderBytes;
+    for (int b : changed_)
+    {
+        double value = std::clamp(static_cast<double>(bins[b]), 0.0, 1.0);
+        double q = step > 0.0 ? std::min(qmax, std::round(value / step)) : 0.0;
+        held_[b] = static_cast<float>(q * step);
+
+        if (!keyframe)
+        {
+            uint16_t index = static_cast<uint16_t>(b);
+            put(offset, &index, 2);
+            offset += 2;
+        }
+        if (wide)
+        {
+            uint16_t value16 = static_cast<uint16_t>(q);
+            put(offset, &value16, 2);
+        }
+        else
+        {
+            packet_[offset] = static_cast<uint8_t>(q);
+        }
+        offset += valueBytes;
+    }
+    return packet_;
+}
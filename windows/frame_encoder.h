@@ -0,0 +1,66 @@
+#ifndef FRAME_ENCODER_H_
+#define FRAME_ENCODER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "dsp_types.h"
+
+// Wire format of the bins on the event channel
+enum class BinEncoding
+{
+    Float, // typed list of Real (no packing)
+    Q8,    // one byte per band
+    Q16,   // two bytes per band
+};
+
+// Packs the band levels (0..1) into a compact little-endian packet:
+//
+//   0  u8   version (1)
+//   1  u8   flags: 1 = keyframe, 2 = 16-bit values
+//   2  u16  band count
+//   4  u32  sequence number
+//   8  f32  scale: value = q * (scale / 255 or 65535)
+//   12 u16  entries that follow
+//   14      keyframe: one value per band
+//           delta:    (u16 band, value) per changed band
+//
+// The scale is the largest value in the packet, so quiet frames keep their
+// resolution. With a delta threshold only the bands that moved more than
+// it from what the receiver holds are sent; the encoder tracks exactly the
+// values the decoder reconstructs, so errors never accumulate. Keyframes go
+// out on the first frame, every keyframe_interval frames, when the band
+// count changes and on request (e.g. a new listener).
+class FrameEncoder
+{
+public:
+    static const int kHeaderBytes = 14;
+
+    FrameEncoder();
+
+    void Configure(BinEncoding encoding, double delta_threshold, int keyframe_interval);
+    BinEncoding encoding() const { return encoding_; }
+
+    // any thread; the next packet is a keyframe
+    void RequestKeyframe() { keyframeRequested_ = true; }
+
+    // packet for bins, valid until the next call
+    const std::vector<uint8_t> &Encode(const std::vector<Real> &bins);
+
+private:
+    BinEncoding encoding_;
+    double threshold_;
+    int keyframeInterval_;
+    int sinceKeyframe_;
+    uint32_t sequence_;
+    std::atomic<bool> keyframeRequested_;
+
+    std::vector<float> held_;     // values the decoder holds
+    std::vector<int> changed_;    // bands in the current delta
+    std::vector<uint8_t> packet_; // reused, sized for a keyframe
+
+    void put(size_t offset, const void *value, size_t bytes);
+};
+
+#endif // FRAME_ENCODER_H_
@@ -0,0 +1,111 @@
+#include "frame_interpolator.h"
+
+#include <algorithm>
+
+FrameInterpolator::FrameInterpolator()
+    : newest_(-1),
+      count_(0),
+      maxExtrapolation_(0.05)
+{
+}
+
+void FrameInterpolator::SetMaxExtrapolation(double seconds)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    maxExtrapolation_ = std::max(0.0, seconds);
+}
+
+void FrameInterpolator::Reset()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    newest_ = -1;
+    count_ = 0;
+    stats_ = InterpolatorStats();
+}
+
+void FrameInterpolator::Push(double time, const std::vector<Real> &bins)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+
+    // a band-count change (quality governor) or a clock step (device
+    // switch) leaves nothing to interpolate against
+    if (count_ > 0)
+    {
+        const Frame &newest = frames_[newest_];
+        if (time <= newest.time || newest.bins.size() != bins.size())
+            count_ = 0;
+    }
+
+    newest_ = (newest_ + 1) % kFrames;
+    Frame &frame = frames_[newest_];
+    frame.time = time;
+    frame.bins.assign(bins.begin(), bins.end());
+    count_ = std::min(count_ + 1, kFrames);
+}
+
+const FrameInterpolator::Frame &FrameInterpolator::frameAt(int age) const
+{
+    return frames_[(newest_ - age + kFrames) % kFrames];
+}
+
+FrameSample FrameInterpolator::Sample(double time, std::vector<float> &out)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (count_ == 0)
+        return FrameSample::None;
+
+    const Frame &newest = frameAt(0);
+    size_t bands = newest.bins.size();
+    out.resize(bands);
+    stats_.lastLeadMs = (time - newest.time) * 1000.0;
+
+    if (time >= newest.time)
+    {
+        // ahead of the analysis: continue each band along its last slope
+        double lead = time - newest.time;
+        if (count_ < 2 || lead > maxExtrapolation_)
+        {
+            for (size_t b = 0; b < bands; ++b)
+                out[b] = static_cast<float>(newest.bins[b]);
+            stats_.held++;
+            return FrameSample::Held;
+        }
+
+        const Frame &previous = frameAt(1);
+        double scale = lead / (newest.time - previous.time);
+        for (size_t b = 0; b < bands; ++b)
+        {
+            double value = newest.bins[b] + (newest.bins[b] - previous.bins[b]) * scale;
+            out[b] = static_cast<float>(std::clamp(value, 0.0, 1.0));
+        }
+        stats_.extrapolated++;
+        return FrameSample::Extrapolated;
+    }
+
+    // newest first: the display usually asks for a time just behind it
+    for (int age = 1; age < count_; ++age)
+    {
+        const Frame &before = frameAt(age);
+        if (time < before.time)
+            continue;
+
+        const Frame &after = frameAt(age - 1);
+        double t = (time - before.time) / (after.time - before.time);
+        for (size_t b = 0; b < bands; ++b)
+            out[b] = static_cast<float>(before.bins[b] + (after.bins[b] - before.bins[b]) * t);
+        stats_.interpolated++;
+        return FrameSample::Interpolated;
+    }
+
+    const Frame &oldest = frameAt(count_ - 1);
+    for (size_t b = 0; b < bands; ++b)
+        out[b] = static_cast<float>(oldest.bins[b]);
+    stats_.held++;
+    return FrameSample::Held;
+}
+
+InterpolatorStats FrameInterpolator::stats() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return stats_;
+}
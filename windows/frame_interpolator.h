@@ -0,0 +1,71 @@
+#ifndef FRAME_INTERPOLATOR_H_
+#define FRAME_INTERPOLATOR_H_
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "dsp_types.h"
+
+// How a display-time spectrum was produced
+enum class FrameSample
+{
+    None,         // no frame yet
+    Held,         // before the oldest frame, or past the extrapolation limit
+    Interpolated, // between two frames
+    Extrapolated, // ahead of the newest frame along the band velocity
+};
+
+struct InterpolatorStats
+{
+    int64_t interpolated = 0;
+    int64_t extrapolated = 0;
+    int64_t held = 0;
+    double lastLeadMs = 0.0; // requested time - newest frame time
+};
+
+// Resamples the analysis frames onto display timestamps. Frames come from
+// the capture thread stamped with the capture-clock time of their window
+// centre; Sample (any thread, typically once per vsync) returns the
+// spectrum at a requested time, linearly interpolated between the two
+// frames around it or, ahead of the newest frame, extrapolated along each
+// band's velocity for at most max_extrapolation seconds and held after that.
+// Only a short ring of frames is kept and nothing allocates after the
+// first frame of a given band count.
+class FrameInterpolator
+{
+public:
+    FrameInterpolator();
+
+    void SetMaxExtrapolation(double seconds);
+    void Reset();
+
+    // capture thread; a time that does not advance restarts the history
+    void Push(double time, const std::vector<Real> &bins);
+
+    // bins are clamped to 0..1, the range of every output scale
+    FrameSample Sample(double time, std::vector<float> &out);
+
+    InterpolatorStats stats() const;
+
+private:
+    static const int kFrames = 8;
+
+    struct Frame
+    {
+        double time = 0.0;
+        std::vector<Real> bins;
+    };
+
+    std::array<Frame, kFrames> frames_;
+    int newest_; // index of the newest frame
+    int count_;
+    double maxExtrapolation_;
+    InterpolatorStats stats_;
+    mutable std::mutex lock_;
+
+    const Frame &frameAt(int age) const; // 0 = newest
+};
+
+#endif // FRAME_INTERPOLATOR_H_
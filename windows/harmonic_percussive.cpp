@@ -0,0 +1,62 @@
+#include "harmonic_percussive.h"
+
+#include <algorithm>
+
+HarmonicPercussive::HarmonicPercussive()
+    : timeFrames_(17),
+      freqBins_(17),
+      binCount_(0)
+{
+    Configure();
+}
+
+void HarmonicPercussive::Configure(int time_frames, int freq_bins)
+{
+    timeFrames_ = std::max(1, time_frames);
+    freqBins_ = std::max(1, freq_bins) | 1; // odd, so the window is centered
+    freq_.Configure(freqBins_);
+    binCount_ = 0; // rebuilt on the next frame
+}
+
+void HarmonicPercussive::Process(const Real *mags, int bin_count)
+{
+    if (bin_count != binCount_)
+    {
+        binCount_ = bin_count;
+        SlidingMedian proto;
+        proto.Configure(timeFrames_);
+        time_.assign(static_cast<size_t>(binCount_), proto);
+        harmonic_.assign(static_cast<size_t>(binCount_), Real(0));
+        percussive_.assign(static_cast<size_t>(binCount_), Real(0));
+    }
+
+    // time medians first; harmonic_ temporarily holds them
+    for (int k = 0; k < binCount_; ++k)
+    {
+        time_[k].Push(mags[k]);
+        harmonic_[k] = time_[k].Median();
+    }
+
+    // Frequency median centered on k. The window grows over the first
+    // bins and stays on the last freqBins_ bins at the top edge.
+    int half = freqBins_ / 2;
+    freq_.Reset();
+    for (int k = 0; k < std::min(half, binCount_); ++k)
+        freq_.Push(mags[k]);
+
+    for (int k = 0; k < binCount_; ++k)
+    {
+        if (k + half < binCount_)
+            freq_.Push(mags[k + half]);
+
+        // soft Wiener masks (power 2)
+        Real h = harmonic_[k];
+        Real p = freq_.Median();
+        Real h2 = h * h;
+        Real total = h2 + p * p;
+        Real mask = total > Real(1e-30) ? h2 / total : Real(0.5);
+
+        harmonic_[k] = mags[k] * mask;
+        percussive_[k] = mags[k] - harmonic_[k];
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef HARMONIC_PERCUSSIVE_H_
+#define HARMONIC_PERCUSSIVE_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+#include "sliding_median.h"
+
+// Streaming harmonic/percussive separation (median-filtering HPSS).
+// Harmonic content is steady in time, so each bin's median over the last
+// frames estimates it; percussive content is broadband, so a median across
+// neighbouring bins of the current frame estimates that. Both medians are
+// kept incrementally (SlidingMedian) and combined into soft Wiener masks
+// that split the magnitude spectrum into two layers summing to the input.
+class HarmonicPercussive
+{
+public:
+    HarmonicPercussive();
+
+    // median lengths: time_frames across frames, freq_bins across bins
+    void Configure(int time_frames = 17, int freq_bins = 17);
+
+    // mags = |X[k]| for k < bin_count (N/2); resets on a size change
+    void Process(const Real *mags, int bin_count);
+
+    const std::vector<Real> &harmonic() const { return harmonic_; }
+    const std::vector<Real> &percussive() const { return percussive_; }
+
+private:
+    int timeFrames_;
+    int freqBins_;
+    int binCount_;
+
+    std::vector<SlidingMedian> time_; // one per bin
+    SlidingMedian freq_;              // slides across the current frame
+
+    std::vector<Real> harmonic_;
+    std::vector<Real> percussive_;
+};
+
+#endif // HARMONIC_PERCUSSIVE_H_
@@ -0,0 +1,403 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "loudness_meter.h"
+#include "window_functions.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SAV_HAVE_SSE 1
+#endif
+
+namespace
+{
+    const int kMaxChannels = 8;
+    const int kSubBlocksMomentary = 4;  // 400 ms
+    const int kSubBlocksShortTerm = 30; // 3 s
+
+    // histogram: 0.1 LU bins from the absolute gate up to +30 LUFS
+    const double kAbsoluteGate = -70.0;
+    const double kRelativeGate = -10.0;
+    const double kHistStep = 0.1;
+    const int kHistBins = 1000;
+
+    // true-peak interpolator
+    const int kPeakTaps = 12; // per phase
+    const double kPeakBeta = 7.0;
+
+    // WAVEFORMATEXTENSIBLE speaker bits (SPEAKER_* in ksmedia.h)
+    const uint32_t kSpeakerFrontLeft = 0x1;
+    const uint32_t kSpeakerFrontRight = 0x2;
+    const uint32_t kSpeakerFrontCenter = 0x4;
+    const uint32_t kSpeakerLfe = 0x8;
+    const uint32_t kSpeakerBackLeft = 0x10;
+    const uint32_t kSpeakerBackRight = 0x20;
+    const uint32_t kSpeakerBackCenter = 0x100;
+    const uint32_t kSpeakerSideLeft = 0x200;
+    const uint32_t kSpeakerSideRight = 0x400;
+    const uint32_t kSurround = kSpeakerBackLeft | kSpeakerBackRight | kSpeakerBackCenter |
+                               kSpeakerSideLeft | kSpeakerSideRight;
+
+    // layout Windows assumes for a channel count when no mask is given
+    uint32_t defaultChannelMask(int channels)
+    {
+        const uint32_t stereo = kSpeakerFrontLeft | kSpeakerFrontRight;
+        const uint32_t surround51 = stereo | kSpeakerFrontCenter | kSpeakerLfe |
+                                    kSpeakerBackLeft | kSpeakerBackRight;
+        switch (channels)
+        {
+        case 1:
+            return kSpeakerFrontCenter;
+        case 2:
+            return stereo;
+        case 4:
+            return stereo | kSpeakerBackLeft | kSpeakerBackRight;
+        case 6:
+            return surround51;
+        case 8:
+            return surround51 | kSpeakerSideLeft | kSpeakerSideRight;
+        default:
+            return 0;
+        }
+    }
+
+    // BS.1770 weight of one speaker position
+    double channelWeight(uint32_t speaker)
+    {
+        if (speaker & kSpeakerLfe)
+            return 0.0;
+        if (speaker & kSurround)
+            return 1.41;
+        return 1.0;
+    }
+
+    double toLufs(double energy)
+    {
+        if (energy <= 0.0)
+            return -std::numeric_limits<double>::infinity();
+        return -0.691 + 10.0 * log10(energy);
+    }
+}
+
+LoudnessMeter::LoudnessMeter()
+    : sampleRate_(48000),
+      channels_(2),
+      lanes_(2),
+      stage_(),
+      blockLength_(4800),
+      blockPos_(0),
+      subHead_(0),
+      subCount_(0),
+      oversample_(4),
+      peakPos_(0),
+      truePeak_(0.0f)
+{
+    Configure(48000, 2);
+}
+
+void LoudnessMeter::Configure(int sample_rate, int channels, uint32_t channel_mask)
+{
+    sampleRate_ = std::max(8000, sample_rate);
+    channels_ = std::clamp(channels, 1, kMaxChannels);
+    lanes_ = (channels_ + 1) & ~1;
+
+    // BS.1770 K-weighting, re-derived for any rate from the 48 kHz
+    // reference (stage 1: high shelf, stage 2: RLB high-pass)
+    double fs = sampleRate_;
+    {
+        double f0 = 1681.974450955533;
+        double gain = 3.999843853973347;
+        double q = 0.7071752369554196;
+        double k = tan(M_PI * f0 / fs);
+        double vh = pow(10.0, gain / 20.0);
+        double vb = pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        stage_[0][0] = (vh + vb * k / q + k * k) / a0;
+        stage_[0][1] = 2.0 * (k * k - vh) / a0;
+        stage_[0][2] = (vh - vb * k / q + k * k) / a0;
+        stage_[0][3] = 2.0 * (k * k - 1.0) / a0;
+        stage_[0][4] = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        double f0 = 38.13547087602444;
+        double q = 0.5003270373238773;
+        double k = tan(M_PI * f0 / fs);
+        double a0 = 1.0 + k / q + k * k;
+        stage_[1][0] = 1.0;
+        stage_[1][1] = -2.0;
+        stage_[1][2] = 1.0;
+        stage_[1][3] = 2.0 * (k * k - 1.0) / a0;
+        stage_[1][4] = (1.0 - k / q + k * k) / a0;
+    }
+
+    // channel c sits at the c-th set bit of the mask; channels past the
+    // mask (or without any layout) count as front channels
+    uint32_t mask = channel_mask != 0 ? channel_mask : defaultChannelMask(channels_);
+    weight_.assign(static_cast<size_t>(lanes_), 0.0);
+    for (int c = 0; c < channels_; ++c)
+    {
+        uint32_t speaker = mask & (~mask + 1); // lowest remaining bit
+        mask &= ~speaker;
+        weight_[c] = channelWeight(speaker);
+    }
+
+    state_.assign(static_cast<size_t>(4 * lanes_), 0.0);
+    sum_.assign(static_cast<size_t>(lanes_), 0.0);
+    blockLength_ = std::max(1, static_cast<int>(lround(fs * 0.1)));
+    blockPos_ = 0;
+    subBlocks_.assign(kSubBlocksShortTerm, 0.0);
+    subHead_ = 0;
+    subCount_ = 0;
+
+    // Inter-sample peaks: windowed-sinc interpolator with its cutoff at the
+    // input Nyquist; each phase is normalized to unity DC gain.
+    oversample_ = sampleRate_ < 96000 ? 4 : sampleRate_ < 192000 ? 2 : 1;
+    int length = oversample_ * kPeakTaps;
+    double center = 0.5 * (length - 1);
+    double norm = BesselI0(kPeakBeta);
+    peakCoeffs_.assign(static_cast<size_t>(length), 0.0f);
+    for (int p = 0; p < oversample_; ++p)
+    {
+        double sum = 0.0;
+        for (int k = 0; k < kPeakTaps; ++k)
+        {
+            int n = p + k * oversample_;
+            double t = (n - center) / oversample_;
+            double sinc = (t == 0.0) ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            double r = 2.0 * n / std::max(1, length - 1) - 1.0;
+            double w = BesselI0(kPeakBeta * sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+            peakCoeffs_[p * kPeakTaps + (kPeakTaps - 1 - k)] = static_cast<float>(sinc * w);
+            sum += sinc * w;
+        }
+        for (int k = 0; k < kPeakTaps; ++k)
+            peakCoeffs_[p * kPeakTaps + k] = static_cast<float>(peakCoeffs_[p * kPeakTaps + k] / sum);
+    }
+    peakHistory_.assign(static_cast<size_t>(2 * kPeakTaps * channels_), 0.0f);
+    peakPos_ = 0;
+
+    Reset();
+}
+
+void LoudnessMeter::Reset()
+{
+    histCount_.assign(kHistBins, 0);
+    histEnergy_.assign(kHistBins, 0.0);
+    truePeak_ = 0.0f;
+}
+
+void LoudnessMeter::Process(const float *samples, int frames)
+{
+    trackPeak(samples, frames);
+
+    // filter in runs that end on sub-block boundaries
+    while (frames > 0)
+    {
+        int run = std::min(frames, blockLength_ - blockPos_);
+        filter(samples, run);
+        samples += static_cast<size_t>(run) * channels_;
+        frames -= run;
+        blockPos_ += run;
+
+        if (blockPos_ == blockLength_)
+            closeSubBlock();
+    }
+}
+
+// K-weights the run and adds each channel's squared output to sum_.
+// Transposed direct form II; state and accumulators stay in registers.
+void LoudnessMeter::filter(const float *samples, int frames)
+{
+    const int ch = channels_;
+
+#ifdef SAV_HAVE_SSE
+    const __m128d b0 = _mm_set1_pd(stage_[0][0]), b1 = _mm_set1_pd(stage_[0][1]);
+    const __m128d b2 = _mm_set1_pd(stage_[0][2]), a1 = _mm_set1_pd(stage_[0][3]);
+    const __m128d a2 = _mm_set1_pd(stage_[0][4]);
+    const __m128d c1 = _mm_set1_pd(stage_[1][3]), c2 = _mm_set1_pd(stage_[1][4]);
+    const __m128d two = _mm_set1_pd(2.0);
+
+    for (int lane = 0; lane < lanes_; lane += 2)
+    {
+        __m128d s0 = _mm_loadu_pd(&state_[0 * lanes_ + lane]);
+        __m128d s1 = _mm_loadu_pd(&state_[1 * lanes_ + lane]);
+        __m128d t0 = _mm_loadu_pd(&state_[2 * lanes_ + lane]);
+        __m128d t1 = _mm_loadu_pd(&state_[3 * lanes_ + lane]);
+        __m128d acc = _mm_loadu_pd(&sum_[lane]);
+        bool pair = lane + 1 < ch;
+
+        const float *x = samples + lane;
+        for (int i = 0; i < frames; ++i, x += ch)
+        {
+            __m128d in = _mm_set_pd(pair ? x[1] : 0.0, x[0]);
+
+            // stage 1: high shelf
+            __m128d y = _mm_add_pd(_mm_mul_pd(b0, in), s0);
+            s0 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, in), _mm_mul_pd(a1, y)), s1);
+            s1 = _mm_sub_pd(_mm_mul_pd(b2, in), _mm_mul_pd(a2, y));
+
+            // stage 2: high-pass, b = {1, -2, 1}
+            __m128d z = _mm_add_pd(y, t0);
+            t0 = _mm_sub_pd(_mm_sub_pd(t1, _mm_mul_pd(two, y)), _mm_mul_pd(c1, z));
+            t1 = _mm_sub_pd(y, _mm_mul_pd(c2, z));
+
+            acc = _mm_add_pd(acc, _mm_mul_pd(z, z));
+        }
+
+        _mm_storeu_pd(&state_[0 * lanes_ + lane], s0);
+        _mm_storeu_pd(&state_[1 * lanes_ + lane], s1);
+        _mm_storeu_pd(&state_[2 * lanes_ + lane], t0);
+        _mm_storeu_pd(&state_[3 * lanes_ + lane], t1);
+        _mm_storeu_pd(&sum_[lane], acc);
+    }
+#else
+    for (int c = 0; c < ch; ++c)
+    {
+        double s0 = state_[0 * lanes_ + c], s1 = state_[1 * lanes_ + c];
+        double t0 = state_[2 * lanes_ + c], t1 = state_[3 * lanes_ + c];
+        double acc = sum_[c];
+
+        const float *x = samples + c;
+        for (int i = 0; i < frames; ++i, x += ch)
+        {
+            double in = *x;
+            double y = stage_[0][0] * in + s0;
+            s0 = stage_[0][1] * in - stage_[0][3] * y + s1;
+            s1 = stage_[0][2] * in - stage_[0][4] * y;
+
+            double z = y + t0;
+            t0 = -2.0 * y - stage_[1][3] * z + t1;
+            t1 = y - stage_[1][4] * z;
+
+            acc += z * z;
+        }
+
+        state_[0 * lanes_ + c] = s0;
+        state_[1 * lanes_ + c] = s1;
+        state_[2 * lanes_ + c] = t0;
+        state_[3 * lanes_ + c] = t1;
+        sum_[c] = acc;
+    }
+#endif
+}
+
+void LoudnessMeter::closeSubBlock()
+{
+    double energy = 0.0;
+    for (int c = 0; c < channels_; ++c)
+        energy += weight_[c] * sum_[c];
+    energy /= blockLength_;
+    std::fill(sum_.begin(), sum_.end(), 0.0);
+    blockPos_ = 0;
+
+    subBlocks_[subHead_] = energy;
+    subHead_ = (subHead_ + 1) % kSubBlocksShortTerm;
+    subCount_ = std::min(subCount_ + 1, kSubBlocksShortTerm);
+
+    // every sub-block completes a 400 ms gating block (75% overlap)
+    if (subCount_ < kSubBlocksMomentary)
+        return;
+
+    double block = meanEnergy(kSubBlocksMomentary);
+    double lufs = toLufs(block);
+    if (!(lufs > kAbsoluteGate))
+        return;
+
+    int bin = std::min(kHistBins - 1, static_cast<int>((lufs - kAbsoluteGate) / kHistStep));
+    histCount_[bin]++;
+    histEnergy_[bin] += block;
+}
+
+// mean of the newest count sub-blocks (zeros before the ring fills)
+double LoudnessMeter::meanEnergy(int count) const
+{
+    double sum = 0.0;
+    for (int i = 1; i <= count; ++i)
+        sum += subBlocks_[(subHead_ - i + kSubBlocksShortTerm) % kSubBlocksShortTerm];
+    return sum / count;
+}
+
+double LoudnessMeter::momentary() const
+{
+    return toLufs(meanEnergy(kSubBlocksMomentary));
+}
+
+double LoudnessMeter::short_term() const
+{
+    return toLufs(meanEnergy(kSubBlocksShortTerm));
+}
+
+double LoudnessMeter::integrated() const
+{
+    // absolute-gated mean sets the relative gate
+    long long count = 0;
+    double energy = 0.0;
+    for (int i = 0; i < kHistBins; ++i)
+    {
+        count += histCount_[i];
+        energy += histEnergy_[i];
+    }
+    if (count == 0)
+        return toLufs(0.0);
+
+    double gate = toLufs(energy / static_cast<double>(count)) + kRelativeGate;
+    int first = std::max(0, static_cast<int>((gate - kAbsoluteGate) / kHistStep));
+
+    count = 0;
+    energy = 0.0;
+    for (int i = first; i < kHistBins; ++i)
+    {
+        count += histCount_[i];
+        energy += histEnergy_[i];
+    }
+    return count > 0 ? toLufs(energy / static_cast<double>(count)) : toLufs(0.0);
+}
+
+double LoudnessMeter::true_peak_db() const
+{
+    if (truePeak_ <= 0.0f)
+        return -std::numeric_limits<double>::infinity();
+    return 20.0 * log10(static_cast<double>(truePeak_));
+}
+
+void LoudnessMeter::trackPeak(const float *samples, int frames)
+{
+    const int ch = channels_;
+    float peak = truePeak_;
+
+    for (int i = 0; i < frames; ++i)
+    {
+        for (int c = 0; c < ch; ++c)
+        {
+            // doubled ring: the newest kPeakTaps samples are always contiguous
+            float *history = peakHistory_.data() + c * 2 * kPeakTaps;
+            float x = samples[i * ch + c];
+            history[peakPos_] = x;
+            history[peakPos_ + kPeakTaps] = x;
+            const float *window = history + peakPos_ + 1;
+
+            peak = std::max(peak, std::fabs(x));
+            for (int p = 0; p < oversample_; ++p)
+            {
+                const float *h = peakCoeffs_.data() + p * kPeakTaps;
+#ifdef SAV_HAVE_SSE
+                __m128 acc = _mm_mul_ps(_mm_loadu_ps(h), _mm_loadu_ps(window));
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(h + 4), _mm_loadu_ps(window + 4)));
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(h + 8), _mm_loadu_ps(window + 8)));
+                float lanes[4];
+                _mm_storeu_ps(lanes, acc);
+                float y = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+                float y = 0.0f;
+                for (int k = 0; k < kPeakTaps; ++k)
+                    y += h[k] * window[k];
+#endif
+                peak = std::max(peak, std::fabs(y));
+            }
+        }
+        peakPos_ = (peakPos_ + 1) % kPeakTaps;
+    }
+
+    truePeak_ = peak;
+}
@@ -0,0 +1,74 @@
+#ifndef LOUDNESS_METER_H_
+#define LOUDNESS_METER_H_
+
+#include <cstdint>
+#include <vector>
+
+// Streaming ITU-R BS.1770-4 / EBU R128 loudness meter on the raw capture
+// stream. Samples are K-weighted (pre-filter shelf + RLB high-pass, designed
+// for the device rate) with the biquads run two channels per SSE2 register,
+// then reduced to 100 ms sub-blocks. Momentary (400 ms) and short-term (3 s)
+// loudness are sliding means over the sub-blocks; integrated loudness gates
+// 400 ms blocks through a fixed 0.1 LU histogram, so memory and the cost of
+// a reading stay constant however long the session runs. True peak uses a
+// 4x (2x above 96 kHz) polyphase interpolator.
+class LoudnessMeter
+{
+public:
+    LoudnessMeter();
+
+    // redesign the filters for the device format; clears all measurements.
+    // channel_mask holds the WAVEFORMATEXTENSIBLE speaker bits of the
+    // channels (0: the default layout for the count) and picks the BS.1770
+    // weights: 0 for LFE, 1.41 for surrounds, 1.0 for the rest.
+    void Configure(int sample_rate, int channels, uint32_t channel_mask = 0);
+
+    // restart integrated loudness and the true-peak hold
+    void Reset();
+
+    // interleaved device frames
+    void Process(const float *samples, int frames);
+
+    // LUFS; -infinity until there is signal above the gates
+    double momentary() const;
+    double short_term() const;
+    double integrated() const;
+
+    // highest inter-sample peak since Reset, in dBTP
+    double true_peak_db() const;
+
+private:
+    int sampleRate_;
+    int channels_;
+    int lanes_; // channels rounded up to a whole SIMD pair
+
+    // K-weighting: two biquads, coefficients b0 b1 b2 a1 a2 per stage
+    double stage_[2][5];
+    std::vector<double> state_;  // [stage][z1|z2][lane]
+    std::vector<double> weight_; // BS.1770 channel weights, per lane
+    std::vector<double> sum_;    // per-lane energy of the open sub-block
+
+    int blockLength_; // samples per 100 ms sub-block
+    int blockPos_;
+    std::vector<double> subBlocks_; // weighted mean-square ring (3 s)
+    int subHead_;
+    int subCount_;
+
+    // gating histogram over [-70, +30) LUFS
+    std::vector<long long> histCount_;
+    std::vector<double> histEnergy_;
+
+    // true peak
+    int oversample_;
+    std::vector<float> peakCoeffs_;  // per phase, oldest->newest
+    std::vector<float> peakHistory_; // per channel, doubled ring
+    int peakPos_;
+    float truePeak_;
+
+    void filter(const float *samples, int frames);
+    void closeSubBlock();
+    void trackPeak(const float *samples, int frames);
+    double meanEnergy(int count) const;
+};
+
+#endif // LOUDNESS_METER_H_
@@ -0,0 +1,178 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "mixed_radix_fft.h"
+
+MixedRadixFFT::MixedRadixFFT() : n_(0) {}
+
+bool MixedRadixFFT::IsSupportedSize(int n)
+{
+    if (n < 2)
+        return false;
+    for (int p : {2, 3, 5})
+    {
+        while (n % p == 0)
+            n /= p;
+    }
+    return n == 1;
+}
+
+bool MixedRadixFFT::Plan(int n)
+{
+    n_ = 0;
+    factors_.clear();
+    twiddles_.clear();
+    scratch_.clear();
+
+    if (!IsSupportedSize(n))
+        return false;
+
+    // radix 4 first (cheapest per point), then 2, 3, 5
+    int rest = n;
+    for (int p : {4, 2, 3, 5})
+    {
+        while (rest % p == 0)
+        {
+            rest /= p;
+            factors_.push_back(p);
+            factors_.push_back(rest);
+        }
+    }
+
+    twiddles_.resize(n);
+    for (int k = 0; k < n; ++k)
+    {
+        double angle = -2.0 * M_PI * k / n;
+        twiddles_[k] = Complex(static_cast<Real>(cos(angle)), static_cast<Real>(sin(angle)));
+    }
+
+    scratch_.assign(n, Complex(0, 0));
+    n_ = n;
+    return true;
+}
+
+void MixedRadixFFT::Transform(Complex *data)
+{
+    if (n_ == 0)
+        return;
+
+    std::copy(data, data + n_, scratch_.begin());
+    work(data, scratch_.data(), 1, factors_.data());
+}
+
+void MixedRadixFFT::work(Complex *out, const Complex *in, int fstride, const int *factors)
+{
+    const int p = factors[0];
+    const int m = factors[1];
+
+    // p sub-transforms of length m over the decimated input
+    if (m == 1)
+    {
+        for (int q = 0; q < p; ++q)
+            out[q] = in[q * fstride];
+    }
+    else
+    {
+        for (int q = 0; q < p; ++q)
+            work(out + q * m, in + q * fstride, fstride * p, factors + 2);
+    }
+
+    switch (p)
+    {
+    case 2:
+        butterfly2(out, fstride, m);
+        break;
+    case 3:
+        butterfly3(out, fstride, m);
+        break;
+    case 4:
+        butterfly4(out, fstride, m);
+        break;
+    default:
+        butterfly5(out, fstride, m);
+        break;
+    }
+}
+
+void MixedRadixFFT::butterfly2(Complex *out, int fstride, int m)
+{
+    for (int u = 0; u < m; ++u)
+    {
+        Complex t = out[u + m] * twiddles_[u * fstride];
+        out[u + m] = out[u] - t;
+        out[u] += t;
+    }
+}
+
+void MixedRadixFFT::butterfly3(Complex *out, int fstride, int m)
+{
+    // sin(-2*pi/3)
+    const Real epi3 = twiddles_[fstride * m].imag();
+
+    for (int u = 0; u < m; ++u)
+    {
+        Complex s1 = out[u + m] * twiddles_[u * fstride];
+        Complex s2 = out[u + 2 * m] * twiddles_[2 * u * fstride];
+        Complex s3 = s1 + s2;
+        Complex s0 = (s1 - s2) * epi3;
+
+        Complex a = out[u] - s3 * Real(0.5);
+        out[u] += s3;
+        out[u + m] = Complex(a.real() - s0.imag(), a.imag() + s0.real());
+        out[u + 2 * m] = Complex(a.real() + s0.imag(), a.imag() - s0.real());
+    }
+}
+
+void MixedRadixFFT::butterfly4(Complex *out, int fstride, int m)
+{
+    for (int u = 0; u < m; ++u)
+    {
+        Complex s0 = out[u + m] * twiddles_[u * fstride];
+        Complex s1 = out[u + 2 * m] * twiddles_[2 * u * fstride];
+        Complex s2 = out[u + 3 * m] * twiddles_[3 * u * fstride];
+
+        Complex s5 = out[u] - s1;
+        Complex s6 = out[u] + s1;
+        Complex s3 = s0 + s2;
+        Complex s4 = s0 - s2;
+
+        out[u] = s6 + s3;
+        out[u + 2 * m] = s6 - s3;
+        // forward: s4 * -i
+        out[u + m] = Complex(s5.real() + s4.imag(), s5.imag() - s4.real());
+        out[u + 3 * m] = Complex(s5.real() - s4.imag(), s5.imag() + s4.real());
+    }
+}
+
+void MixedRadixFFT::butterfly5(Complex *out, int fstride, int m)
+{
+    const Complex ya = twiddles_[fstride * m];
+    const Complex yb = twiddles_[2 * fstride * m];
+
+    for (int u = 0; u < m; ++u)
+    {
+        Complex s0 = out[u];
+        Complex s1 = out[u + m] * twiddles_[u * fstride];
+        Complex s2 = out[u + 2 * m] * twiddles_[2 * u * fstride];
+        Complex s3 = out[u + 3 * m] * twiddles_[3 * u * fstride];
+        Complex s4 = out[u + 4 * m] * twiddles_[4 * u * fstride];
+
+        Complex s7 = s1 + s4;
+        Complex s10 = s1 - s4;
+        Complex s8 = s2 + s3;
+        Complex s9 = s2 - s3;
+
+        out[u] = s0 + s7 + s8;
+
+        Complex s5 = s0 + s7 * ya.real() + s8 * yb.real();
+        Complex s6(s10.imag() * ya.imag() + s9.imag() * yb.imag(),
+                   -(s10.real() * ya.imag() + s9.real() * yb.imag()));
+        out[u + m] = s5 - s6;
+        out[u + 4 * m] = s5 + s6;
+
+        Complex s11 = s0 + s7 * yb.real() + s8 * ya.real();
+        Complex s12(-s10.imag() * yb.imag() + s9.imag() * ya.imag(),
+                    s10.real() * yb.imag() - s9.real() * ya.imag());
+        out[u + 2 * m] = s11 + s12;
+        out[u + 3 * m] = s11 - s12;
+    }
+}
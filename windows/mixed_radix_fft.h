@@ -0,0 +1,39 @@
+#ifndef MIXED_RADIX_FFT_H_
+#define MIXED_RADIX_FFT_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+
+// Mixed-radix (4/2/3/5) forward FFT for sizes n = 2^a * 3^b * 5^c, e.g. 960
+// or 1920 so the hop lines up with 10 ms WASAPI packets. Recursive
+// decimation in time with dedicated butterflies per radix; all tables and
+// scratch are allocated by Plan().
+class MixedRadixFFT
+{
+public:
+    MixedRadixFFT();
+
+    static bool IsSupportedSize(int n);
+
+    // returns false (and leaves the plan empty) for unsupported sizes
+    bool Plan(int n);
+    int size() const { return n_; }
+
+    // in-place forward transform of size() points
+    void Transform(Complex *data);
+
+private:
+    int n_;
+    std::vector<int> factors_; // (radix, remaining length) pairs
+    std::vector<Complex> twiddles_;
+    std::vector<Complex> scratch_;
+
+    void work(Complex *out, const Complex *in, int fstride, const int *factors);
+    void butterfly2(Complex *out, int fstride, int m);
+    void butterfly3(Complex *out, int fstride, int m);
+    void butterfly4(Complex *out, int fstride, int m);
+    void butterfly5(Complex *out, int fstride, int m);
+};
+
+#endif // MIXED_RADIX_FFT_H_
@@ -0,0 +1,137 @@
+#include <cmath>
+#include "peak_tracker.h"
+
+#include <algorithm>
+
+namespace
+{
+    const int kMaxPeaks = 64;
+
+    // a peak keeps its id if it moved less than this since the last frame
+    const double kMatchSemitones = 0.5;
+    const double kMatchBins = 1.5;
+}
+
+PeakTracker::PeakTracker()
+    : maxPeaks_(0),
+      sampleRate_(48000),
+      minDb_(-80.0),
+      hzPerBin_(1.0),
+      nextId_(0),
+      count_(0),
+      previousCount_(0)
+{
+    Configure(16, 48000);
+}
+
+void PeakTracker::Configure(int max_peaks, int sample_rate, double min_db)
+{
+    maxPeaks_ = std::clamp(max_peaks, 1, kMaxPeaks);
+    sampleRate_ = std::max(1, sample_rate);
+    minDb_ = min_db;
+
+    heap_.assign(static_cast<size_t>(maxPeaks_), 0);
+    current_.assign(static_cast<size_t>(maxPeaks_), SpectralPeak{});
+    previous_.assign(static_cast<size_t>(maxPeaks_), SpectralPeak{});
+    claimed_.assign(static_cast<size_t>(maxPeaks_), 0);
+    count_ = 0;
+    previousCount_ = 0;
+}
+
+void PeakTracker::Process(const Real *mags, int bin_count)
+{
+    std::swap(current_, previous_);
+    previousCount_ = count_;
+    count_ = 0;
+
+    // a full-scale sine peaks at N/2 = bin_count
+    const double ampScale = 1.0 / std::max(1, bin_count);
+    const Real threshold = static_cast<Real>(pow(10.0, minDb_ / 20.0) * bin_count);
+    auto weaker = [mags](int a, int b)
+    { return mags[a] > mags[b]; };
+
+    // keep the K strongest local maxima; the heap top is the weakest kept
+    int *heap = heap_.data();
+    int size = 0;
+    for (int k = 1; k + 1 < bin_count; ++k)
+    {
+        Real m = mags[k];
+        if (m < threshold || m <= mags[k - 1] || m < mags[k + 1])
+            continue;
+
+        if (size < maxPeaks_)
+        {
+            heap[size++] = k;
+            std::push_heap(heap, heap + size, weaker);
+        }
+        else if (m > mags[heap[0]])
+        {
+            std::pop_heap(heap, heap + size, weaker);
+            heap[size - 1] = k;
+            std::push_heap(heap, heap + size, weaker);
+        }
+    }
+    std::sort_heap(heap, heap + size, weaker); // strongest first
+
+    hzPerBin_ = 0.5 * sampleRate_ / std::max(1, bin_count);
+    for (int i = 0; i < size; ++i)
+    {
+        int k = heap[i];
+        double a = log(mags[k - 1] + 1e-20);
+        double b = log(mags[k] + 1e-20);
+        double c = log(mags[k + 1] + 1e-20);
+        double denom = a - 2.0 * b + c;
+        double offset = denom < 0.0 ? 0.5 * (a - c) / denom : 0.0;
+        double peak = b - 0.25 * (a - c) * offset; // log magnitude at the vertex
+
+        SpectralPeak &p = current_[count_++];
+        p.frequency = (k + offset) * hzPerBin_;
+        p.level_db = 20.0 * (peak / log(10.0)) + 20.0 * log10(ampScale);
+        p.id = -1;
+        p.age = 0;
+    }
+
+    link();
+}
+
+// Greedy nearest-frequency matching, strongest new peak first. K is small,
+// so the K^2 scan is a constant next to the spectrum pass.
+void PeakTracker::link()
+{
+    std::fill(claimed_.begin(), claimed_.begin() + previousCount_, 0);
+
+    for (int i = 0; i < count_; ++i)
+    {
+        SpectralPeak &p = current_[i];
+        int best = -1;
+        double bestDistance = 1.0;
+
+        for (int j = 0; j < previousCount_; ++j)
+        {
+            if (claimed_[j])
+                continue;
+            // semitones up high, bins down low where bins are wider
+            double semis = std::fabs(12.0 * log2(p.frequency / previous_[j].frequency));
+            double bins = std::fabs(p.frequency - previous_[j].frequency) / hzPerBin_;
+            double distance = std::min(semis / kMatchSemitones, bins / kMatchBins);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = j;
+            }
+        }
+
+        if (best >= 0)
+        {
+            claimed_[best] = 1;
+            p.id = previous_[best].id;
+            p.age = previous_[best].age + 1;
+        }
+        else
+        {
+            p.id = nextId_;
+            nextId_ = (nextId_ + 1) & 0x7fffffff;
+            p.age = 0;
+        }
+    }
+}
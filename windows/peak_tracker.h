@@ -0,0 +1,55 @@
+#ifndef PEAK_TRACKER_H_
+#define PEAK_TRACKER_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+
+// One tracked spectral peak.
+struct SpectralPeak
+{
+    int id;           // stable while the peak persists across frames
+    int age;          // frames since the id was assigned
+    double frequency; // Hz, sub-bin accurate
+    double level_db;  // dBFS of the interpolated peak
+};
+
+// Finds the K strongest local maxima of the magnitude spectrum in one pass
+// (a K-entry min-heap, so O(N log K)), refines each with a parabola through
+// the log magnitudes, and links them to the previous frame's peaks by
+// nearest frequency so ids stay stable. All storage is sized by Configure;
+// Process never allocates.
+class PeakTracker
+{
+public:
+    PeakTracker();
+
+    // max_peaks is capped at 64; peaks below min_db are ignored
+    void Configure(int max_peaks, int sample_rate, double min_db = -80.0);
+
+    // mags = |X[k]| for k < bin_count (N/2)
+    void Process(const Real *mags, int bin_count);
+
+    // strongest first
+    const SpectralPeak *peaks() const { return current_.data(); }
+    int count() const { return count_; }
+    int max_peaks() const { return maxPeaks_; }
+
+private:
+    int maxPeaks_;
+    int sampleRate_;
+    double minDb_;
+    double hzPerBin_;
+    int nextId_;
+
+    std::vector<int> heap_; // candidate bins, weakest on top
+    std::vector<SpectralPeak> current_;
+    std::vector<SpectralPeak> previous_;
+    std::vector<char> claimed_; // previous peaks already linked this frame
+    int count_;
+    int previousCount_;
+
+    void link();
+};
+
+#endif // PEAK_TRACKER_H_
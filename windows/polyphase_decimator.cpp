@@ -0,0 +1,173 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "polyphase_decimator.h"
+#include "window_functions.h"
+
+#include <algorithm>
+#include <numeric>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define SAV_HAVE_SSE 1
+#endif
+
+namespace
+{
+    // taps per phase per unit of decimation ratio (M/L)
+    const int kTapsPerPhase = 32;
+    const double kKaiserBeta = 8.0;
+    // passband edge as a fraction of the output Nyquist
+    const double kPassband = 0.9;
+    // largest interpolation factor L; 160 covers 48000 -> 44100 (160/147)
+    // and keeps the prototype within a few tens of thousands of taps
+    const int kMaxUp = 160;
+    // lowest analysis rate; below it M, and with it the filter length
+    // (32 taps per unit of M/L), would grow without bound
+    const int kMinOutRate = 8000;
+
+    // the output rate nearest the requested one (not above the input rate)
+    // whose reduced ratio has L <= kMaxUp; the input rate itself always
+    // qualifies, so the search ends
+    int boundedRate(int in_rate, int out_rate)
+    {
+        for (int d = 0;; ++d)
+        {
+            for (int rate : {out_rate - d, out_rate + d})
+            {
+                if (rate > 0 && rate <= in_rate && rate / std::gcd(in_rate, rate) <= kMaxUp)
+                    return rate;
+            }
+        }
+    }
+
+    float dot(const float *a, const float *b, int n)
+    {
+#ifdef SAV_HAVE_SSE
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        for (; i + 4 <= n; i += 4)
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc0 = _mm_add_ps(acc0, acc1);
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc0);
+        float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; ++i)
+            sum += a[i] * b[i];
+        return sum;
+#else
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i)
+            sum += a[i] * b[i];
+        return sum;
+#endif
+    }
+}
+
+PolyphaseDecimator::PolyphaseDecimator()
+    : inRate_(48000),
+      outRate_(48000),
+      up_(1),
+      down_(1),
+      taps_(kTapsPerPhase),
+      next_(0),
+      phase_(0)
+{
+}
+
+void PolyphaseDecimator::Configure(int in_rate, int out_rate)
+{
+    inRate_ = std::max(1, in_rate);
+    outRate_ = out_rate > 0 ? boundedRate(inRate_, std::min(std::max(out_rate, kMinOutRate), inRate_))
+                            : inRate_;
+
+    int g = std::gcd(inRate_, outRate_);
+    up_ = outRate_ / g;
+    down_ = inRate_ / g;
+
+    coeffs_.clear();
+    history_.clear();
+    next_ = 0;
+    phase_ = 0;
+
+    if (passthrough())
+        return;
+
+    // the transition band shrinks with the ratio, so the filter grows with it
+    taps_ = kTapsPerPhase * std::max(1, (down_ + up_ - 1) / up_);
+
+    // Prototype low-pass at the upsampled rate (inRate * L): windowed sinc
+    // with its cutoff just below the output Nyquist.
+    int length = up_ * taps_;
+    double fc = kPassband * 0.5 / down_; // cycles per upsampled sample
+    double center = 0.5 * (length - 1);
+    double norm = BesselI0(kKaiserBeta);
+
+    std::vector<double> proto(length);
+    for (int n = 0; n < length; ++n)
+    {
+        double t = n - center;
+        double sinc = (t == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+        double r = 2.0 * n / (length - 1) - 1.0;
+        double w = BesselI0(kKaiserBeta * sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+        proto[n] = sinc * w * up_; // *L restores the gain lost to zero-stuffing
+    }
+
+    // phase p uses proto[p + k*L] against x[i - k]; store reversed so the
+    // inner product walks the history forwards
+    coeffs_.assign(static_cast<size_t>(length), 0.0f);
+    for (int p = 0; p < up_; ++p)
+    {
+        for (int k = 0; k < taps_; ++k)
+            coeffs_[p * taps_ + (taps_ - 1 - k)] = static_cast<float>(proto[p + k * up_]);
+
+        // unity DC gain on every branch avoids a ripple at the phase rate
+        double sum = 0.0;
+        for (int k = 0; k < taps_; ++k)
+            sum += coeffs_[p * taps_ + k];
+        for (int k = 0; k < taps_; ++k)
+            coeffs_[p * taps_ + k] = static_cast<float>(coeffs_[p * taps_ + k] / sum);
+    }
+
+    history_.assign(static_cast<size_t>(taps_ - 1), 0.0f);
+    next_ = taps_ - 1;
+}
+
+void PolyphaseDecimator::Process(const float *samples, int sampleCount, std::vector<float> &out)
+{
+    out.clear();
+
+    if (passthrough())
+    {
+        out.assign(samples, samples + sampleCount);
+        return;
+    }
+
+    history_.insert(history_.end(), samples, samples + sampleCount);
+
+    int available = static_cast<int>(history_.size());
+    out.reserve(static_cast<size_t>(sampleCount) * up_ / down_ + 1);
+
+    while (next_ < available)
+    {
+        const float *x = history_.data() + (next_ - taps_ + 1);
+        out.push_back(dot(coeffs_.data() + phase_ * taps_, x, taps_));
+
+        phase_ += down_;
+        next_ += phase_ / up_;
+        phase_ %= up_;
+    }
+
+    // keep the taps still needed by the next output
+    int drop = std::min(next_ - (taps_ - 1), available);
+    if (drop > 0)
+    {
+        history_.erase(history_.begin(), history_.begin() + drop);
+        next_ -= drop;
+    }
+}
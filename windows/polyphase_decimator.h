@@ -0,0 +1,40 @@
+#ifndef POLYPHASE_DECIMATOR_H_
+#define POLYPHASE_DECIMATOR_H_
+
+#include <vector>
+
+// Rational polyphase anti-aliasing decimator (mono). Converts any input rate
+// down to a fixed analysis rate so the FFT sees the same bin spacing on every
+// device. Rates at or below the analysis rate pass through untouched.
+class PolyphaseDecimator
+{
+public:
+    PolyphaseDecimator();
+
+    // (re)design the filter for inRate -> outRate; clears history. outRate
+    // is raised to at least 8 kHz, and one whose ratio to inRate does not
+    // reduce to a small L (e.g. 47999 against 48000) is moved to the nearest
+    // rate that does; output_rate() reports the rate used.
+    void Configure(int in_rate, int out_rate);
+
+    // appends the resampled signal to out (out is cleared first)
+    void Process(const float *samples, int sampleCount, std::vector<float> &out);
+
+    bool passthrough() const { return up_ == down_; }
+    int output_rate() const { return outRate_; }
+
+private:
+    int inRate_;
+    int outRate_;
+    int up_;   // L: interpolation factor
+    int down_; // M: decimation factor
+    int taps_; // taps per phase (multiple of 8)
+
+    // coefficients grouped by phase, each phase stored oldest->newest
+    std::vector<float> coeffs_;
+    std::vector<float> history_;
+    int next_;  // history index of the newest input used by the next output
+    int phase_; // polyphase branch of the next output
+};
+
+#endif // POLYPHASE_DECIMATOR_H_
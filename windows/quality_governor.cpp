@@ -0,0 +1,145 @@
+#include "quality_governor.h"
+
+#include <algorithm>
+
+#include "mixed_radix_fft.h"
+
+namespace
+{
+    // EMA coefficient for the load estimate (~1 s at 100 callbacks/s)
+    const double kLoadAlpha = 0.02;
+
+    // step down after this many consecutive over-budget callbacks
+    const int kDownHold = 25;
+    // step up only after a longer run well below budget
+    const int kUpHold = 300;
+    // the next level must fit in this fraction of the budget before stepping up
+    const double kUpHeadroom = 0.5;
+    // callbacks to ignore after a change while the load estimate settles
+    const int kCooldown = 100;
+
+    const int kMinFFT = 512;
+    const int kMinBins = 16;
+
+    // largest size FFTProcessor accepts (2^a * 3^b * 5^c, at least 16) that
+    // does not exceed target; 0 when there is none
+    int supportedAtOrBelow(int target)
+    {
+        for (int n = target; n >= 16; --n)
+        {
+            if (MixedRadixFFT::IsSupportedSize(n))
+                return n;
+        }
+        return 0;
+    }
+
+    // a lower rung never grows past the baseline and always lands on a
+    // supported size, otherwise Configure would fall back to 2048
+    int lowerFFT(int fft_size, int divisor)
+    {
+        int target = std::min(fft_size, std::max(kMinFFT, fft_size / divisor));
+        int n = supportedAtOrBelow(target);
+        return n > 0 ? n : fft_size;
+    }
+}
+
+QualityGovernor::QualityGovernor(double cpu_budget)
+    : budget_(std::clamp(cpu_budget, 0.01, 1.0)),
+      load_(0.0),
+      level_(0),
+      overCount_(0),
+      underCount_(0),
+      cooldown_(0)
+{
+    SetBaseline(2048, 64);
+}
+
+void QualityGovernor::SetBaseline(int fft_size, int bins)
+{
+    int fftHalf = lowerFFT(fft_size, 2);
+    int fftQuarter = lowerFFT(fft_size, 4);
+    int binsHalf = std::max(std::min(bins, kMinBins), bins / 2);
+
+    ladder_ = {
+        {fft_size, bins, 0},
+        {fft_size, bins, 20},
+        {fftHalf, bins, 20},
+        {fftHalf, binsHalf, 33},
+        {fftQuarter, binsHalf, 50},
+    };
+
+    level_ = 0;
+    load_ = 0.0;
+    overCount_ = 0;
+    underCount_ = 0;
+    cooldown_ = kCooldown;
+}
+
+void QualityGovernor::SetBudget(double cpu_budget)
+{
+    budget_ = std::clamp(cpu_budget, 0.01, 1.0);
+}
+
+bool QualityGovernor::Update(double processing_sec, double period_sec)
+{
+    if (period_sec <= 0.0)
+        return false;
+
+    double sample = std::min(processing_sec / period_sec, 4.0);
+    load_ += kLoadAlpha * (sample - load_);
+
+    if (cooldown_ > 0)
+    {
+        --cooldown_;
+        return false;
+    }
+
+    if (load_ > budget_)
+    {
+        underCount_ = 0;
+        if (++overCount_ >= kDownHold && level_ + 1 < static_cast<int>(ladder_.size()))
+        {
+            step(level_ + 1);
+            return true;
+        }
+        return false;
+    }
+
+    overCount_ = 0;
+
+    // estimate the cost of the next level up from the FFT size and frame
+    // rate ratios; only step up if it would still sit well inside the budget
+    if (level_ > 0)
+    {
+        const QualityMode &cur = ladder_[level_];
+        const QualityMode &up = ladder_[level_ - 1];
+        double sizeRatio = static_cast<double>(up.fftSize) / cur.fftSize;
+        double rateRatio = (up.frameIntervalMs == 0 || cur.frameIntervalMs == 0)
+                               ? 2.0
+                               : static_cast<double>(cur.frameIntervalMs) / up.frameIntervalMs;
+        double predicted = load_ * sizeRatio * rateRatio;
+
+        if (predicted < budget_ * kUpHeadroom)
+        {
+            if (++underCount_ >= kUpHold)
+            {
+                step(level_ - 1);
+                return true;
+            }
+        }
+        else
+        {
+            underCount_ = 0;
+        }
+    }
+
+    return false;
+}
+
+void QualityGovernor::step(int level)
+{
+    level_ = level;
+    overCount_ = 0;
+    underCount_ = 0;
+    cooldown_ = kCooldown;
+}
@@ -0,0 +1,51 @@
+#ifndef QUALITY_GOVERNOR_H_
+#define QUALITY_GOVERNOR_H_
+
+#include <vector>
+
+// One rung of the quality ladder.
+struct QualityMode
+{
+    int fftSize;
+    int bins;
+    int frameIntervalMs; // minimum time between analysis frames (0 = every packet)
+};
+
+// Adaptive quality governor. Measures the analysis time as a share of the
+// audio it covers and steps down the ladder when it exceeds the CPU budget,
+// back up when there is enough headroom. Steps use hysteresis (separate up/down thresholds,
+// hold counts and a cooldown) so the mode does not flap.
+class QualityGovernor
+{
+public:
+    // cpu_budget is the allowed share of one core (0.25 = 25%).
+    explicit QualityGovernor(double cpu_budget = 0.25);
+
+    // rebuild the ladder from the requested (top quality) configuration
+    void SetBaseline(int fft_size, int bins);
+    void SetBudget(double cpu_budget);
+
+    // feed the processing time of one callback and the duration of the
+    // audio it covered. Returns true when the mode changed.
+    bool Update(double processing_sec, double period_sec);
+
+    const QualityMode &mode() const { return ladder_[level_]; }
+    const std::vector<QualityMode> &ladder() const { return ladder_; }
+    int level() const { return level_; }
+    double load() const { return load_; }
+    double budget() const { return budget_; }
+
+private:
+    double budget_;
+    double load_;
+    std::vector<QualityMode> ladder_;
+    int level_;
+
+    int overCount_;
+    int underCount_;
+    int cooldown_;
+
+    void step(int level);
+};
+
+#endif // QUALITY_GOVERNOR_H_
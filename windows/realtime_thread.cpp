@@ -0,0 +1,117 @@
+#include "realtime_thread.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <avrt.h>
+#pragma comment(lib, "Avrt.lib")
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+    // nice values per class for the unprivileged fallback
+    const int kNiceAudio = -10;
+    const int kNiceProAudio = -15;
+
+    // per-thread on Linux: setpriority takes a thread id
+    id_t currentThreadId()
+    {
+#ifdef SYS_gettid
+        return static_cast<id_t>(syscall(SYS_gettid));
+#else
+        return 0;
+#endif
+    }
+#endif
+}
+
+RealtimeScope::RealtimeScope(RealtimeClass cls)
+    : mode_("none"),
+      task_(nullptr),
+      oldPolicy_(0),
+      oldPriority_(0),
+      oldNice_(0)
+{
+    if (cls == RealtimeClass::Off)
+        return;
+
+#ifdef _WIN32
+    DWORD taskIndex = 0;
+    HANDLE task = AvSetMmThreadCharacteristicsW(cls == RealtimeClass::ProAudio ? L"Pro Audio" : L"Audio",
+                                                &taskIndex);
+    if (task)
+    {
+        AvSetMmThreadPriority(task, AVRT_PRIORITY_HIGH);
+        task_ = task;
+        mode_ = "mmcss";
+    }
+#else
+    sched_param old{};
+    if (pthread_getschedparam(pthread_self(), &oldPolicy_, &old) == 0)
+    {
+        oldPriority_ = old.sched_priority;
+
+        // leave the top of the range to the system's own audio threads
+        int lo = sched_get_priority_min(SCHED_FIFO);
+        int hi = sched_get_priority_max(SCHED_FIFO);
+        sched_param param{};
+        param.sched_priority = cls == RealtimeClass::ProAudio ? std::max(lo, hi - 10) : std::max(lo, hi / 2);
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+        {
+            mode_ = "fifo";
+            return;
+        }
+    }
+
+    id_t tid = currentThreadId();
+    oldNice_ = getpriority(PRIO_PROCESS, tid);
+    if (setpriority(PRIO_PROCESS, tid, cls == RealtimeClass::ProAudio ? kNiceProAudio : kNiceAudio) == 0)
+        mode_ = "nice";
+#endif
+}
+
+RealtimeScope::~RealtimeScope()
+{
+#ifdef _WIN32
+    if (task_)
+        AvRevertMmThreadCharacteristics(static_cast<HANDLE>(task_));
+#else
+    if (std::strcmp(mode_, "fifo") == 0)
+    {
+        sched_param param{};
+        param.sched_priority = oldPriority_;
+        pthread_setschedparam(pthread_self(), oldPolicy_, &param);
+    }
+    else if (std::strcmp(mode_, "nice") == 0)
+    {
+        setpriority(PRIO_PROCESS, currentThreadId(), oldNice_);
+    }
+#endif
+}
+
+void DeadlineMonitor::Reset()
+{
+    periods_ = 0;
+    misses_ = 0;
+    worstLatenessMs_ = 0.0;
+}
+
+void DeadlineMonitor::Record(double budget_sec, double used_sec)
+{
+    periods_++;
+    double latenessMs = (used_sec - budget_sec) * 1000.0;
+    if (latenessMs > 0.0)
+    {
+        misses_++;
+        worstLatenessMs_ = std::max(worstLatenessMs_, latenessMs);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef REALTIME_THREAD_H_
+#define REALTIME_THREAD_H_
+
+#include <cstdint>
+
+enum class RealtimeClass
+{
+    Off,
+    Audio,    // MMCSS "Audio" / moderate SCHED_FIFO
+    ProAudio, // MMCSS "Pro Audio" / higher SCHED_FIFO
+};
+
+// Promotes the calling thread for the lifetime of the scope and restores it
+// afterwards. Windows registers the thread with MMCSS; elsewhere SCHED_FIFO
+// is tried first, then a negative nice value (which needs no privileges
+// when RLIMIT_NICE allows it). Failure is not an error: the thread simply
+// keeps its normal priority and mode() reports "none".
+class RealtimeScope
+{
+public:
+    explicit RealtimeScope(RealtimeClass cls);
+    ~RealtimeScope();
+
+    RealtimeScope(const RealtimeScope &) = delete;
+    RealtimeScope &operator=(const RealtimeScope &) = delete;
+
+    // "mmcss", "fifo", "nice" or "none"
+    const char *mode() const { return mode_; }
+
+private:
+    const char *mode_;
+    void *task_;      // MMCSS task handle
+    int oldPolicy_;   // scheduler policy before SCHED_FIFO
+    int oldPriority_; // its priority
+    int oldNice_;
+};
+
+// Per-period deadline accounting for a real-time loop: a period misses its
+// deadline when its work takes longer than the time it covers. Not
+// synchronized; the owner guards reads.
+class DeadlineMonitor
+{
+public:
+    void Reset();
+
+    // one period: used_sec of work against a budget of budget_sec
+    void Record(double budget_sec, double used_sec);
+
+    int64_t periods() const { return periods_; }
+    int64_t misses() const { return misses_; }
+    double worst_lateness_ms() const { return worstLatenessMs_; }
+
+private:
+    int64_t periods_ = 0;
+    int64_t misses_ = 0;
+    double worstLatenessMs_ = 0.0;
+};
+
+#endif // REALTIME_THREAD_H_
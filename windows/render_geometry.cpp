@@ -0,0 +1,230 @@
+#include "render_geometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const double kPi = 3.14159265358979323846;
+
+    void addPoint(std::vector<float> &out, double x, double y)
+    {
+        out.push_back(static_cast<float>(x));
+        out.push_back(static_cast<float>(y));
+    }
+}
+
+RenderGeometry::RenderGeometry()
+    : changed_(false)
+{
+    // corner arcs clockwise (y down) from the top-left corner: each corner
+    // is a quarter turn of kCornerSegments steps starting at 180, 270, 0
+    // and 90 degrees
+    const double starts[4] = {kPi, 1.5 * kPi, 0.0, 0.5 * kPi};
+    for (double start : starts)
+    {
+        for (int k = 0; k <= kCornerSegments; ++k)
+        {
+            double angle = start + 0.5 * kPi * k / kCornerSegments;
+            corners_.push_back(std::cos(angle));
+            corners_.push_back(std::sin(angle));
+        }
+    }
+}
+
+void RenderGeometry::Configure(const GeometryViewport &viewport)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    pending_ = viewport;
+    pending_.count = std::max(1, viewport.count);
+    changed_ = true;
+}
+
+bool RenderGeometry::Build(const std::vector<Real> &bands)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (changed_)
+        {
+            viewport_ = pending_;
+            changed_ = false;
+            capLevels_.clear();
+            cos_.clear();
+        }
+    }
+
+    triangles_.clear();
+    caps_.clear();
+    lines_.clear();
+    polyline_.clear();
+    if (viewport_.width <= 0.0 || viewport_.height <= 0.0 || bands.empty())
+        return false;
+
+    switch (viewport_.layout)
+    {
+    case GeometryLayout::Bars:
+        reduce(bands, viewport_.count);
+        buildBars();
+        return true;
+    case GeometryLayout::Petals:
+        reduce(bands, viewport_.count);
+        buildPetals();
+        return true;
+    case GeometryLayout::Wave:
+        buildWave(bands);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// plain averages of consecutive bands, as the painters did; fewer bands
+// than requested gives one level per band
+void RenderGeometry::reduce(const std::vector<Real> &bands, int count)
+{
+    int n = static_cast<int>(bands.size());
+    int levels = std::min(count, n);
+    int group = n / levels;
+
+    levels_.resize(levels);
+    for (int i = 0; i < levels; ++i)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < group; ++j)
+            sum += bands[i * group + j];
+        levels_[i] = sum / group;
+    }
+}
+
+void RenderGeometry::buildBars()
+{
+    const GeometryViewport &v = viewport_;
+    int count = static_cast<int>(levels_.size());
+    if (static_cast<int>(capLevels_.size()) != count)
+        capLevels_.assign(count, 0.0);
+
+    double slot = (v.width - v.pad * 2.0) / count;
+    double inset = slot * (1.0 - std::clamp(v.barFill, 0.0, 1.0)) * 0.5;
+    double bottom = v.height - v.pad;
+    double scale = v.height * v.intensity;
+
+    for (int i = 0; i < count; ++i)
+    {
+        double left = v.pad + i * slot + inset;
+        double right = v.pad + (i + 1) * slot - inset;
+        double height = std::max(0.0, levels_[i] * scale);
+        double radius = std::max(0.0, std::min({v.cornerRadius, (right - left) * 0.5, height * 0.5}));
+        addRoundedRect(left, bottom - height, right, bottom, radius);
+
+        capLevels_[i] = std::max(levels_[i], capLevels_[i] - v.capDecay);
+        if (v.capHeight > 0.0)
+        {
+            double capBottom = bottom - std::max(0.0, capLevels_[i] * scale);
+            addQuad(caps_, left, capBottom - v.capHeight, right, capBottom);
+        }
+    }
+}
+
+// fan from the centre for the body, closed segment loop for the outline
+void RenderGeometry::addRoundedRect(double left, double top, double right, double bottom, double radius)
+{
+    const double centres[4][2] = {
+        {left + radius, top + radius},
+        {right - radius, top + radius},
+        {right - radius, bottom - radius},
+        {left + radius, bottom - radius},
+    };
+    const int points = 4 * (kCornerSegments + 1);
+    double cx = (left + right) * 0.5;
+    double cy = (top + bottom) * 0.5;
+
+    for (int p = 0; p < points; ++p)
+    {
+        int q = (p + 1) % points;
+        const double *a = centres[p / (kCornerSegments + 1)];
+        const double *b = centres[q / (kCornerSegments + 1)];
+        double ax = a[0] + corners_[p * 2] * radius;
+        double ay = a[1] + corners_[p * 2 + 1] * radius;
+        double bx = b[0] + corners_[q * 2] * radius;
+        double by = b[1] + corners_[q * 2 + 1] * radius;
+
+        addPoint(triangles_, cx, cy);
+        addPoint(triangles_, ax, ay);
+        addPoint(triangles_, bx, by);
+        addPoint(lines_, ax, ay);
+        addPoint(lines_, bx, by);
+    }
+}
+
+void RenderGeometry::addQuad(std::vector<float> &out, double left, double top, double right, double bottom)
+{
+    addPoint(out, left, top);
+    addPoint(out, right, top);
+    addPoint(out, right, bottom);
+    addPoint(out, left, top);
+    addPoint(out, right, bottom);
+    addPoint(out, left, bottom);
+}
+
+// one stroke per level from the ring outwards, the level smoothed with its
+// neighbours round the circle and shaped by petalShape
+void RenderGeometry::buildPetals()
+{
+    const GeometryViewport &v = viewport_;
+    int count = static_cast<int>(levels_.size());
+    if (static_cast<int>(cos_.size()) != count)
+    {
+        cos_.resize(count);
+        sin_.resize(count);
+        for (int i = 0; i < count; ++i)
+        {
+            double angle = 2.0 * kPi * i / count;
+            cos_[i] = std::cos(angle);
+            sin_[i] = std::sin(angle);
+        }
+    }
+
+    double cx = v.width * 0.5;
+    double cy = v.height * 0.5;
+    double radius = std::min(v.width, v.height) * v.ringRadius;
+
+    for (int i = 0; i < count; ++i)
+    {
+        double previous = levels_[(i + count - 1) % count];
+        double next = levels_[(i + 1) % count];
+        double smoothed = std::max(0.0, levels_[i] * 0.6 + previous * 0.2 + next * 0.2);
+        double length = radius + std::pow(smoothed, v.petalShape) * radius * v.intensity;
+
+        addPoint(lines_, cx + cos_[i] * radius, cy + sin_[i] * radius);
+        addPoint(lines_, cx + cos_[i] * length, cy + sin_[i] * length);
+    }
+}
+
+// Catmull-Rom through the band levels, sampled at count points across the
+// padded width
+void RenderGeometry::buildWave(const std::vector<Real> &bands)
+{
+    const GeometryViewport &v = viewport_;
+    int n = static_cast<int>(bands.size());
+    int points = std::max(2, v.count);
+    double width = v.width - v.pad * 2.0;
+    double bottom = v.height - v.pad;
+    double scale = (v.height - v.pad * 2.0) * v.intensity;
+
+    for (int j = 0; j < points; ++j)
+    {
+        double t = static_cast<double>(j) / (points - 1);
+        double u = t * (n - 1);
+        int i = std::min(static_cast<int>(u), std::max(0, n - 2));
+        double f = u - i;
+
+        double p0 = bands[std::max(0, i - 1)];
+        double p1 = bands[i];
+        double p2 = bands[std::min(n - 1, i + 1)];
+        double p3 = bands[std::min(n - 1, i + 2)];
+        double value = 0.5 * (2.0 * p1 + (p2 - p0) * f + (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * f * f +
+                              (3.0 * (p1 - p2) + p3 - p0) * f * f * f);
+
+        addPoint(polyline_, v.pad + width * t, bottom - std::clamp(value, 0.0, 1.0) * scale);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef RENDER_GEOMETRY_H_
+#define RENDER_GEOMETRY_H_
+
+#include <mutex>
+#include <vector>
+
+#include "dsp_types.h"
+
+// Shape the geometry is built for
+enum class GeometryLayout
+{
+    None,
+    Bars,   // rounded bars with falling peak caps along the bottom edge
+    Petals, // radial strokes around a ring
+    Wave,   // smoothed polyline through every band
+};
+
+// Canvas the visualizer paints into, in logical pixels, plus the layout
+// constants the Dart painters used to apply per paint
+struct GeometryViewport
+{
+    GeometryLayout layout = GeometryLayout::None;
+    double width = 0.0;
+    double height = 0.0;
+    double pad = 20.0;          // bars, wave
+    int count = 12;             // bars or petals; points of the wave (see DefaultGeometryCount)
+    double intensity = 1.0;     // level -> length scale
+    double cornerRadius = 12.0; // bars
+    double barFill = 0.7;       // share of each bar slot that is filled
+    double capHeight = 4.0;     // bars; 0 turns the caps off
+    double capDecay = 0.02;     // cap fall per frame, in level units
+    double ringRadius = 0.27;   // petals, share of the shorter side
+    double petalShape = 1.8;    // petals, level exponent
+};
+
+// Count the Dart painters draw for a layout: 12 neon bars, 51 ring petals
+inline int DefaultGeometryCount(GeometryLayout layout)
+{
+    return layout == GeometryLayout::Petals ? 51 : 12;
+}
+
+// Turns a frame of bands into ready-to-draw float arrays (x, y pairs) so the
+// Dart painters only issue drawVertices / drawRawPoints:
+//
+//   triangles  bar bodies, a fan per rounded rectangle (VertexMode.triangles)
+//   caps       peak caps, two triangles each (VertexMode.triangles)
+//   lines      bar outlines or petal strokes, segment pairs (PointMode.lines)
+//   polyline   the wave (PointMode.polygon)
+//
+// Configure may be called from any thread (e.g. on a resize); Build runs on
+// the capture thread and takes the new viewport at its next frame. Buffers
+// are reused, so nothing allocates while the viewport and band count stay.
+class RenderGeometry
+{
+public:
+    RenderGeometry();
+
+    void Configure(const GeometryViewport &viewport);
+
+    // capture thread; false (and empty buffers) without a layout
+    bool Build(const std::vector<Real> &bands);
+
+    GeometryLayout layout() const { return viewport_.layout; }
+    const std::vector<float> &triangles() const { return triangles_; }
+    const std::vector<float> &caps() const { return caps_; }
+    const std::vector<float> &lines() const { return lines_; }
+    const std::vector<float> &polyline() const { return polyline_; }
+
+private:
+    static const int kCornerSegments = 4;
+
+    std::mutex lock_;
+    GeometryViewport pending_;
+    bool changed_;
+
+    GeometryViewport viewport_;
+    std::vector<double> levels_;    // bands averaged down to viewport_.count
+    std::vector<double> capLevels_; // held bar peaks
+    std::vector<double> cos_;       // petal directions
+    std::vector<double> sin_;
+    std::vector<double> corners_;   // unit corner arc directions (x, y)
+
+    std::vector<float> triangles_;
+    std::vector<float> caps_;
+    std::vector<float> lines_;
+    std::vector<float> polyline_;
+
+    void reduce(const std::vector<Real> &bands, int count);
+    void buildBars();
+    void buildPetals();
+    void buildWave(const std::vector<Real> &bands);
+    void addRoundedRect(double left, double top, double right, double bottom, double radius);
+    void addQuad(std::vector<float> &out, double left, double top, double right, double bottom);
+};
+
+#endif // RENDER_GEOMETRY_H_
@@ -0,0 +1,98 @@
+#ifndef SESSION_FORMAT_H_
+#define SESSION_FORMAT_H_
+
+#include <cstdint>
+#include <vector>
+
+// Recorded analysis session (.savs), little endian, append-only:
+//
+//   SessionHeader                       64 bytes
+//   frame 0 .. frame n-1                header.frameBytes each
+//   index: uint64 frame per time bucket written on close
+//   SessionFooter                       32 bytes, written on close
+//
+// Frames are fixed size, so frame i lives at sizeof(SessionHeader) +
+// i * frameBytes. Index entry b is the first frame whose timestamp is at or
+// after b * indexStepMs, which makes a timestamp seek one lookup plus a walk
+// bounded by the frames in one bucket. A file without a footer (crash,
+// power loss) is still readable; the reader rebuilds the index by scanning.
+//
+// Frame layout:
+//   uint64 seq (gaps mark dropped frames), float64 time (s since start),
+//   uint32 binCount, uint32 peakCount, float32 features[kSessionFeatures],
+//   float32 bins[binCapacity], peaks[peakCapacity] of
+//   { int32 id, int32 age, float32 frequency, float32 levelDb }
+
+const uint32_t kSessionVersion = 1;
+const int kSessionFeatures = 20;
+
+// feature slots; NaN when the stage was disabled during recording
+enum SessionFeature
+{
+    kFeatureMomentary = 0, // LUFS
+    kFeatureShortTerm,
+    kFeatureIntegrated,
+    kFeatureTruePeak, // dBTP
+    kFeatureTuningCents,
+    kFeaturePitchClass,
+    kFeatureChroma, // 12 slots, C .. B
+};
+
+struct SessionHeader
+{
+    char magic[4]; // "SAVS"
+    uint32_t version;
+    uint32_t analysisRate;
+    uint32_t fftSize;
+    uint32_t binCapacity;
+    uint32_t peakCapacity;
+    uint32_t frameBytes;
+    uint32_t indexStepMs;
+    uint64_t startUnixMs;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(SessionHeader) == 64, "SessionHeader layout");
+
+struct SessionFooter
+{
+    char magic[4]; // "SAVI"
+    uint32_t indexStepMs;
+    uint64_t frameCount;
+    uint64_t indexOffset;
+    uint64_t indexEntries;
+};
+static_assert(sizeof(SessionFooter) == 32, "SessionFooter layout");
+
+struct SessionPeak
+{
+    int32_t id;
+    int32_t age;
+    float frequency;
+    float levelDb;
+};
+static_assert(sizeof(SessionPeak) == 16, "SessionPeak layout");
+
+// offsets within a frame
+const uint32_t kFrameSeqOffset = 0;
+const uint32_t kFrameTimeOffset = 8;
+const uint32_t kFrameBinCountOffset = 16;
+const uint32_t kFramePeakCountOffset = 20;
+const uint32_t kFrameFeaturesOffset = 24;
+const uint32_t kFrameBinsOffset = kFrameFeaturesOffset + 4 * kSessionFeatures;
+
+inline uint32_t SessionFrameBytes(uint32_t binCapacity, uint32_t peakCapacity)
+{
+    return kFrameBinsOffset + 4 * binCapacity + static_cast<uint32_t>(sizeof(SessionPeak)) * peakCapacity;
+}
+
+// One decoded frame (reader output, recorder input).
+struct SessionFrame
+{
+    uint64_t seq = 0;
+    double time = 0.0;
+    float features[kSessionFeatures] = {};
+    std::vector<float> bins;
+    std::vector<SessionPeak> peaks;
+};
+
+#endif // SESSION_FORMAT_H_
@@ -0,0 +1,275 @@
+#include "session_reader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // a rebuilt index may run this many buckets ahead of the frame count
+    // (8 MB; 29 h of capture gaps at the default 100 ms step). A timestamp
+    // past that is garbage, not a gap, and ends the readable frames.
+    const uint64_t kMaxGapBuckets = 1 << 20;
+}
+
+SessionReader::SessionReader()
+    : data_(nullptr),
+      size_(0),
+      header_(),
+      frameCount_(0),
+#ifdef _WIN32
+      file_(nullptr),
+      mapping_(nullptr)
+#else
+      fd_(-1)
+#endif
+{
+}
+
+SessionReader::~SessionReader()
+{
+    Close();
+}
+
+bool SessionReader::Open(const std::string &path)
+{
+    Close();
+
+#ifdef _WIN32
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (length <= 0)
+        return false;
+    std::wstring wide(static_cast<size_t>(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length);
+
+    // FILE_SHARE_WRITE so a session still being recorded can be inspected
+    HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    file_ = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(SessionHeader)))
+    {
+        Close();
+        return false;
+    }
+
+    mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_)
+    {
+        Close();
+        return false;
+    }
+    data_ = static_cast<const uint8_t *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fd_ = open(path.c_str(), O_RDONLY);
+    if (fd_ < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd_, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SessionHeader)))
+    {
+        Close();
+        return false;
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+    if (view != MAP_FAILED)
+    {
+        data_ = static_cast<const uint8_t *>(view);
+        size_ = static_cast<size_t>(info.st_size);
+    }
+#endif
+
+    if (!data_)
+    {
+        Close();
+        return false;
+    }
+
+    std::memcpy(&header_, data_, sizeof(header_));
+    if (std::memcmp(header_.magic, "SAVS", 4) != 0 || header_.version != kSessionVersion ||
+        header_.indexStepMs == 0 ||
+        header_.frameBytes != SessionFrameBytes(header_.binCapacity, header_.peakCapacity))
+    {
+        Close();
+        return false;
+    }
+
+    if (!loadIndex())
+        rebuildIndex();
+    return true;
+}
+
+void SessionReader::Close()
+{
+#ifdef _WIN32
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_)
+        CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (data_)
+        munmap(const_cast<uint8_t *>(data_), size_);
+    if (fd_ >= 0)
+        close(fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    frameCount_ = 0;
+    index_.clear();
+}
+
+double SessionReader::duration() const
+{
+    return frameCount_ > 0 ? FrameTime(frameCount_ - 1) : 0.0;
+}
+
+int64_t SessionReader::Seek(double time) const
+{
+    if (frameCount_ == 0)
+        return -1;
+    if (index_.empty() || !(time >= 0.0))
+        return 0;
+
+    // the bucket gives the first frame at or after its start; everything
+    // before that frame is earlier than time, so the walk stays in one bucket
+    // compared as a double first: casting +inf or a huge time is undefined
+    double step = header_.indexStepMs / 1000.0;
+    double position = std::floor(time / step);
+    if (position >= static_cast<double>(index_.size()))
+        return frameCount_ - 1;
+    size_t bucket = static_cast<size_t>(position);
+
+    int64_t frame = static_cast<int64_t>(std::min<uint64_t>(index_[bucket], frameCount_ - 1));
+    while (frame + 1 < frameCount_ && FrameTime(frame + 1) <= time)
+        frame++;
+    if (frame > 0 && FrameTime(frame) > time)
+        frame--;
+    return frame;
+}
+
+double SessionReader::FrameTime(int64_t frame) const
+{
+    double time = 0.0;
+    if (frame < 0 || frame >= frameCount_)
+        return time;
+    std::memcpy(&time, frameAt(frame) + kFrameTimeOffset, sizeof(double));
+    return time;
+}
+
+bool SessionReader::ReadFrame(int64_t frame, SessionFrame &out) const
+{
+    if (frame < 0 || frame >= frameCount_)
+        return false;
+
+    const uint8_t *src = frameAt(frame);
+    uint32_t binCount = 0;
+    uint32_t peakCount = 0;
+    std::memcpy(&out.seq, src + kFrameSeqOffset, sizeof(uint64_t));
+    std::memcpy(&out.time, src + kFrameTimeOffset, sizeof(double));
+    std::memcpy(&binCount, src + kFrameBinCountOffset, sizeof(uint32_t));
+    std::memcpy(&peakCount, src + kFramePeakCountOffset, sizeof(uint32_t));
+    std::memcpy(out.features, src + kFrameFeaturesOffset, sizeof(out.features));
+
+    binCount = std::min(binCount, header_.binCapacity);
+    peakCount = std::min(peakCount, header_.peakCapacity);
+    out.bins.resize(binCount);
+    out.peaks.resize(peakCount);
+    if (binCount > 0)
+        std::memcpy(out.bins.data(), src + kFrameBinsOffset, binCount * sizeof(float));
+    if (peakCount > 0)
+        std::memcpy(out.peaks.data(), src + kFrameBinsOffset + header_.binCapacity * sizeof(float),
+                    peakCount * sizeof(SessionPeak));
+    return true;
+}
+
+const uint8_t *SessionReader::frameAt(int64_t frame) const
+{
+    return data_ + sizeof(SessionHeader) + static_cast<size_t>(frame) * header_.frameBytes;
+}
+
+// Uses the footer index when it is present and consistent with the file size
+// and its entries are non-decreasing frame numbers within the recording.
+bool SessionReader::loadIndex()
+{
+    if (size_ < sizeof(SessionHeader) + sizeof(SessionFooter))
+        return false;
+
+    SessionFooter footer;
+    std::memcpy(&footer, data_ + size_ - sizeof(footer), sizeof(footer));
+    if (std::memcmp(footer.magic, "SAVI", 4) != 0 || footer.indexStepMs != header_.indexStepMs)
+        return false;
+
+    // bound the counts first so the offset arithmetic below cannot wrap
+    uint64_t payload = size_ - sizeof(SessionHeader) - sizeof(footer);
+    if (footer.frameCount > payload / header_.frameBytes || footer.indexEntries > payload / sizeof(uint64_t))
+        return false;
+
+    uint64_t framesEnd = sizeof(SessionHeader) + footer.frameCount * header_.frameBytes;
+    if (footer.indexOffset != framesEnd ||
+        footer.indexOffset + footer.indexEntries * sizeof(uint64_t) + sizeof(footer) != size_)
+        return false;
+
+    std::vector<uint64_t> index(static_cast<size_t>(footer.indexEntries));
+    if (!index.empty())
+        std::memcpy(index.data(), data_ + footer.indexOffset, index.size() * sizeof(uint64_t));
+
+    uint64_t previous = 0;
+    for (uint64_t entry : index)
+    {
+        if (entry < previous || entry > footer.frameCount)
+            return false;
+        previous = entry;
+    }
+
+    frameCount_ = static_cast<int64_t>(footer.frameCount);
+    index_ = std::move(index);
+    return true;
+}
+
+// Recording stopped without a footer: keep the whole frames, drop a torn
+// tail and derive the index from the timestamps.
+void SessionReader::rebuildIndex()
+{
+    frameCount_ = static_cast<int64_t>((size_ - sizeof(SessionHeader)) / header_.frameBytes);
+    index_.clear();
+
+    double step = header_.indexStepMs / 1000.0;
+    double previous = 0.0;
+    for (int64_t frame = 0; frame < frameCount_; ++frame)
+    {
+        // timestamps only grow and stay within reach of the index; anything
+        // else is a partly written frame
+        double time = FrameTime(frame);
+        double limit = static_cast<double>(static_cast<uint64_t>(frameCount_) + kMaxGapBuckets);
+        if (!std::isfinite(time) || time < previous || std::floor(time / step) >= limit)
+        {
+            frameCount_ = frame;
+            break;
+        }
+        previous = time;
+
+        size_t bucket = static_cast<size_t>(std::max(0.0, std::floor(time / step)));
+        while (index_.size() <= bucket)
+            index_.push_back(static_cast<uint64_t>(frame));
+    }
+}
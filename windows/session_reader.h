@@ -0,0 +1,62 @@
+#ifndef SESSION_READER_H_
+#define SESSION_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_format.h"
+
+// Read-only view of a .savs session (see session_format.h). The file is
+// memory-mapped, so opening is constant time apart from a recording that
+// never got its footer, whose index is rebuilt by one pass over the frame
+// timestamps. Seek maps a timestamp to a frame through the index without
+// touching the frames in between.
+class SessionReader
+{
+public:
+    SessionReader();
+    ~SessionReader();
+
+    SessionReader(const SessionReader &) = delete;
+    SessionReader &operator=(const SessionReader &) = delete;
+
+    // path is UTF-8; false for missing, truncated or foreign files
+    bool Open(const std::string &path);
+    void Close();
+
+    bool is_open() const { return data_ != nullptr; }
+    const SessionHeader &header() const { return header_; }
+    int64_t frame_count() const { return frameCount_; }
+    double duration() const; // timestamp of the last frame, seconds
+
+    // last frame at or before time (first frame for earlier times); -1 if empty
+    int64_t Seek(double time) const;
+
+    // 0 for frames out of range
+    double FrameTime(int64_t frame) const;
+
+    // decodes into out, reusing its vectors; false if frame is out of range
+    bool ReadFrame(int64_t frame, SessionFrame &out) const;
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    SessionHeader header_;
+    int64_t frameCount_;
+    std::vector<uint64_t> index_;
+
+#ifdef _WIN32
+    void *file_;
+    void *mapping_;
+#else
+    int fd_;
+#endif
+
+    const uint8_t *frameAt(int64_t frame) const;
+    bool loadIndex();
+    void rebuildIndex();
+};
+
+#endif // SESSION_READER_H_
@@ -0,0 +1,273 @@
+#include "session_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace
+{
+    // ~0.5 s of frames at the default 60 fps frame rate per fwrite
+    const int kBatchFrames = 32;
+
+    // pending frames are flushed at least this often even if the batch is short
+    const std::chrono::milliseconds kFlushInterval(1000);
+
+    std::FILE *openForWrite(const std::string &path)
+    {
+#ifdef _WIN32
+        int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+        if (length <= 0)
+            return nullptr;
+        std::wstring wide(static_cast<size_t>(length), L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length);
+        std::FILE *file = nullptr;
+        if (_wfopen_s(&file, wide.c_str(), L"wb") != 0)
+            return nullptr;
+        return file;
+#else
+        return std::fopen(path.c_str(), "wb");
+#endif
+    }
+}
+
+SessionRecorder::SessionRecorder()
+    : file_(nullptr),
+      header_(),
+      stopping_(false),
+      open_(false),
+      batchFrames_(kBatchFrames),
+      filled_(0),
+      nextSeq_(0),
+      dropped_(0),
+      writeError_(false),
+      written_(0)
+{
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    Close();
+}
+
+bool SessionRecorder::Open(const std::string &path, uint32_t analysis_rate, uint32_t fft_size,
+                           uint32_t bin_capacity, uint32_t peak_capacity, uint32_t index_step_ms)
+{
+    Close();
+
+    std::FILE *file = openForWrite(path);
+    if (!file)
+        return false;
+
+    header_ = SessionHeader();
+    std::memcpy(header_.magic, "SAVS", 4);
+    header_.version = kSessionVersion;
+    header_.analysisRate = analysis_rate;
+    header_.fftSize = fft_size;
+    header_.binCapacity = bin_capacity;
+    header_.peakCapacity = peak_capacity;
+    header_.frameBytes = SessionFrameBytes(bin_capacity, peak_capacity);
+    header_.indexStepMs = std::max<uint32_t>(1, index_step_ms);
+    header_.startUnixMs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+
+    if (std::fwrite(&header_, sizeof(header_), 1, file) != 1)
+    {
+        std::fclose(file);
+        return false;
+    }
+
+    size_t batchBytes = static_cast<size_t>(batchFrames_) * header_.frameBytes;
+    filling_.assign(batchBytes, 0);
+    writing_.assign(batchBytes, 0);
+    index_.clear();
+    written_ = 0;
+    file_ = file;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        filled_ = 0;
+        nextSeq_ = 0;
+        dropped_ = 0;
+        writeError_ = false;
+        stopping_ = false;
+        open_ = true;
+    }
+
+    writer_ = std::thread(&SessionRecorder::writerLoop, this);
+    return true;
+}
+
+void SessionRecorder::Close()
+{
+    if (!file_)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (writer_.joinable())
+        writer_.join();
+
+    // the writer is gone and Append is refused: flush what is left here
+    if (filled_ > 0)
+    {
+        writeBatch(filling_.data(), filled_);
+        filled_ = 0;
+    }
+
+    // a failed write may have left a torn frame behind the last whole one;
+    // without a footer the reader drops it and rebuilds the index
+    if (!write_error())
+    {
+        SessionFooter footer = {};
+        std::memcpy(footer.magic, "SAVI", 4);
+        footer.indexStepMs = header_.indexStepMs;
+        footer.frameCount = written_;
+        footer.indexOffset = sizeof(SessionHeader) + written_ * header_.frameBytes;
+        footer.indexEntries = index_.size();
+        bool ok = index_.empty() ||
+                  std::fwrite(index_.data(), sizeof(uint64_t), index_.size(), file_) == index_.size();
+        ok = ok && std::fwrite(&footer, sizeof(footer), 1, file_) == 1;
+        if (std::fclose(file_) != 0 || !ok)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writeError_ = true;
+        }
+    }
+    else
+    {
+        std::fclose(file_);
+    }
+    file_ = nullptr;
+}
+
+void SessionRecorder::Append(double time, const float *bins, int bin_count, const SessionPeak *peaks,
+                             int peak_count, const float *features)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_)
+        return;
+
+    // both batches busy: the disk is behind, drop rather than block the DSP
+    // thread; after a failed write every frame is dropped
+    if (filled_ >= batchFrames_ || writeError_)
+    {
+        nextSeq_++;
+        dropped_++;
+        return;
+    }
+
+    uint32_t binCount = static_cast<uint32_t>(std::clamp(bin_count, 0, static_cast<int>(header_.binCapacity)));
+    uint32_t peakCount = static_cast<uint32_t>(std::clamp(peak_count, 0, static_cast<int>(header_.peakCapacity)));
+
+    uint8_t *dst = filling_.data() + static_cast<size_t>(filled_) * header_.frameBytes;
+    std::memset(dst, 0, header_.frameBytes);
+    std::memcpy(dst + kFrameSeqOffset, &nextSeq_, sizeof(uint64_t));
+    std::memcpy(dst + kFrameTimeOffset, &time, sizeof(double));
+    std::memcpy(dst + kFrameBinCountOffset, &binCount, sizeof(uint32_t));
+    std::memcpy(dst + kFramePeakCountOffset, &peakCount, sizeof(uint32_t));
+
+    float slots[kSessionFeatures];
+    for (int i = 0; i < kSessionFeatures; ++i)
+        slots[i] = features ? features[i] : NAN;
+    std::memcpy(dst + kFrameFeaturesOffset, slots, sizeof(slots));
+
+    if (binCount > 0)
+        std::memcpy(dst + kFrameBinsOffset, bins, binCount * sizeof(float));
+    if (peakCount > 0)
+        std::memcpy(dst + kFrameBinsOffset + header_.binCapacity * sizeof(float), peaks,
+                    peakCount * sizeof(SessionPeak));
+
+    nextSeq_++;
+    if (++filled_ == batchFrames_)
+        wake_.notify_one();
+}
+
+uint64_t SessionRecorder::frames() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nextSeq_ - dropped_;
+}
+
+uint64_t SessionRecorder::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+bool SessionRecorder::write_error() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writeError_;
+}
+
+void SessionRecorder::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        wake_.wait_for(lock, kFlushInterval, [this]
+                       { return stopping_ || filled_ >= batchFrames_; });
+        if (stopping_ || filled_ == 0)
+            continue;
+
+        // hand the full batch to the writer and give the DSP thread the other one
+        int count = filled_;
+        filling_.swap(writing_);
+        filled_ = 0;
+
+        lock.unlock();
+        writeBatch(writing_.data(), count);
+        lock.lock();
+    }
+}
+
+// Writes and indexes a batch. Only the frames fwrite reports as written are
+// indexed; the rest of the batch counts as dropped and the error is latched.
+void SessionRecorder::writeBatch(const uint8_t *frames, int count)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (writeError_)
+        {
+            dropped_ += static_cast<uint64_t>(count);
+            return;
+        }
+    }
+
+    size_t done = std::fwrite(frames, header_.frameBytes, static_cast<size_t>(count), file_);
+    indexBatch(frames, static_cast<int>(done));
+    if (done < static_cast<size_t>(count))
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writeError_ = true;
+        dropped_ += static_cast<uint64_t>(count) - done;
+    }
+}
+
+void SessionRecorder::indexBatch(const uint8_t *frames, int count)
+{
+    double step = header_.indexStepMs / 1000.0;
+    for (int i = 0; i < count; ++i)
+    {
+        double time = 0.0;
+        std::memcpy(&time, frames + static_cast<size_t>(i) * header_.frameBytes + kFrameTimeOffset,
+                    sizeof(double));
+
+        // every bucket up to this frame's starts here
+        size_t bucket = static_cast<size_t>(std::max(0.0, std::floor(time / step)));
+        while (index_.size() <= bucket)
+            index_.push_back(written_);
+        written_++;
+    }
+}
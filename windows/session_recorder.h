@@ -0,0 +1,72 @@
+#ifndef SESSION_RECORDER_H_
+#define SESSION_RECORDER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "session_format.h"
+
+// Writes a .savs session (see session_format.h). Append runs on the DSP
+// thread and only serializes the frame into a preallocated batch; a writer
+// thread flushes full batches (or whatever is pending once a second) with
+// one fwrite each. Two batches alternate, so the DSP thread never waits on
+// the disk: if both are full the frame is dropped and counted. After a
+// failed write (disk full, I/O error) nothing more is written and the file
+// is left without a footer, so readers keep only the whole frames.
+class SessionRecorder
+{
+public:
+    SessionRecorder();
+    ~SessionRecorder();
+
+    // path is UTF-8; returns false if the file cannot be created
+    bool Open(const std::string &path, uint32_t analysis_rate, uint32_t fft_size,
+              uint32_t bin_capacity, uint32_t peak_capacity, uint32_t index_step_ms = 100);
+
+    // flushes, writes the index and footer, closes the file
+    void Close();
+
+    bool recording() const { return file_ != nullptr; }
+
+    // DSP thread; time is seconds since Open. Bins and peaks beyond the
+    // capacities given to Open are cut.
+    void Append(double time, const float *bins, int bin_count, const SessionPeak *peaks,
+                int peak_count, const float *features);
+
+    uint64_t frames() const; // written or queued
+    uint64_t dropped() const; // including frames lost to a failed write
+    bool write_error() const; // a write failed since Open
+
+private:
+    std::FILE *file_;
+    SessionHeader header_;
+
+    std::thread writer_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    bool open_; // Append accepts frames
+
+    int batchFrames_;
+    std::vector<uint8_t> filling_; // appended to by the DSP thread
+    std::vector<uint8_t> writing_; // owned by the writer while flushing
+    int filled_;
+    uint64_t nextSeq_;
+    uint64_t dropped_;
+    bool writeError_;
+
+    // writer thread only
+    std::vector<uint64_t> index_;
+    uint64_t written_;
+
+    void writerLoop();
+    void writeBatch(const uint8_t *frames, int count);
+    void indexBatch(const uint8_t *frames, int count);
+};
+
+#endif // SESSION_RECORDER_H_
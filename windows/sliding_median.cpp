@@ -0,0 +1,154 @@
+#include "sliding_median.h"
+
+#include <algorithm>
+
+SlidingMedian::SlidingMedian()
+    : window_(0),
+      count_(0),
+      oldest_(0),
+      lowSize_(0),
+      highSize_(0)
+{
+}
+
+void SlidingMedian::Configure(int window)
+{
+    window_ = std::max(1, window);
+    value_.assign(static_cast<size_t>(window_), Real(0));
+    heapOf_.assign(static_cast<size_t>(window_), 0);
+    pos_.assign(static_cast<size_t>(window_), 0);
+    low_.assign(static_cast<size_t>(window_), 0);
+    high_.assign(static_cast<size_t>(window_), 0);
+    Reset();
+}
+
+void SlidingMedian::Reset()
+{
+    count_ = 0;
+    oldest_ = 0;
+    lowSize_ = 0;
+    highSize_ = 0;
+}
+
+void SlidingMedian::Push(Real value)
+{
+    if (count_ < window_)
+    {
+        int slot = count_++;
+        value_[slot] = value;
+        if (lowSize_ == 0 || value <= value_[low_[0]])
+        {
+            place(0, lowSize_++, slot);
+            siftUp(0, lowSize_ - 1);
+        }
+        else
+        {
+            place(1, highSize_++, slot);
+            siftUp(1, highSize_ - 1);
+        }
+
+        // low holds the extra element when the count is odd
+        if (lowSize_ > highSize_ + 1)
+            moveTop(0);
+        else if (highSize_ > lowSize_)
+            moveTop(1);
+        return;
+    }
+
+    // Full: overwrite the oldest slot where it sits. Heap sizes do not
+    // change, so at most the two roots end up on the wrong side.
+    int slot = oldest_;
+    oldest_ = (oldest_ + 1) % window_;
+    value_[slot] = value;
+
+    int heap = heapOf_[slot];
+    siftUp(heap, pos_[slot]);
+    siftDown(heap, pos_[slot]);
+
+    if (highSize_ > 0 && value_[low_[0]] > value_[high_[0]])
+    {
+        int a = low_[0];
+        int b = high_[0];
+        place(0, 0, b);
+        place(1, 0, a);
+        siftDown(0, 0);
+        siftDown(1, 0);
+    }
+}
+
+Real SlidingMedian::Median() const
+{
+    if (count_ == 0)
+        return Real(0);
+    if (lowSize_ > highSize_)
+        return value_[low_[0]];
+    return Real(0.5) * (value_[low_[0]] + value_[high_[0]]);
+}
+
+// true if slot a belongs nearer the root than slot b
+bool SlidingMedian::above(int heap, int a, int b) const
+{
+    return heap == 0 ? value_[a] > value_[b] : value_[a] < value_[b];
+}
+
+void SlidingMedian::place(int heap, int index, int slot)
+{
+    (heap == 0 ? low_ : high_)[index] = slot;
+    heapOf_[slot] = heap;
+    pos_[slot] = index;
+}
+
+void SlidingMedian::siftUp(int heap, int index)
+{
+    std::vector<int> &h = heap == 0 ? low_ : high_;
+    int slot = h[index];
+    while (index > 0)
+    {
+        int parent = (index - 1) / 2;
+        if (!above(heap, slot, h[parent]))
+            break;
+        place(heap, index, h[parent]);
+        index = parent;
+    }
+    place(heap, index, slot);
+}
+
+void SlidingMedian::siftDown(int heap, int index)
+{
+    std::vector<int> &h = heap == 0 ? low_ : high_;
+    int size = heap == 0 ? lowSize_ : highSize_;
+    int slot = h[index];
+    for (;;)
+    {
+        int child = 2 * index + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && above(heap, h[child + 1], h[child]))
+            ++child;
+        if (!above(heap, h[child], slot))
+            break;
+        place(heap, index, h[child]);
+        index = child;
+    }
+    place(heap, index, slot);
+}
+
+// moves the root of heap `from` to the other heap
+void SlidingMedian::moveTop(int from)
+{
+    std::vector<int> &src = from == 0 ? low_ : high_;
+    int &srcSize = from == 0 ? lowSize_ : highSize_;
+    int &dstSize = from == 0 ? highSize_ : lowSize_;
+    int to = 1 - from;
+
+    int slot = src[0];
+    --srcSize;
+    if (srcSize > 0)
+    {
+        place(from, 0, src[srcSize]);
+        siftDown(from, 0);
+    }
+
+    place(to, dstSize++, slot);
+    siftUp(to, dstSize - 1);
+}
@@ -0,0 +1,49 @@
+#ifndef SLIDING_MEDIAN_H_
+#define SLIDING_MEDIAN_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+
+// Running median of the last `window` values. Two indexable heaps (a
+// max-heap below the median, a min-heap above it) hold slot ids; every slot
+// remembers its heap position, so the oldest value is overwritten and
+// re-sifted in place instead of searched for. Push is O(log window),
+// Median is O(1), and nothing allocates after Configure.
+class SlidingMedian
+{
+public:
+    SlidingMedian();
+
+    void Configure(int window);
+    void Reset();
+
+    // adds a value, evicting the oldest once the window is full
+    void Push(Real value);
+
+    // median of the values currently held (0 when empty)
+    Real Median() const;
+
+    int size() const { return count_; }
+
+private:
+    int window_;
+    int count_;
+    int oldest_; // slot overwritten by the next Push when full
+
+    std::vector<Real> value_; // by slot
+    std::vector<int> heapOf_; // 0 = low (max-heap), 1 = high (min-heap)
+    std::vector<int> pos_;    // index within its heap
+    std::vector<int> low_;    // slot ids
+    std::vector<int> high_;
+    int lowSize_;
+    int highSize_;
+
+    bool above(int heap, int a, int b) const;
+    void place(int heap, int index, int slot);
+    void siftUp(int heap, int index);
+    void siftDown(int heap, int index);
+    void moveTop(int from);
+};
+
+#endif // SLIDING_MEDIAN_H_
@@ -0,0 +1,311 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "source_mixer.h"
+#include "window_functions.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define SAV_HAVE_SSE 1
+#endif
+
+namespace
+{
+    // per source; 1.36 s at 48 kHz, far more than the loop ever buffers
+    const int kRingFrames = 1 << 16;
+
+    // interpolation kernel: taps per output sample, tabulated phases
+    const int kTaps = 16;
+    const int kPhases = 256;
+    const double kKernelBeta = 8.0;
+    // passband edge as a fraction of the lower of the two Nyquists
+    const double kPassband = 0.92;
+
+    // delay the loop holds between source and mix; covers a couple of
+    // packets of delivery jitter from either device
+    const double kTargetFillSec = 0.02;
+    // beyond this the source is re-aligned at once instead of slewed
+    const double kResyncSec = 0.1;
+    const double kFillSmoothingSec = 1.0;
+
+    // PI loop on the fill error (seconds), critically damped (Kp^2 = 4 Ki):
+    // settles in about a minute, and the integral converges to the drift.
+    const double kKp = 0.1;
+    const double kKi = 0.0025;
+    const double kMaxCorrection = 1e-3; // +-1000 ppm, well past real crystals
+
+    float dot16(const float *a, const float *b)
+    {
+#ifdef SAV_HAVE_SSE
+        __m128 acc0 = _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b));
+        __m128 acc1 = _mm_mul_ps(_mm_loadu_ps(a + 4), _mm_loadu_ps(b + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + 8), _mm_loadu_ps(b + 8)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + 12), _mm_loadu_ps(b + 12)));
+        acc0 = _mm_add_ps(acc0, acc1);
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc0);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+        float sum = 0.0f;
+        for (int i = 0; i < kTaps; ++i)
+            sum += a[i] * b[i];
+        return sum;
+#endif
+    }
+}
+
+struct SourceMixer::Source
+{
+    float gain = 1.0f;
+
+    // Every frame is stored twice, at i and i + kRingFrames, so a kernel
+    // window starting anywhere in the first half never wraps.
+    std::vector<float> left = std::vector<float>(2 * kRingFrames);
+    std::vector<float> right = std::vector<float>(2 * kRingFrames);
+    std::atomic<uint64_t> written{0};  // frames pushed (source thread)
+    std::atomic<uint64_t> consumed{0}; // oldest frame still needed (master thread)
+    std::atomic<int> rate{0};          // nominal rate of the last push
+    std::atomic<int64_t> overruns{0};
+
+    // capture time of frame anchorFrame, from the newest push
+    std::mutex anchorLock;
+    uint64_t anchorFrame = 0;
+    double anchorTime = 0.0;
+
+    // master thread only
+    int designedRate = 0;
+    std::vector<float> kernel; // (kPhases + 1) rows of kTaps
+    double step = 1.0;         // nominal source frames per master frame
+    uint64_t readPos = 0;      // first tap of the next output
+    double frac = 0.0;         // output position past readPos + kTaps / 2 - 1
+    bool primed = false;
+    double fillAvg = 0.0; // source frames
+    double integral = 0.0;
+    double correction = 0.0;
+    int64_t underruns = 0;
+    int64_t resyncs = 0;
+};
+
+SourceMixer::SourceMixer()
+    : rate_(48000),
+      channels_(2)
+{
+}
+
+SourceMixer::~SourceMixer() = default;
+
+void SourceMixer::Configure(int rate, int channels)
+{
+    rate_ = std::max(1, rate);
+    channels_ = std::max(1, channels);
+    for (auto &s : sources_)
+        s->designedRate = 0;
+}
+
+int SourceMixer::AddSource(float gain)
+{
+    sources_.push_back(std::make_unique<Source>());
+    sources_.back()->gain = gain;
+    return static_cast<int>(sources_.size()) - 1;
+}
+
+void SourceMixer::ClearSources()
+{
+    sources_.clear();
+}
+
+void SourceMixer::Push(int source, const float *samples, int frames, int channels, int rate, double time)
+{
+    Source &s = *sources_[source];
+    s.rate.store(rate, std::memory_order_release);
+
+    uint64_t w = s.written.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(s.anchorLock);
+        s.anchorFrame = w;
+        s.anchorTime = time;
+    }
+
+    uint64_t space = kRingFrames - (w - s.consumed.load(std::memory_order_acquire));
+    if (static_cast<uint64_t>(frames) > space)
+    {
+        // the master stopped pulling (e.g. a stalled capture thread); keep
+        // the oldest
+        s.overruns.fetch_add(1, std::memory_order_relaxed);
+        frames = static_cast<int>(space);
+    }
+
+    int rightOffset = channels >= 2 ? 1 : 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        size_t idx = static_cast<size_t>((w + static_cast<uint64_t>(i)) & (kRingFrames - 1));
+        float l = samples[i * channels];
+        float r = samples[i * channels + rightOffset];
+        s.left[idx] = l;
+        s.left[idx + kRingFrames] = l;
+        s.right[idx] = r;
+        s.right[idx + kRingFrames] = r;
+    }
+    s.written.store(w + static_cast<uint64_t>(frames), std::memory_order_release);
+}
+
+const float *SourceMixer::Mix(const float *samples, int frames, double time)
+{
+    mixed_.assign(samples, samples + static_cast<size_t>(frames) * channels_);
+    for (auto &s : sources_)
+        mixSource(*s, frames, time);
+    return mixed_.data();
+}
+
+MixSourceStats SourceMixer::source_stats(int source) const
+{
+    MixSourceStats stats;
+    if (source < 0 || source >= source_count())
+        return stats;
+
+    const Source &s = *sources_[source];
+    std::lock_guard<std::mutex> lock(statsLock_);
+    stats.rate = s.designedRate;
+    stats.driftPpm = s.integral * 1e6;
+    stats.fillMs = s.designedRate > 0 ? s.fillAvg * 1000.0 / s.designedRate : 0.0;
+    stats.underruns = s.underruns;
+    stats.overruns = s.overruns.load(std::memory_order_relaxed);
+    stats.resyncs = s.resyncs;
+    return stats;
+}
+
+// Tabulates the windowed-sinc kernel for the source -> master ratio. Rows
+// are fractional positions 0..1 (the last row repeats the first, shifted by
+// one tap) and each row is normalized to unity DC gain.
+void SourceMixer::design(Source &s, int rate)
+{
+    std::lock_guard<std::mutex> lock(statsLock_);
+    s.designedRate = rate;
+    s.step = static_cast<double>(rate) / rate_;
+    s.primed = false;
+    s.integral = 0.0;
+    s.correction = 0.0;
+
+    double cutoff = kPassband * std::min(1.0, 1.0 / s.step); // of the source Nyquist
+    double half = kTaps / 2;
+    double norm = BesselI0(kKernelBeta);
+    s.kernel.assign(static_cast<size_t>(kPhases + 1) * kTaps, 0.0f);
+    for (int p = 0; p <= kPhases; ++p)
+    {
+        double frac = static_cast<double>(p) / kPhases;
+        float *row = &s.kernel[static_cast<size_t>(p) * kTaps];
+        double sum = 0.0;
+        double taps[kTaps];
+        for (int k = 0; k < kTaps; ++k)
+        {
+            double t = k - (half - 1.0) - frac;
+            double x = M_PI * cutoff * t;
+            double sinc = std::fabs(x) < 1e-12 ? 1.0 : std::sin(x) / x;
+            double r = t / half;
+            double w = BesselI0(kKernelBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+            taps[k] = sinc * w;
+            sum += taps[k];
+        }
+        for (int k = 0; k < kTaps; ++k)
+            row[k] = static_cast<float>(taps[k] / sum);
+    }
+}
+
+void SourceMixer::mixSource(Source &s, int frames, double time)
+{
+    int rate = s.rate.load(std::memory_order_acquire);
+    if (rate <= 0)
+        return; // nothing pushed yet
+    if (rate != s.designedRate)
+        design(s, rate);
+
+    uint64_t w = s.written.load(std::memory_order_acquire);
+    uint64_t anchorFrame = 0;
+    double anchorTime = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(s.anchorLock);
+        anchorFrame = s.anchorFrame;
+        anchorTime = s.anchorTime;
+    }
+
+    // Fill is measured against where the source stream is at the master
+    // packet's capture time, not against what happens to be queued: the
+    // queue is a sawtooth of source packets whose phase against the master
+    // packets walks with the drift, which would alias into the loop.
+    double position = static_cast<double>(anchorFrame) + (time - anchorTime) * rate;
+    double target = kTargetFillSec * rate;
+    double fill = position - static_cast<double>(s.readPos) - (kTaps / 2 - 1) - s.frac;
+
+    // (re)align so the interpolation point sits target frames behind the
+    // source's current position; the integral (drift estimate) survives
+    if (!s.primed || std::fabs(fill - target) > kResyncSec * rate)
+    {
+        double start = std::floor(position - target) - (kTaps / 2 - 1);
+        if (start < 0.0 || start + kTaps > static_cast<double>(w))
+            return; // still buffering the first packets
+        if (s.primed)
+            s.resyncs++;
+        s.readPos = static_cast<uint64_t>(start);
+        s.frac = 0.0;
+        s.fillAvg = target;
+        s.primed = true;
+        fill = target;
+    }
+
+    double dt = static_cast<double>(frames) / rate_;
+    double error = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(statsLock_);
+        s.fillAvg += std::min(1.0, dt / kFillSmoothingSec) * (fill - s.fillAvg);
+        error = (s.fillAvg - target) / rate; // seconds of excess delay
+        s.integral = std::clamp(s.integral + kKi * error * dt, -kMaxCorrection, kMaxCorrection);
+        s.correction = std::clamp(kKp * error + s.integral, -kMaxCorrection, kMaxCorrection);
+    }
+
+    double step = s.step * (1.0 + s.correction);
+    float gain = s.gain;
+    int ch = channels_;
+    float *out = mixed_.data();
+    for (int i = 0; i < frames; ++i)
+    {
+        if (w - s.readPos < static_cast<uint64_t>(kTaps))
+        {
+            // the source device stalled; re-prime once it delivers again
+            std::lock_guard<std::mutex> lock(statsLock_);
+            s.underruns++;
+            s.primed = false;
+            break;
+        }
+
+        double scaled = s.frac * kPhases;
+        int phase = std::min(static_cast<int>(scaled), kPhases - 1);
+        float mu = static_cast<float>(scaled - phase);
+        const float *k0 = &s.kernel[static_cast<size_t>(phase) * kTaps];
+        const float *k1 = k0 + kTaps;
+        size_t idx = static_cast<size_t>(s.readPos & (kRingFrames - 1));
+        float l0 = dot16(k0, &s.left[idx]);
+        float l1 = dot16(k1, &s.left[idx]);
+        float r0 = dot16(k0, &s.right[idx]);
+        float r1 = dot16(k1, &s.right[idx]);
+        float l = gain * (l0 + mu * (l1 - l0));
+        float r = gain * (r0 + mu * (r1 - r0));
+
+        if (ch >= 2)
+        {
+            out[i * ch] += l;
+            out[i * ch + 1] += r;
+        }
+        else
+        {
+            out[i] += 0.5f * (l + r);
+        }
+
+        s.frac += step;
+        double advance = std::floor(s.frac);
+        s.frac -= advance;
+        s.readPos += static_cast<uint64_t>(advance);
+    }
+
+    s.consumed.store(s.readPos, std::memory_order_release);
+}
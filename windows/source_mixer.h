@@ -0,0 +1,69 @@
+#ifndef SOURCE_MIXER_H_
+#define SOURCE_MIXER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Drift and buffering state of one mixed-in source
+struct MixSourceStats
+{
+    int rate = 0;           // nominal rate of the source device
+    double driftPpm = 0.0;  // estimated source clock vs master clock
+    double fillMs = 0.0;    // smoothed delay between the source and the mix
+    int64_t underruns = 0;  // mix calls that ran out of source audio
+    int64_t overruns = 0;   // pushes that found the ring full
+    int64_t resyncs = 0;    // jumps back to the target fill
+};
+
+// Mixes secondary capture streams (e.g. a microphone) into the master
+// stream (the loopback capture, whose packets drive the analysis).
+//
+// Each source has its own lock-free ring, written by its capture thread.
+// The master thread reads it through a windowed-sinc resampler whose ratio
+// is the nominal rate ratio trimmed by a PI loop on the delay between the
+// source and the mix, measured with the packets' capture timestamps: the
+// two device clocks are independent, and the loop holds that delay at a
+// fixed target, so the source stays at a constant offset from the master
+// however long the session runs. The integral term is the drift estimate.
+class SourceMixer
+{
+public:
+    SourceMixer();
+    ~SourceMixer();
+
+    // master (output) format; resets every source's resampler
+    void Configure(int rate, int channels);
+
+    // sources are added and cleared only while no capture thread runs
+    int AddSource(float gain);
+    void ClearSources();
+    int source_count() const { return static_cast<int>(sources_.size()); }
+
+    // source capture thread: interleaved frames at the source's own rate;
+    // the first two channels are kept (mono feeds both). time is the
+    // capture time of the first frame, on the clock Mix is given.
+    void Push(int source, const float *samples, int frames, int channels, int rate, double time);
+
+    // master thread: the master frames (first one captured at time) with
+    // every source added to the first two channels; valid until the next call
+    const float *Mix(const float *samples, int frames, double time);
+
+    MixSourceStats source_stats(int source) const;
+
+private:
+    struct Source;
+
+    int rate_;
+    int channels_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    std::vector<float> mixed_;
+    mutable std::mutex statsLock_;
+
+    void design(Source &s, int rate);
+    void mixSource(Source &s, int frames, double time);
+};
+
+#endif // SOURCE_MIXER_H_
@@ -0,0 +1,69 @@
+#include "spectrogram_history.h"
+
+#include <algorithm>
+
+SpectrogramHistory::SpectrogramHistory()
+    : rows_(0),
+      bins_(0),
+      rowBytes_(0),
+      format_(HistoryFormat::R8),
+      head_(-1)
+{
+}
+
+void SpectrogramHistory::Configure(int rows, int bins, HistoryFormat format)
+{
+    rows_ = std::max(0, rows);
+    bins_ = std::max(1, bins);
+    format_ = format;
+    head_ = -1;
+
+    switch (format_)
+    {
+    case HistoryFormat::R16:
+        rowBytes_ = bins_ * 2;
+        break;
+    case HistoryFormat::RGBA8:
+        rowBytes_ = (bins_ + 3) / 4 * 4;
+        break;
+    default:
+        rowBytes_ = bins_;
+        break;
+    }
+
+    pixels_.assign(static_cast<size_t>(rows_) * rowBytes_, 0);
+}
+
+void SpectrogramHistory::Append(const std::vector<Real> &bins)
+{
+    if (!enabled())
+        return;
+
+    // a band-count change (e.g. from the quality governor) restarts the history
+    int count = static_cast<int>(bins.size());
+    if (count != bins_)
+        Configure(rows_, count, format_);
+
+    head_ = (head_ + 1) % rows_;
+    uint8_t *dst = pixels_.data() + static_cast<size_t>(head_) * rowBytes_;
+
+    if (format_ == HistoryFormat::R16)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            Real v = std::clamp(bins[i], Real(0), Real(1));
+            uint16_t q = static_cast<uint16_t>(v * Real(65535) + Real(0.5));
+            dst[2 * i] = static_cast<uint8_t>(q & 0xFF);
+            dst[2 * i + 1] = static_cast<uint8_t>(q >> 8);
+        }
+        return;
+    }
+
+    // R8 and RGBA8 share the byte-per-bin layout; RGBA8 only pads the tail
+    for (int i = 0; i < count; ++i)
+    {
+        Real v = std::clamp(bins[i], Real(0), Real(1));
+        dst[i] = static_cast<uint8_t>(v * Real(255) + Real(0.5));
+    }
+    std::fill(dst + count, dst + rowBytes_, static_cast<uint8_t>(0));
+}
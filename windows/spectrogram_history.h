@@ -0,0 +1,51 @@
+#ifndef SPECTROGRAM_HISTORY_H_
+#define SPECTROGRAM_HISTORY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "dsp_types.h"
+
+// Texel layout of the history buffer.
+enum class HistoryFormat
+{
+    R8,    // one byte per bin
+    R16,   // two bytes per bin, little endian
+    RGBA8, // four consecutive bins per RGBA texel
+};
+
+// Ring of past spectra, quantized and laid out row-major so the whole buffer
+// can be uploaded as a texture. Only the newest row changes per frame; the
+// head index says which one, so consumers can patch a mirror in place.
+class SpectrogramHistory
+{
+public:
+    SpectrogramHistory();
+
+    // rows = 0 disables the history
+    void Configure(int rows, int bins, HistoryFormat format);
+
+    bool enabled() const { return rows_ > 0; }
+
+    // quantize bins (0..1) into the next row and advance the head
+    void Append(const std::vector<Real> &bins);
+
+    int rows() const { return rows_; }
+    int row_bytes() const { return rowBytes_; }
+    HistoryFormat format() const { return format_; }
+
+    // row written by the last Append (-1 before the first frame)
+    int head() const { return head_; }
+    const uint8_t *row(int index) const { return pixels_.data() + static_cast<size_t>(index) * rowBytes_; }
+    const std::vector<uint8_t> &pixels() const { return pixels_; }
+
+private:
+    int rows_;
+    int bins_;
+    int rowBytes_;
+    HistoryFormat format_;
+    int head_;
+    std::vector<uint8_t> pixels_;
+};
+
+#endif // SPECTROGRAM_HISTORY_H_
@@ -0,0 +1,135 @@
+#include "spectrum_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(SAV_DSP_DOUBLE) && (defined(_M_X64) || defined(__SSE2__))
+#include <emmintrin.h>
+#define SAV_SPECTRUM_SSE 1
+#endif
+
+namespace
+{
+    // log2(m) = 2/ln2 * atanh(s), s = (m-1)/(m+1); with m in [sqrt(.5), sqrt(2))
+    // |s| < 0.1716 and the s^9 remainder is below 5e-8.
+    const float kC1 = 2.8853900817779268f; // 2/ln2
+    const float kC3 = 0.9617966939259756f; // 2/(3 ln2)
+    const float kC5 = 0.5770780163555853f; // 2/(5 ln2)
+    const float kC7 = 0.4121985831111324f; // 2/(7 ln2)
+    const float kSqrt2 = 1.41421356f;
+    const float kLog10Of2 = 0.30102999566f;
+    const float kMinPower = 1e-30f; // -300 dB
+
+#ifdef SAV_SPECTRUM_SSE
+    inline __m128 fastLog2Ps(__m128 x)
+    {
+        __m128i bits = _mm_castps_si128(x);
+        __m128i exp = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                 _mm_set1_epi32(0x3F800000)));
+
+        // fold the mantissa into [sqrt(.5), sqrt(2))
+        __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(kSqrt2));
+        m = _mm_or_ps(_mm_andnot_ps(big, m), _mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+        __m128 e = _mm_add_ps(_mm_cvtepi32_ps(exp), _mm_and_ps(big, _mm_set1_ps(1.0f)));
+
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+        __m128 s2 = _mm_mul_ps(s, s);
+        __m128 p = _mm_add_ps(_mm_set1_ps(kC5), _mm_mul_ps(s2, _mm_set1_ps(kC7)));
+        p = _mm_add_ps(_mm_set1_ps(kC3), _mm_mul_ps(s2, p));
+        p = _mm_add_ps(_mm_set1_ps(kC1), _mm_mul_ps(s2, p));
+        return _mm_add_ps(e, _mm_mul_ps(s, p));
+    }
+#endif
+}
+
+float FastLog2(float x)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float e = static_cast<float>(static_cast<int>((bits >> 23) & 0xFF) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+
+    if (m > kSqrt2)
+    {
+        m *= 0.5f;
+        e += 1.0f;
+    }
+
+    float s = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    return e + s * (kC1 + s2 * (kC3 + s2 * (kC5 + s2 * kC7)));
+}
+
+Real SpectrumLog10(Real x, SpectrumMath math)
+{
+    if (math == SpectrumMath::Exact)
+        return std::log10(x);
+    return static_cast<Real>(FastLog2(static_cast<float>(x)) * kLog10Of2);
+}
+
+Real SpectrumPass(const Complex *data, int n, Real *mags, Real *powerDb, SpectrumMath math)
+{
+    Real peak = 0;
+    int k = 0;
+
+    if (math == SpectrumMath::Exact)
+    {
+        for (; k < n; ++k)
+        {
+            Real re = data[k].real();
+            Real im = data[k].imag();
+            mags[k] = std::hypot(re, im);
+            peak = std::max(peak, mags[k]);
+            if (powerDb)
+                powerDb[k] = Real(10) * std::log10(std::max(re * re + im * im, Real(kMinPower)));
+        }
+        return peak;
+    }
+
+#ifdef SAV_SPECTRUM_SSE
+    // 4 bins per iteration: deinterleave re/im, |X|^2, sqrt, running max, log
+    const float *src = reinterpret_cast<const float *>(data);
+    __m128 vpeak = _mm_setzero_ps();
+    const __m128 minPower = _mm_set1_ps(kMinPower);
+    const __m128 dbScale = _mm_set1_ps(10.0f * kLog10Of2);
+
+    for (; k + 4 <= n; k += 4)
+    {
+        __m128 lo = _mm_loadu_ps(src + 2 * k);
+        __m128 hi = _mm_loadu_ps(src + 2 * k + 4);
+        __m128 re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        __m128 mag = _mm_sqrt_ps(power);
+
+        _mm_storeu_ps(mags + k, mag);
+        vpeak = _mm_max_ps(vpeak, mag);
+
+        if (powerDb)
+            _mm_storeu_ps(powerDb + k, _mm_mul_ps(dbScale, fastLog2Ps(_mm_max_ps(power, minPower))));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, vpeak);
+    peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+
+    for (; k < n; ++k)
+    {
+        Real re = data[k].real();
+        Real im = data[k].imag();
+        Real power = re * re + im * im;
+        mags[k] = std::sqrt(power);
+        peak = std::max(peak, mags[k]);
+        if (powerDb)
+            powerDb[k] = static_cast<Real>(10.0f * kLog10Of2 *
+                                           FastLog2(static_cast<float>(std::max(power, Real(kMinPower)))));
+    }
+    return peak;
+}
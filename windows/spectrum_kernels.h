@@ -0,0 +1,28 @@
+#ifndef SPECTRUM_KERNELS_H_
+#define SPECTRUM_KERNELS_H_
+
+#include "dsp_types.h"
+
+// Post-FFT math. Exact uses libm (hypot/log10); Fast uses SSE square roots
+// and a polynomial log. Against libm (test/spectrum_kernels_test.cpp): the
+// fast log2 is within 2e-7 near 1 and within 4e-6 over 1e-30..1e30 (the
+// rest is float rounding of the exponent), |X| is within 1.2e-7 relative,
+// and per-bin dB is within 3e-5 dB for levels within +-150 dB and 5e-5 dB
+// down to the -300 dB floor, where the float result itself rounds.
+enum class SpectrumMath
+{
+    Exact,
+    Fast,
+};
+
+// One pass over n bins: mags[k] = |X[k]|, optionally powerDb[k] =
+// 10*log10(|X[k]|^2) (floored at -300 dB), returns max |X|.
+Real SpectrumPass(const Complex *data, int n, Real *mags, Real *powerDb, SpectrumMath math);
+
+// log10(x) for x > 0
+Real SpectrumLog10(Real x, SpectrumMath math);
+
+// scalar fast log2; exposed for band-level use
+float FastLog2(float x);
+
+#endif // SPECTRUM_KERNELS_H_
@@ -1,6 +1,22 @@
 #include "system_audio_visualizer_plugin.h"
 #include "wasapi_capture.h"
 #include "fft_processor.h"
+#include "quality_governor.h"
+#include "polyphase_decimator.h"
+#include "waveform_stream.h"
+#include "spectrogram_history.h"
+#include "loudness_meter.h"
+#include "chroma_extractor.h"
+#include "peak_tracker.h"
+#include "harmonic_percussive.h"
+#include "session_recorder.h"
+#include "session_reader.h"
+#include "source_mixer.h"
+#include "analysis_graph.h"
+#include "analysis_stages.h"
+#include "frame_interpolator.h"
+#include "frame_encoder.h"
+#include "render_geometry.h"
 
 #include <flutter/encodable_value.h>
 #include <flutter/event_channel.h>
@@ -9,8 +25,14 @@
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <chrono>
 
@@ -18,6 +40,116 @@ namespace system_audio_visualizer
 {
   using namespace flutter;
 
+  namespace
+  {
+    // Reads a numeric entry from the method call's argument map.
+    double GetNumberArg(const EncodableValue *args, const char *key, double fallback)
+    {
+      if (!args)
+        return fallback;
+      const auto *map = std::get_if<EncodableMap>(args);
+      if (!map)
+        return fallback;
+      auto it = map->find(EncodableValue(key));
+      if (it == map->end())
+        return fallback;
+      if (const auto *i = std::get_if<int32_t>(&it->second))
+        return *i;
+      if (const auto *l = std::get_if<int64_t>(&it->second))
+        return static_cast<double>(*l);
+      if (const auto *d = std::get_if<double>(&it->second))
+        return *d;
+      return fallback;
+    }
+
+    bool GetBoolArg(const EncodableValue *args, const char *key, bool fallback)
+    {
+      if (!args)
+        return fallback;
+      const auto *map = std::get_if<EncodableMap>(args);
+      if (!map)
+        return fallback;
+      auto it = map->find(EncodableValue(key));
+      if (it == map->end())
+        return fallback;
+      if (const auto *b = std::get_if<bool>(&it->second))
+        return *b;
+      return fallback;
+    }
+
+    std::string GetStringArg(const EncodableValue *args, const char *key, const std::string &fallback)
+    {
+      if (!args)
+        return fallback;
+      const auto *map = std::get_if<EncodableMap>(args);
+      if (!map)
+        return fallback;
+      auto it = map->find(EncodableValue(key));
+      if (it == map->end())
+        return fallback;
+      if (const auto *str = std::get_if<std::string>(&it->second))
+        return *str;
+      return fallback;
+    }
+
+    // Fills out with the strings of a list entry; false if the key is absent
+    bool GetStringListArg(const EncodableValue *args, const char *key, std::vector<std::string> &out)
+    {
+      if (!args)
+        return false;
+      const auto *map = std::get_if<EncodableMap>(args);
+      if (!map)
+        return false;
+      auto it = map->find(EncodableValue(key));
+      if (it == map->end())
+        return false;
+      const auto *list = std::get_if<EncodableList>(&it->second);
+      if (!list)
+        return false;
+      out.clear();
+      for (const EncodableValue &item : *list)
+      {
+        if (const auto *str = std::get_if<std::string>(&item))
+          out.push_back(*str);
+      }
+      return true;
+    }
+
+    bool Contains(const std::vector<std::string> &names, const char *name)
+    {
+      return std::find(names.begin(), names.end(), name) != names.end();
+    }
+
+    GeometryLayout ParseGeometryLayout(const std::string &name)
+    {
+      if (name == "bars")
+        return GeometryLayout::Bars;
+      if (name == "petals")
+        return GeometryLayout::Petals;
+      if (name == "wave")
+        return GeometryLayout::Wave;
+      return GeometryLayout::None;
+    }
+
+    // peak capacity when "peaks" is requested as a stage without a count
+    constexpr int kDefaultPeakCount = 8;
+
+    WindowType ParseWindowType(const std::string &name)
+    {
+      if (name == "hamming")
+        return WindowType::Hamming;
+      if (name == "blackmanHarris")
+        return WindowType::BlackmanHarris;
+      if (name == "kaiser")
+        return WindowType::Kaiser;
+      if (name == "flatTop")
+        return WindowType::FlatTop;
+      return WindowType::Hann;
+    }
+
+    using Clock = std::chrono::steady_clock;
+  } // namespace
+
   class SystemAudioVisualizerPluginImpl : public Plugin
   {
   public:
@@ -38,17 +170,91 @@ namespace system_audio_visualizer
           {
             if (call.method_name() == "start")
             {
-              bool ok = StartCapture();
-              if (ok)
+              std::string error;
+              if (StartCapture(call.arguments(), error))
                 result->Success();
               else
-                result->Error("init_failed", "Failed to initialize WASAPI capture");
+                result->Error("init_failed", error);
             }
             else if (call.method_name() == "stop")
             {
               StopCapture();
               result->Success();
             }
+            else if (call.method_name() == "setStages")
+            {
+              std::string error;
+              std::vector<std::string> stages;
+              GetStringListArg(call.arguments(), "stages", stages);
+              if (SetStages(stages, error))
+                result->Success();
+              else
+                result->Error("invalid_stages", error);
+            }
+            else if (call.method_name() == "setGeometry")
+            {
+              // picked up by the geometry stage at its next frame
+              SetGeometry(call.arguments());
+              result->Success();
+            }
+            else if (call.method_name() == "sampleSpectrum")
+            {
+              // display-time spectrum; delayMs shifts the request back from
+              // now to line the picture up with what is heard
+              double delay = GetNumberArg(call.arguments(), "delayMs", 0.0) / 1000.0;
+              std::vector<float> bins;
+              if (interpolator_.Sample(WasapiCapture::ClockNow() - delay, bins) == FrameSample::None)
+                result->Success();
+              else
+                result->Success(EncodableValue(bins));
+            }
+            else if (call.method_name() == "getStats")
+            {
+              result->Success(EncodableValue(GetStats()));
+            }
+            else if (call.method_name() == "resetLoudness")
+            {
+              // consumed by the capture thread, which owns the meter
+              loudnessReset_ = true;
+              result->Success();
+            }
+            else if (call.method_name() == "getSpectrogram")
+            {
+              result->Success(EncodableValue(GetSpectrogram()));
+            }
+            else if (call.method_name() == "startRecording")
+            {
+              if (StartRecording(call.arguments()))
+                result->Success();
+              else
+                result->Error("record_failed", "Capture is not running or the file cannot be created");
+            }
+            else if (call.method_name() == "stopRecording")
+            {
+              StopRecording();
+              result->Success();
+            }
+            else if (call.method_name() == "startReplay")
+            {
+              if (StartReplay(call.arguments()))
+                result->Success();
+              else
+                result->Error("replay_failed", "Capture is running or the session file is invalid");
+            }
+            else if (call.method_name() == "seekReplay")
+            {
+              {
+                std::lock_guard<std::mutex> lock(replay_mutex_);
+                replaySeek_ = std::max(0.0, GetNumberArg(call.arguments(), "position", 0.0));
+              }
+              replayWake_.notify_all();
+              result->Success();
+            }
+            else if (call.method_name() == "stopReplay")
+            {
+              StopReplay();
+              result->Success();
+            }
             else
             {
               result->NotImplemented();
@@ -68,6 +274,8 @@ namespace system_audio_visualizer
               {
                 std::lock_guard<std::mutex> lock(event_mutex_);
                 event_sink_ = std::move(events);
+                // a new listener has no state for delta packets
+                encoder_.RequestKeyframe();
                 return nullptr;
               },
               [this](const EncodableValue *)
@@ -78,83 +286,962 @@ namespace system_audio_visualizer
               });
 
       event_channel_->SetStreamHandler(std::move(handler));
+
+      // ------------------ Waveform Channel ------------------
+      waveform_channel_ = std::make_unique<EventChannel<EncodableValue>>(
+          messenger_, "system_audio_visualizer/waveform",
+          &StandardMethodCodec::GetInstance());
+
+      auto waveformHandler =
+          std::make_unique<StreamHandlerFunctions<EncodableValue>>(
+              [this](
+                  const EncodableValue *,
+                  std::unique_ptr<EventSink<EncodableValue>> &&events)
+              {
+                std::lock_guard<std::mutex> lock(event_mutex_);
+                waveform_sink_ = std::move(events);
+                waveformActive_ = true;
+                return nullptr;
+              },
+              [this](const EncodableValue *)
+              {
+                std::lock_guard<std::mutex> lock(event_mutex_);
+                waveformActive_ = false;
+                waveform_sink_.reset();
+                return nullptr;
+              });
+
+      waveform_channel_->SetStreamHandler(std::move(waveformHandler));
     }
 
-    ~SystemAudioVisualizerPluginImpl() override { StopCapture(); }
+    ~SystemAudioVisualizerPluginImpl() override
+    {
+      StopReplay();
+      StopCapture();
+    }
 
   private:
     // ----------------------- Audio Capture -----------------------
-    bool StartCapture()
+    bool StartCapture(const EncodableValue *args, std::string &error)
     {
       if (running_)
         return true;
 
+      // live capture takes the event stream back from a replay
+      StopReplay();
+
+      int fftSize = static_cast<int>(GetNumberArg(args, "fftSize", 2048));
+      int binCount = static_cast<int>(GetNumberArg(args, "bins", 64));
+      double cpuBudget = GetNumberArg(args, "cpuBudget", 0.0);
+      analysisRate_ = static_cast<int>(GetNumberArg(args, "analysisRate", 48000));
+
+      fft_.Configure(fftSize, binCount);
+      fft_.SetHop(static_cast<int>(GetNumberArg(args, "hop", 0)));
+      interpolator_.Reset();
+
+      std::string binEncoding = GetStringArg(args, "binEncoding", "float");
+      encoder_.Configure(binEncoding == "u8"    ? BinEncoding::Q8
+                         : binEncoding == "u16" ? BinEncoding::Q16
+                                                : BinEncoding::Float,
+                         GetNumberArg(args, "deltaThreshold", 0.0),
+                         static_cast<int>(GetNumberArg(args, "keyframeInterval", 30)));
+      binBytes_ = 0;
+      floatBinBytes_ = 0;
+      interpolator_.SetMaxExtrapolation(GetNumberArg(args, "maxExtrapolationMs", 50.0) / 1000.0);
+      fft_.SetMath(GetBoolArg(args, "fastMath", true) ? SpectrumMath::Fast : SpectrumMath::Exact);
+      fft_.SetWindow(ParseWindowType(GetStringArg(args, "window", "hann")),
+                     GetNumberArg(args, "kaiserBeta", 8.6));
+      fft_.SetOutputScale(GetStringArg(args, "scale", "normalized") == "dbfs"
+                              ? OutputScale::Dbfs
+                              : OutputScale::Normalized,
+                          GetNumberArg(args, "floorDb", -90.0),
+                          GetNumberArg(args, "ceilingDb", 0.0),
+                          GetBoolArg(args, "autoGain", false));
+
+      std::string stereo = GetStringArg(args, "stereo", "off");
+      stereoEnabled_ = stereo != "off";
+      stereoPair_ = stereo == "midSide" ? StereoPair::MidSide : StereoPair::LeftRight;
+      fft_.SetStereo(stereoEnabled_, stereoPair_);
+
+      std::string historyFormat = GetStringArg(args, "historyFormat", "r8");
+      {
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        historySent_ = -1;
+        history_.Configure(static_cast<int>(GetNumberArg(args, "historyRows", 0)),
+                           fft_.output_bins(),
+                           historyFormat == "r16"     ? HistoryFormat::R16
+                           : historyFormat == "rgba8" ? HistoryFormat::RGBA8
+                                                      : HistoryFormat::R8);
+      }
+
+      governorEnabled_ = cpuBudget > 0.0;
+      governor_.SetBaseline(fft_.window_size(), fft_.output_bins());
+      baseFftSize_ = fft_.window_size();
+      baseBins_ = fft_.output_bins();
+      if (governorEnabled_)
+        governor_.SetBudget(cpuBudget);
+      ApplyQualityMode();
+
+      std::string realtime = GetStringArg(args, "realtime", "audio");
+      RealtimeClass realtimeClass = realtime == "off"        ? RealtimeClass::Off
+                                    : realtime == "proAudio" ? RealtimeClass::ProAudio
+                                                             : RealtimeClass::Audio;
+      capture_->SetRealtime(realtimeClass);
+
       if (!capture_->Initialize())
       {
+        error = "Failed to initialize WASAPI capture";
+        return false;
+      }
+
+      // An optional microphone is mixed into the loopback stream, which
+      // stays the master clock; a missing microphone does not fail start.
+      mixer_.ClearSources();
+      microphone_.reset();
+      if (GetBoolArg(args, "microphone", false))
+      {
+        auto microphone = std::make_unique<WasapiCapture>(CaptureEndpoint::Microphone);
+        microphone->SetRealtime(realtimeClass);
+        if (microphone->Initialize())
+        {
+          int source = mixer_.AddSource(static_cast<float>(GetNumberArg(args, "microphoneGain", 1.0)));
+          WasapiCapture *mic = microphone.get();
+          if (microphone->Start([this, source, mic](const float *samples, int sampleCount, double time)
+                                { mixer_.Push(source, samples, sampleCount / std::max(1, mic->channels()),
+                                              mic->channels(), mic->sample_rate(), time); }))
+          {
+            microphone_ = std::move(microphone);
+            // the loopback goes quiet between tracks; silent master blocks
+            // keep the microphone mixed and the drift loop running
+            capture_->SetIdleFill(true);
+          }
+          else
+            mixer_.ClearSources();
+        }
+      }
+
+      waveformSpanMs_ = static_cast<int>(GetNumberArg(args, "waveformSpanMs", 50));
+      waveformPoints_ = static_cast<int>(GetNumberArg(args, "waveformPoints", 512));
+      scopePoints_ = static_cast<int>(GetNumberArg(args, "scopePoints", 256));
+      chromaEnabled_ = GetBoolArg(args, "chroma", false);
+      peakCount_ = static_cast<int>(GetNumberArg(args, "peaks", 0));
+      peakFloorDb_ = GetNumberArg(args, "peakFloorDb", -80.0);
+      peaksEnabled_ = peakCount_ > 0;
+      hpssEnabled_ = GetBoolArg(args, "hpss", false);
+      hpss_.Configure(static_cast<int>(GetNumberArg(args, "hpssTimeFrames", 17)),
+                      static_cast<int>(GetNumberArg(args, "hpssFreqBins", 17)));
+      loudnessEnabled_ = GetBoolArg(args, "loudness", false);
+      geometryEnabled_ = GetBoolArg(args, "geometry", false);
+
+      // An explicit stage list overrides the feature flags; without one the
+      // flags pick the stages.
+      std::vector<std::string> stages;
+      if (GetStringListArg(args, "stages", stages))
+      {
+        loudnessEnabled_ = Contains(stages, "loudness");
+        chromaEnabled_ = Contains(stages, "chroma");
+        peaksEnabled_ = Contains(stages, "peaks");
+        hpssEnabled_ = Contains(stages, "hpss");
+        geometryEnabled_ = Contains(stages, "geometry");
+        if (peaksEnabled_ && peakCount_ <= 0)
+          peakCount_ = kDefaultPeakCount;
+      }
+      else
+      {
+        stages = {"waveform"};
+        if (loudnessEnabled_)
+          stages.push_back("loudness");
+        if (chromaEnabled_)
+          stages.push_back("chroma");
+        if (peaksEnabled_)
+          stages.push_back("peaks");
+        if (hpssEnabled_)
+          stages.push_back("hpss");
+        if (history_.enabled())
+          stages.push_back("history");
+        if (geometryEnabled_)
+          stages.push_back("geometry");
+      }
+      ConfigureDeviceStages(capture_->sample_rate(), capture_->channels(), capture_->channel_mask(), true);
+
+      graph_ = MakeGraph(stages, error);
+      if (!graph_)
+      {
+        StopMicrophone();
         return false;
       }
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.stages = graph_->order();
+        recordPeakCapacity_ = peaksEnabled_ ? peakCount_ : 0;
+      }
+
+      // A default-device switch keeps the FFT ring and band tables; only
+      // the stages that depend on the device format follow it.
+      capture_->SetFormatCallback([this](int rate, int ch, uint32_t mask)
+                                  { ConfigureDeviceStages(rate, ch, mask, false); });
+
+      lastFrame_ = Clock::now();
+      binRateStart_ = lastFrame_;
 
       bool started = capture_->Start(
-          [this](const float *samples, int sampleCount)
+          [this](const float *samples, int sampleCount, double time)
           {
-            // Convert stereo -> mono if needed
-            std::vector<float> mono;
-            mono.reserve(sampleCount);
+            Clock::time_point begin = Clock::now();
+            blockStart_ = begin;
 
-            if (sampleCount >= 2 && (sampleCount % 2) == 0)
-            {
-              for (int i = 0; i + 1 < sampleCount; i += 2)
-              {
-                float m = 0.5f * (samples[i] + samples[i + 1]);
-                mono.push_back(m);
-              }
-            }
-            else
+            // a graph from setStages takes over between blocks
+            if (graphPending_.exchange(false))
+              SwapGraph();
+
+            int ch = channels_;
+            int frames = sampleCount / ch;
+
+            // every later stage sees the mix
+            if (microphone_)
+              samples = mixer_.Mix(samples, frames, time);
+            blockEnd_ = time + static_cast<double>(frames) / deviceRate_;
+
+            // downmix/split, decimation, spectrum, features and publishing;
+            // see MakeGraph for the stage set
+            graph_->Run(samples, frames, ch);
+
+            // load is measured against the audio the block covered, not the
+            // wall-clock gap: a drained backlog arrives back to back and
+            // would read as full load
+            double processing = std::chrono::duration<double>(Clock::now() - begin).count();
+            double period = static_cast<double>(frames) / deviceRate_;
+            if (governorEnabled_ && governor_.Update(processing, period))
             {
-              mono.assign(samples, samples + sampleCount);
+              ApplyQualityMode();
             }
 
-            // Feed FFT
-            fft_.PushSamples(mono.data(), (int)mono.size());
-
-            // Try output
-            std::vector<double> bins;
-            if (fft_.GetBins(bins))
+            double rateWindow = std::chrono::duration<double>(begin - binRateStart_).count();
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            if (rateWindow >= 1.0)
             {
-              SendBins(bins);
+              stats_.binBytesPerSec = static_cast<double>(binBytes_) / rateWindow;
+              stats_.floatBinBytesPerSec = static_cast<double>(floatBinBytes_) / rateWindow;
+              binBytes_ = 0;
+              floatBinBytes_ = 0;
+              binRateStart_ = begin;
             }
+            stats_.callbacks++;
+            stats_.lastProcessingSec = processing;
+            stats_.maxProcessingSec = std::max(stats_.maxProcessingSec, processing);
+            stats_.cpuLoad = governor_.load();
+            stats_.gainDb = fft_.gain_db();
+            stats_.catchUpFrames = catchUpFrames_;
+            stats_.skippedFrames = fft_.skipped_frames();
           });
 
       if (!started)
+      {
+        StopMicrophone();
+        graph_.reset();
+        error = "Failed to start WASAPI capture";
         return false;
+      }
 
       running_ = true;
       return true;
     }
 
+    // Stages that depend on the device rate / channel count. Rate-dependent
+    // analysis (chroma, peaks) is rebuilt only if the analysis rate moved.
+    void ConfigureDeviceStages(int rate, int ch, uint32_t channel_mask, bool initial)
+    {
+      int previousAnalysisRate = decimator_.output_rate();
+
+      // High-rate devices are brought down to the analysis rate before the
+      // ring buffer so bin spacing and band tables match on every device.
+      decimator_.Configure(rate, analysisRate_);
+      decimatorRight_.Configure(rate, analysisRate_);
+      channels_ = std::max(1, ch);
+      deviceRate_ = rate;
+      channelMask_ = channel_mask;
+      mixer_.Configure(rate, channels_);
+      waveform_.Configure(rate, waveformSpanMs_, waveformPoints_, scopePoints_);
+
+      if (initial || decimator_.output_rate() != previousAnalysisRate)
+      {
+        chroma_.Configure(decimator_.output_rate());
+        peaks_.Configure(peakCount_, decimator_.output_rate(), peakFloorDb_);
+      }
+      if (loudnessEnabled_)
+        loudness_.Configure(rate, channels_, channelMask_);
+
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.sampleRate = rate;
+      stats_.analysisRate = decimator_.output_rate();
+    }
+
     void StopCapture()
     {
       if (!running_)
         return;
       capture_->Stop();
+      StopMicrophone();
       running_ = false;
+      StopRecording();
+
+      // the capture thread is gone, so the graphs can go too
+      graphPending_ = false;
+      graph_.reset();
+      std::lock_guard<std::mutex> lock(graph_mutex_);
+      pendingGraph_.reset();
+      retiredGraph_.reset();
+    }
+
+    void StopMicrophone()
+    {
+      if (microphone_)
+        microphone_->Stop();
+      microphone_.reset();
+      capture_->SetIdleFill(false);
+      mixer_.ClearSources();
+    }
+
+    // ----------------------- Analysis graph -----------------------
+    // Every stage is available; Build activates the requested ones and
+    // their producers. "publish" consumes bands plus the requested outputs,
+    // so it runs after all of them and only when a new frame was taken.
+    std::unique_ptr<AnalysisGraph> MakeGraph(const std::vector<std::string> &requested, std::string &error)
+    {
+      auto graph = std::make_unique<AnalysisGraph>();
+      if (stereoEnabled_)
+      {
+        graph->Add(std::make_unique<SplitStage>());
+        graph->Add(std::make_unique<DecimateStage>("decimate", "left", "analysis", decimator_));
+        graph->Add(std::make_unique<DecimateStage>("decimateRight", "right", "analysisRight", decimatorRight_));
+      }
+      else
+      {
+        graph->Add(std::make_unique<DownmixStage>());
+        graph->Add(std::make_unique<DecimateStage>("decimate", "mono", "analysis", decimator_));
+      }
+
+      graph->Add(std::make_unique<SpectrumStage>(fft_, stereoEnabled_, [this]
+                                                 { return FrameDue(); }));
+      graph->Add(std::make_unique<LoudnessStage>(loudness_, loudnessReset_));
+      graph->Add(std::make_unique<WaveformStage>(waveform_, waveformActive_));
+      graph->Add(std::make_unique<ChromaStage>(chroma_));
+      graph->Add(std::make_unique<PeaksStage>(peaks_));
+      graph->Add(std::make_unique<HpssStage>(hpss_, fft_));
+      graph->Add(std::make_unique<HistoryStage>(history_, history_mutex_));
+      graph->Add(std::make_unique<GeometryStage>(geometry_));
+
+      // every analysed frame (catch-up included) is stamped with the
+      // capture time of its window centre for display-time resampling
+      graph->Add(std::make_unique<CallbackStage>(
+          "timeline", std::vector<std::string>{"bands"}, std::vector<std::string>{},
+          [this](const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &)
+          {
+            double lag = fft_.frame_lag() + 0.5 * fft_.window_size();
+            interpolator_.Push(blockEnd_ - lag / std::max(1, decimator_.output_rate()), in[0]->values);
+            return true;
+          }));
+
+      std::vector<std::string> published{"bands"};
+      for (const std::string &name : requested)
+      {
+        const GraphStage *stage = graph->find(name);
+        if (!stage)
+        {
+          error = "unknown stage '" + name + "'";
+          return nullptr;
+        }
+        published.insert(published.end(), stage->outputs().begin(), stage->outputs().end());
+      }
+      graph->Add(std::make_unique<CallbackStage>(
+          "publish", published, std::vector<std::string>{},
+          [this](const std::vector<GraphSignal *> &in, const std::vector<GraphSignal *> &)
+          {
+            // a catch-up backlog is analysed frame by frame, but only its
+            // newest frame goes out
+            if (in[0]->remaining > 0)
+            {
+              catchUpFrames_++;
+              return false;
+            }
+            if (!FrameDue())
+              return false;
+
+            lastFrame_ = blockStart_;
+            const std::vector<Real> &bins = in[0]->values;
+            SendBins(bins);
+            if (recording_)
+              RecordFrame(bins, blockStart_);
+
+            if (waveformActive_ && graph_->active("waveform"))
+            {
+              waveform_.Build();
+              SendWaveform();
+            }
+            return true;
+          }));
+
+      GraphFormat format;
+      format.channels = std::max(1, capture_->channels());
+      format.maxBlockFrames = std::max(4096, capture_->sample_rate() / 10);
+      format.fftSize = baseFftSize_;
+      format.bins = baseBins_;
+
+      std::vector<std::string> roots(requested);
+      roots.push_back("timeline");
+      roots.push_back("publish");
+      if (!graph->Build(roots, format, error))
+        return nullptr;
+      return graph;
+    }
+
+    // rate-limited when the governor stretched the frame interval
+    bool FrameDue() const
+    {
+      return frameIntervalMs_ == 0 ||
+             blockStart_ - lastFrame_ >= std::chrono::milliseconds(frameIntervalMs_);
+    }
+
+    // Platform thread: the new graph is built here and handed over; the
+    // capture thread swaps it in at the start of its next block, so stage
+    // changes never stop the stream or reset analysis state.
+    bool SetStages(const std::vector<std::string> &stages, std::string &error)
+    {
+      if (!running_)
+      {
+        error = "Capture is not running";
+        return false;
+      }
+
+      std::unique_ptr<AnalysisGraph> graph = MakeGraph(stages, error);
+      if (!graph)
+        return false;
+
+      // the graph retired by the previous swap is freed here, off the
+      // capture thread
+      std::unique_ptr<AnalysisGraph> retired;
+      {
+        std::lock_guard<std::mutex> lock(graph_mutex_);
+        retired = std::move(retiredGraph_);
+        pendingGraph_ = std::move(graph);
+      }
+      graphPending_ = true;
+      return true;
+    }
+
+    // Viewport for the native draw buffers; the defaults are the constants
+    // the Dart painters use, with the count picked per layout
+    void SetGeometry(const EncodableValue *args)
+    {
+      GeometryViewport viewport;
+      viewport.layout = ParseGeometryLayout(GetStringArg(args, "layout", "none"));
+      viewport.width = GetNumberArg(args, "width", 0.0);
+      viewport.height = GetNumberArg(args, "height", 0.0);
+      viewport.pad = GetNumberArg(args, "pad", viewport.pad);
+      viewport.count = static_cast<int>(GetNumberArg(args, "count", DefaultGeometryCount(viewport.layout)));
+      viewport.intensity = GetNumberArg(args, "intensity", viewport.intensity);
+      viewport.cornerRadius = GetNumberArg(args, "cornerRadius", viewport.cornerRadius);
+      viewport.barFill = GetNumberArg(args, "barFill", viewport.barFill);
+      viewport.capHeight = GetNumberArg(args, "capHeight", viewport.capHeight);
+      viewport.capDecay = GetNumberArg(args, "capDecay", viewport.capDecay);
+      viewport.ringRadius = GetNumberArg(args, "ringRadius", viewport.ringRadius);
+      viewport.petalShape = GetNumberArg(args, "petalShape", viewport.petalShape);
+      geometry_.Configure(viewport);
+    }
+
+    // Capture thread. Only a graph that has never run is taken from the
+    // pending slot, so a flag left set by a SetStages that raced the last
+    // swap finds it empty. The replaced graph is parked in the retired slot
+    // and freed by the next SetStages (or stop), off the capture thread.
+    void SwapGraph()
+    {
+      {
+        std::lock_guard<std::mutex> lock(graph_mutex_);
+        if (!pendingGraph_)
+          return;
+        retiredGraph_ = std::move(graph_);
+        graph_ = std::move(pendingGraph_);
+      }
+
+      // stages that were off have not followed the device format
+      bool loudness = graph_->active("loudness");
+      if (loudness && !loudnessEnabled_)
+        loudness_.Configure(deviceRate_, channels_, channelMask_);
+      loudnessEnabled_ = loudness;
+
+      // the tracker always holds at least one peak, so an unconfigured
+      // count is the test
+      bool peaks = graph_->active("peaks");
+      if (peaks && peakCount_ <= 0)
+      {
+        peakCount_ = kDefaultPeakCount;
+        peaks_.Configure(peakCount_, decimator_.output_rate(), peakFloorDb_);
+      }
+      peaksEnabled_ = peaks;
+      chromaEnabled_ = graph_->active("chroma");
+      hpssEnabled_ = graph_->active("hpss");
+      geometryEnabled_ = graph_->active("geometry");
+
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.stages = graph_->order();
+      recordPeakCapacity_ = peaksEnabled_ ? peakCount_ : 0;
+    }
+
+    // ----------------------- Session recording -----------------------
+    // The governor only steps down from the start configuration, so the
+    // start band count is the frame capacity for the whole recording.
+    bool StartRecording(const EncodableValue *args)
+    {
+      std::string path = GetStringArg(args, "path", "");
+      if (!running_ || path.empty())
+        return false;
+
+      StopRecording();
+      int rate = 0;
+      int peakCapacity = 0;
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        rate = stats_.analysisRate;
+        peakCapacity = recordPeakCapacity_;
+      }
+      if (!recorder_.Open(path, static_cast<uint32_t>(rate), static_cast<uint32_t>(baseFftSize_),
+                          static_cast<uint32_t>(baseBins_), static_cast<uint32_t>(peakCapacity)))
+        return false;
+
+      recordStart_ = Clock::now();
+      recording_ = true;
+      return true;
+    }
+
+    void StopRecording()
+    {
+      recording_ = false;
+      recorder_.Close();
+    }
+
+    // Capture thread: copies the frame into the recorder's batch; the file
+    // is written by the recorder's own thread.
+    void RecordFrame(const std::vector<Real> &bins, Clock::time_point now)
+    {
+      recordBins_.resize(bins.size());
+      for (size_t i = 0; i < bins.size(); ++i)
+        recordBins_[i] = static_cast<float>(bins[i]);
+
+      int peakCount = peaksEnabled_ ? peaks_.count() : 0;
+      recordPeaks_.resize(static_cast<size_t>(peakCount));
+      for (int i = 0; i < peakCount; ++i)
+      {
+        const SpectralPeak &peak = peaks_.peaks()[i];
+        recordPeaks_[i] = {peak.id, peak.age, static_cast<float>(peak.frequency),
+                           static_cast<float>(peak.level_db)};
+      }
+
+      float features[kSessionFeatures];
+      std::fill(features, features + kSessionFeatures, NAN);
+      if (loudnessEnabled_)
+      {
+        features[kFeatureMomentary] = static_cast<float>(loudness_.momentary());
+        features[kFeatureShortTerm] = static_cast<float>(loudness_.short_term());
+        features[kFeatureIntegrated] = static_cast<float>(loudness_.integrated());
+        features[kFeatureTruePeak] = static_cast<float>(loudness_.true_peak_db());
+      }
+      if (chromaEnabled_)
+      {
+        features[kFeatureTuningCents] = static_cast<float>(chroma_.tuning_cents());
+        features[kFeaturePitchClass] = static_cast<float>(chroma_.pitch_class());
+        const std::vector<Real> &classes = chroma_.chroma();
+        for (size_t i = 0; i < classes.size() && i < 12; ++i)
+          features[kFeatureChroma + i] = static_cast<float>(classes[i]);
+      }
+
+      recorder_.Append(std::chrono::duration<double>(now - recordStart_).count(),
+                       recordBins_.data(), static_cast<int>(recordBins_.size()),
+                       recordPeaks_.data(), peakCount, features);
+    }
+
+    // ----------------------- Session replay -----------------------
+    // Replays a recording through the fft event channel on its own
+    // timeline, so Dart sees the same frames as during the live session.
+    bool StartReplay(const EncodableValue *args)
+    {
+      if (running_)
+        return false;
+
+      StopReplay();
+      if (!replay_.Open(GetStringArg(args, "path", "")) || replay_.frame_count() == 0)
+      {
+        replay_.Close();
+        return false;
+      }
+
+      replaySpeed_ = std::max(0.01, GetNumberArg(args, "speed", 1.0));
+      replayLoop_ = GetBoolArg(args, "loop", false);
+      {
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        replayStop_ = false;
+        replaySeek_ = std::max(0.0, GetNumberArg(args, "position", 0.0));
+      }
+
+      replaying_ = true;
+      replayThread_ = std::thread([this]
+                                  { ReplayLoop(); });
+      return true;
+    }
+
+    void StopReplay()
+    {
+      {
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        replayStop_ = true;
+      }
+      replayWake_.notify_all();
+      if (replayThread_.joinable())
+        replayThread_.join();
+      replay_.Close();
+      replaying_ = false;
+    }
+
+    void ReplayLoop()
+    {
+      SessionFrame frame;
+      int64_t next = 0;
+      Clock::time_point origin = Clock::now();
+      double originTime = 0.0;
+
+      std::unique_lock<std::mutex> lock(replay_mutex_);
+      while (!replayStop_)
+      {
+        // (re)anchor the recorded timeline to the wall clock
+        if (replaySeek_ >= 0.0)
+        {
+          next = std::max<int64_t>(0, replay_.Seek(replaySeek_));
+          replaySeek_ = -1.0;
+          origin = Clock::now();
+          originTime = replay_.FrameTime(next);
+        }
+
+        if (next >= replay_.frame_count())
+        {
+          if (!replayLoop_)
+            break;
+          replaySeek_ = 0.0;
+          continue;
+        }
+
+        replay_.ReadFrame(next, frame);
+        Clock::time_point due =
+            origin + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>((frame.time - originTime) / replaySpeed_));
+        if (replayWake_.wait_until(lock, due, [this]
+                                   { return replayStop_ || replaySeek_ >= 0.0; }))
+          continue;
+
+        lock.unlock();
+        SendReplayFrame(frame);
+        lock.lock();
+        next++;
+      }
+      replaying_ = false;
+    }
+
+    // Pushes the governor's current rung into the FFT and frame pacing.
+    void ApplyQualityMode()
+    {
+      const QualityMode &mode = governor_.mode();
+      fft_.Configure(mode.fftSize, mode.bins);
+      frameIntervalMs_ = mode.frameIntervalMs;
+
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.qualityLevel = governor_.level();
+      stats_.fftSize = fft_.window_size();
+      stats_.bins = fft_.output_bins();
+      stats_.frameIntervalMs = frameIntervalMs_;
+    }
+
+    EncodableMap GetStats()
+    {
+      CaptureStats capture = capture_->stats();
+      MixSourceStats mic = mixer_.source_stats(0);
+      InterpolatorStats display = interpolator_.stats();
+
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      EncodableList stages;
+      for (const std::string &name : stats_.stages)
+        stages.push_back(EncodableValue(name));
+      return EncodableMap{
+          {EncodableValue("running"), EncodableValue(running_.load())},
+          {EncodableValue("callbacks"), EncodableValue(stats_.callbacks)},
+          {EncodableValue("lastProcessingMs"), EncodableValue(stats_.lastProcessingSec * 1000.0)},
+          {EncodableValue("maxProcessingMs"), EncodableValue(stats_.maxProcessingSec * 1000.0)},
+          {EncodableValue("sampleRate"), EncodableValue(stats_.sampleRate)},
+          {EncodableValue("analysisRate"), EncodableValue(stats_.analysisRate)},
+          {EncodableValue("governor"), EncodableValue(governorEnabled_)},
+          {EncodableValue("cpuLoad"), EncodableValue(stats_.cpuLoad)},
+          {EncodableValue("cpuBudget"), EncodableValue(governorEnabled_ ? governor_.budget() : 0.0)},
+          {EncodableValue("gainDb"), EncodableValue(stats_.gainDb)},
+          {EncodableValue("qualityLevel"), EncodableValue(stats_.qualityLevel)},
+          {EncodableValue("fftSize"), EncodableValue(stats_.fftSize)},
+          {EncodableValue("bins"), EncodableValue(stats_.bins)},
+          {EncodableValue("frameIntervalMs"), EncodableValue(stats_.frameIntervalMs)},
+          {EncodableValue("hop"), EncodableValue(fft_.hop())},
+          {EncodableValue("catchUpFrames"), EncodableValue(stats_.catchUpFrames)},
+          {EncodableValue("skippedFrames"), EncodableValue(stats_.skippedFrames)},
+          {EncodableValue("eventDriven"), EncodableValue(capture.eventDriven)},
+          {EncodableValue("wakeups"), EncodableValue(capture.wakeups)},
+          {EncodableValue("idleWakeups"), EncodableValue(capture.idleWakeups)},
+          {EncodableValue("idleFills"), EncodableValue(capture.idleFills)},
+          {EncodableValue("packets"), EncodableValue(capture.packets)},
+          {EncodableValue("captureLatencyMs"), EncodableValue(capture.lastLatencyMs)},
+          {EncodableValue("maxCaptureLatencyMs"), EncodableValue(capture.maxLatencyMs)},
+          {EncodableValue("captureJitterMs"), EncodableValue(capture.jitterMs)},
+          {EncodableValue("realtime"), EncodableValue(capture.realtime)},
+          {EncodableValue("deadlineMisses"), EncodableValue(capture.deadlineMisses)},
+          {EncodableValue("worstLatenessMs"), EncodableValue(capture.worstLatenessMs)},
+          {EncodableValue("deviceSwitches"), EncodableValue(capture.deviceSwitches)},
+          {EncodableValue("lastSwitchGapMs"), EncodableValue(capture.lastSwitchGapMs)},
+          {EncodableValue("microphone"), EncodableValue(microphone_ != nullptr)},
+          {EncodableValue("microphoneRate"), EncodableValue(mic.rate)},
+          {EncodableValue("microphoneDriftPpm"), EncodableValue(mic.driftPpm)},
+          {EncodableValue("microphoneDelayMs"), EncodableValue(mic.fillMs)},
+          {EncodableValue("microphoneUnderruns"), EncodableValue(mic.underruns)},
+          {EncodableValue("microphoneOverruns"), EncodableValue(mic.overruns)},
+          {EncodableValue("microphoneResyncs"), EncodableValue(mic.resyncs)},
+          {EncodableValue("recording"), EncodableValue(recording_.load())},
+          {EncodableValue("recordedFrames"), EncodableValue(static_cast<int64_t>(recorder_.frames()))},
+          {EncodableValue("recordDrops"), EncodableValue(static_cast<int64_t>(recorder_.dropped()))},
+          {EncodableValue("recordWriteError"), EncodableValue(recorder_.write_error())},
+          {EncodableValue("replaying"), EncodableValue(replaying_.load())},
+          {EncodableValue("stages"), EncodableValue(stages)},
+          {EncodableValue("interpolatedSamples"), EncodableValue(display.interpolated)},
+          {EncodableValue("extrapolatedSamples"), EncodableValue(display.extrapolated)},
+          {EncodableValue("heldSamples"), EncodableValue(display.held)},
+          {EncodableValue("displayLeadMs"), EncodableValue(display.lastLeadMs)},
+          {EncodableValue("binBytesPerSec"), EncodableValue(stats_.binBytesPerSec)},
+          {EncodableValue("floatBinBytesPerSec"), EncodableValue(stats_.floatBinBytesPerSec)},
+          {EncodableValue("binEncoding"),
+           EncodableValue(encoder_.encoding() == BinEncoding::Q8    ? "u8"
+                          : encoder_.encoding() == BinEncoding::Q16 ? "u16"
+                                                                    : "float")},
+      };
     }
 
     // ----------------------- Streaming to Dart -----------------------
-    void SendBins(const std::vector<double> &bins)
+    // Bins go out as a typed list (Float32List, or Float64List in the
+    // double build) rather than a list of boxed doubles, or as a packed
+    // Uint8List with a compact binEncoding (see FrameEncoder). With extra
+    // analysis enabled the event becomes a map that carries the bins under
+    // "bins".
+    void SendBins(const std::vector<Real> &bins)
+    {
+      std::lock_guard<std::mutex> lock(event_mutex_);
+      if (!event_sink_)
+        return;
+
+      EncodableValue binsValue;
+      if (encoder_.encoding() == BinEncoding::Float)
+      {
+        binsValue = EncodableValue(bins);
+        binBytes_ += static_cast<int64_t>(bins.size() * sizeof(Real));
+      }
+      else
+      {
+        const std::vector<uint8_t> &packet = encoder_.Encode(bins);
+        binsValue = EncodableValue(packet);
+        binBytes_ += static_cast<int64_t>(packet.size());
+      }
+      floatBinBytes_ += static_cast<int64_t>(bins.size() * sizeof(float));
+
+      if (!fft_.stereo() && !history_.enabled() && !loudnessEnabled_ && !chromaEnabled_ &&
+          !peaksEnabled_ && !hpssEnabled_ && !geometryEnabled_)
+      {
+        event_sink_->Success(binsValue);
+        return;
+      }
+
+      EncodableMap frame{{EncodableValue("bins"), binsValue}};
+
+      if (fft_.stereo())
+      {
+        const StereoBands &stereo = fft_.stereo_bands();
+        bool midSide = stereoPair_ == StereoPair::MidSide;
+        frame[EncodableValue(midSide ? "mid" : "left")] = EncodableValue(stereo.first);
+        frame[EncodableValue(midSide ? "side" : "right")] = EncodableValue(stereo.second);
+        frame[EncodableValue("correlation")] = EncodableValue(stereo.correlation);
+        frame[EncodableValue("balance")] = EncodableValue(stereo.balance);
+      }
+
+      if (chromaEnabled_)
+      {
+        frame[EncodableValue("chroma")] = EncodableValue(chroma_.chroma());
+        frame[EncodableValue("pitchClass")] = EncodableValue(chroma_.pitch_class());
+        frame[EncodableValue("tuningCents")] = EncodableValue(chroma_.tuning_cents());
+      }
+
+      // sparse peak record: parallel id / Hz / dBFS / age lists, strongest first
+      if (peaksEnabled_)
+      {
+        int count = peaks_.count();
+        std::vector<int32_t> ids(count);
+        std::vector<int32_t> ages(count);
+        std::vector<float> freqs(count);
+        std::vector<float> levels(count);
+        for (int i = 0; i < count; ++i)
+        {
+          const SpectralPeak &peak = peaks_.peaks()[i];
+          ids[i] = peak.id;
+          ages[i] = peak.age;
+          freqs[i] = static_cast<float>(peak.frequency);
+          levels[i] = static_cast<float>(peak.level_db);
+        }
+        frame[EncodableValue("peakIds")] = EncodableValue(ids);
+        frame[EncodableValue("peakFreqs")] = EncodableValue(freqs);
+        frame[EncodableValue("peakLevels")] = EncodableValue(levels);
+        frame[EncodableValue("peakAges")] = EncodableValue(ages);
+      }
+
+      if (hpssEnabled_)
+      {
+        frame[EncodableValue("harmonic")] = EncodableValue(graph_->signal("harmonic")->values);
+        frame[EncodableValue("percussive")] = EncodableValue(graph_->signal("percussive")->values);
+      }
+
+      if (loudnessEnabled_)
+      {
+        frame[EncodableValue("loudness")] = EncodableValue(EncodableMap{
+            {EncodableValue("momentary"), EncodableValue(loudness_.momentary())},
+            {EncodableValue("shortTerm"), EncodableValue(loudness_.short_term())},
+            {EncodableValue("integrated"), EncodableValue(loudness_.integrated())},
+            {EncodableValue("truePeak"), EncodableValue(loudness_.true_peak_db())},
+        });
+      }
+
+      // draw buffers for the configured viewport, empty ones left out
+      if (geometryEnabled_ && graph_->signal("geometry")->fresh)
+      {
+        EncodableMap geometry;
+        auto add = [&geometry](const char *key, const std::vector<float> &values)
+        {
+          if (!values.empty())
+            geometry[EncodableValue(key)] = EncodableValue(values);
+        };
+        add("triangles", geometry_.triangles());
+        add("caps", geometry_.caps());
+        add("lines", geometry_.lines());
+        add("polyline", geometry_.polyline());
+        frame[EncodableValue("geometry")] = EncodableValue(geometry);
+      }
+
+      // only the rows added since the last frame travel (one, or a
+      // catch-up backlog oldest first); Dart patches its mirror in place
+      if (history_.enabled() && history_.head() >= 0)
+      {
+        std::lock_guard<std::mutex> historyLock(history_mutex_);
+        int head = history_.head();
+        int rows = history_.rows();
+        int count = historySent_ < 0 ? 1 : (head - historySent_ + rows) % rows;
+        count = std::clamp(count, 1, rows);
+        historySent_ = head;
+
+        size_t rowBytes = static_cast<size_t>(history_.row_bytes());
+        std::vector<uint8_t> block(rowBytes * count);
+        for (int i = 0; i < count; ++i)
+        {
+          const uint8_t *row = history_.row((head - count + 1 + i + rows) % rows);
+          std::copy(row, row + rowBytes, block.begin() + rowBytes * i);
+        }
+        frame[EncodableValue("historyRow")] = EncodableValue(block);
+        frame[EncodableValue("historyHead")] = EncodableValue(head);
+        frame[EncodableValue("historyRows")] = EncodableValue(rows);
+        if (count > 1)
+          frame[EncodableValue("historyCount")] = EncodableValue(count);
+      }
+
+      event_sink_->Success(EncodableValue(frame));
+    }
+
+    // Same keys as a live frame for whatever was recorded, plus replayTime
+    void SendReplayFrame(const SessionFrame &frame)
     {
       std::lock_guard<std::mutex> lock(event_mutex_);
       if (!event_sink_)
         return;
 
-      EncodableList list;
-      list.reserve(bins.size());
-      for (double v : bins)
+      EncodableMap map{
+          {EncodableValue("bins"), EncodableValue(std::vector<Real>(frame.bins.begin(), frame.bins.end()))},
+          {EncodableValue("replayTime"), EncodableValue(frame.time)},
+      };
+
+      if (!std::isnan(frame.features[kFeatureChroma]))
+      {
+        map[EncodableValue("chroma")] = EncodableValue(std::vector<Real>(
+            frame.features + kFeatureChroma, frame.features + kFeatureChroma + 12));
+        map[EncodableValue("pitchClass")] =
+            EncodableValue(static_cast<int32_t>(frame.features[kFeaturePitchClass]));
+        map[EncodableValue("tuningCents")] =
+            EncodableValue(static_cast<double>(frame.features[kFeatureTuningCents]));
+      }
+
+      if (replay_.header().peakCapacity > 0)
+      {
+        size_t count = frame.peaks.size();
+        std::vector<int32_t> ids(count);
+        std::vector<int32_t> ages(count);
+        std::vector<float> freqs(count);
+        std::vector<float> levels(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+          ids[i] = frame.peaks[i].id;
+          ages[i] = frame.peaks[i].age;
+          freqs[i] = frame.peaks[i].frequency;
+          levels[i] = frame.peaks[i].levelDb;
+        }
+        map[EncodableValue("peakIds")] = EncodableValue(ids);
+        map[EncodableValue("peakFreqs")] = EncodableValue(freqs);
+        map[EncodableValue("peakLevels")] = EncodableValue(levels);
+        map[EncodableValue("peakAges")] = EncodableValue(ages);
+      }
+
+      if (!std::isnan(frame.features[kFeatureMomentary]))
       {
-        list.emplace_back(EncodableValue(v));
+        map[EncodableValue("loudness")] = EncodableValue(EncodableMap{
+            {EncodableValue("momentary"), EncodableValue(static_cast<double>(frame.features[kFeatureMomentary]))},
+            {EncodableValue("shortTerm"), EncodableValue(static_cast<double>(frame.features[kFeatureShortTerm]))},
+            {EncodableValue("integrated"), EncodableValue(static_cast<double>(frame.features[kFeatureIntegrated]))},
+            {EncodableValue("truePeak"), EncodableValue(static_cast<double>(frame.features[kFeatureTruePeak]))},
+        });
       }
 
-      event_sink_->Success(EncodableValue(list));
+      event_sink_->Success(EncodableValue(map));
+    }
+
+    // Full history snapshot, used to seed a Dart mirror
+    EncodableMap GetSpectrogram()
+    {
+      std::lock_guard<std::mutex> lock(history_mutex_);
+      const char *format = history_.format() == HistoryFormat::R16     ? "r16"
+                           : history_.format() == HistoryFormat::RGBA8 ? "rgba8"
+                                                                       : "r8";
+      return EncodableMap{
+          {EncodableValue("rows"), EncodableValue(history_.rows())},
+          {EncodableValue("rowBytes"), EncodableValue(history_.row_bytes())},
+          {EncodableValue("format"), EncodableValue(format)},
+          {EncodableValue("head"), EncodableValue(history_.head())},
+          {EncodableValue("pixels"), EncodableValue(history_.pixels())},
+      };
+    }
+
+    void SendWaveform()
+    {
+      std::lock_guard<std::mutex> lock(event_mutex_);
+      if (!waveform_sink_)
+        return;
+
+      waveform_sink_->Success(EncodableValue(EncodableMap{
+          {EncodableValue("min"), EncodableValue(waveform_.envelope_min())},
+          {EncodableValue("max"), EncodableValue(waveform_.envelope_max())},
+          {EncodableValue("scopeL"), EncodableValue(waveform_.scope_left())},
+          {EncodableValue("scopeR"), EncodableValue(waveform_.scope_right())},
+      }));
     }
 
     // Members
@@ -162,11 +1249,122 @@ namespace system_audio_visualizer
     std::unique_ptr<MethodChannel<EncodableValue>> method_channel_;
     std::unique_ptr<EventChannel<EncodableValue>> event_channel_;
     std::unique_ptr<EventSink<EncodableValue>> event_sink_;
+    std::unique_ptr<EventChannel<EncodableValue>> waveform_channel_;
+    std::unique_ptr<EventSink<EncodableValue>> waveform_sink_;
+    std::atomic<bool> waveformActive_{false};
     std::mutex event_mutex_;
 
     std::unique_ptr<WasapiCapture> capture_;
+    std::unique_ptr<WasapiCapture> microphone_; // optional, mixed into capture_
+    SourceMixer mixer_;
     FFTProcessor fft_;
     std::atomic<bool> running_{false};
+
+    PolyphaseDecimator decimator_;      // mono, or left in stereo mode
+    PolyphaseDecimator decimatorRight_; // stereo mode only
+    int channels_ = 2;
+    int deviceRate_ = 48000;
+    uint32_t channelMask_ = 0; // speaker bits of the device channels
+    int analysisRate_ = 48000;
+    bool stereoEnabled_ = false;
+    StereoPair stereoPair_ = StereoPair::LeftRight;
+
+    WaveformStream waveform_;
+    int waveformSpanMs_ = 50;
+    int waveformPoints_ = 512;
+    int scopePoints_ = 256;
+
+    ChromaExtractor chroma_; // capture thread only
+    bool chromaEnabled_ = false;
+
+    PeakTracker peaks_; // capture thread only
+    bool peaksEnabled_ = false;
+    int peakCount_ = 0;
+    double peakFloorDb_ = -80.0;
+
+    HarmonicPercussive hpss_; // capture thread only
+    bool hpssEnabled_ = false;
+
+    RenderGeometry geometry_; // viewport from the platform thread
+    bool geometryEnabled_ = false;
+
+    LoudnessMeter loudness_; // capture thread only
+    bool loudnessEnabled_ = false;
+    std::atomic<bool> loudnessReset_{false};
+
+    SpectrogramHistory history_;
+    std::mutex history_mutex_;
+    int historySent_ = -1; // head of the last published frame
+
+    // Session recording (frames are copied on the capture thread)
+    SessionRecorder recorder_;
+    std::atomic<bool> recording_{false};
+    Clock::time_point recordStart_;
+    int recordPeakCapacity_ = 0; // peak slots for a new recording; stats_mutex_
+    std::vector<float> recordBins_;
+    std::vector<SessionPeak> recordPeaks_;
+    int baseFftSize_ = 2048;
+    int baseBins_ = 64;
+
+    // Session replay (only while capture is stopped)
+    SessionReader replay_;
+    std::thread replayThread_;
+    std::mutex replay_mutex_;
+    std::condition_variable replayWake_;
+    bool replayStop_ = false;  // guarded by replay_mutex_
+    double replaySeek_ = -1.0; // guarded by replay_mutex_; < 0 = none
+    double replaySpeed_ = 1.0;
+    bool replayLoop_ = false;
+    std::atomic<bool> replaying_{false};
+
+    // Analysis graph, run by the capture thread; setStages hands a
+    // replacement over through the pending slot
+    std::unique_ptr<AnalysisGraph> graph_;
+    std::unique_ptr<AnalysisGraph> pendingGraph_; // guarded by graph_mutex_; never run
+    std::unique_ptr<AnalysisGraph> retiredGraph_; // guarded by graph_mutex_
+    std::atomic<bool> graphPending_{false};
+    std::mutex graph_mutex_;
+    Clock::time_point blockStart_; // capture time base of the current block
+    double blockEnd_ = 0.0;        // capture clock (s) after the block's last frame
+
+    // Analysis frames resampled to display time (sampleSpectrum)
+    FrameInterpolator interpolator_;
+
+    // Bin packing for the event channel; byte counts are per rate window
+    FrameEncoder encoder_;
+    int64_t binBytes_ = 0;
+    int64_t floatBinBytes_ = 0; // the same bins as a Float32List
+    Clock::time_point binRateStart_;
+
+    // Adaptive quality (optional, enabled by a cpuBudget start argument)
+    QualityGovernor governor_;
+    bool governorEnabled_ = false;
+    int frameIntervalMs_ = 0;
+    int64_t catchUpFrames_ = 0; // analysed but superseded within their block
+    Clock::time_point lastFrame_;
+
+    // Counters reported by getStats
+    struct Stats
+    {
+      int64_t callbacks = 0;
+      double lastProcessingSec = 0.0;
+      double maxProcessingSec = 0.0;
+      double cpuLoad = 0.0;
+      double gainDb = 0.0;
+      int qualityLevel = 0;
+      int fftSize = 0;
+      int bins = 0;
+      int frameIntervalMs = 0;
+      int64_t catchUpFrames = 0;
+      int64_t skippedFrames = 0;
+      double binBytesPerSec = 0.0;
+      double floatBinBytesPerSec = 0.0;
+      int sampleRate = 0;
+      int analysisRate = 0;
+      std::vector<std::string> stages; // active, in run order
+    };
+    Stats stats_;
+    std::mutex stats_mutex_;
   };
 
   // ----------------------------- Registration -----------------------------
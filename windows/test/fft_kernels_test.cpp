@@ -0,0 +1,253 @@
+#define _USE_MATH_DEFINES
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "fft_kernels.h"
+#include "mixed_radix_fft.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // Worst bin error relative to the RMS of the reference spectrum.
+#ifdef SAV_DSP_DOUBLE
+    constexpr double kMaxError = 1e-12;
+#else
+    constexpr double kMaxError = 2e-6;
+#endif
+
+    std::vector<Complex> RandomSignal(int n, unsigned seed)
+    {
+      std::mt19937 rng(seed);
+      std::uniform_real_distribution<double> dist(-1.0, 1.0);
+      std::vector<Complex> data(n);
+      for (Complex &x : data)
+        x = Complex(static_cast<Real>(dist(rng)), static_cast<Real>(dist(rng)));
+      return data;
+    }
+
+    // Direct O(n^2) forward DFT in double; k*t is reduced mod n so every
+    // twiddle comes from one exactly rounded table entry.
+    std::vector<std::complex<double>> ReferenceDFT(const std::vector<Complex> &in)
+    {
+      const int n = static_cast<int>(in.size());
+      std::vector<std::complex<double>> w(n);
+      for (int k = 0; k < n; ++k)
+      {
+        double angle = -2.0 * M_PI * k / n;
+        w[k] = std::complex<double>(std::cos(angle), std::sin(angle));
+      }
+      std::vector<std::complex<double>> out(n);
+      for (int k = 0; k < n; ++k)
+      {
+        std::complex<double> sum = 0.0;
+        long long index = 0;
+        for (int t = 0; t < n; ++t)
+        {
+          sum += std::complex<double>(in[t].real(), in[t].imag()) * w[index];
+          index += k;
+          if (index >= n)
+            index -= n;
+        }
+        out[k] = sum;
+      }
+      return out;
+    }
+
+    double RelativeError(const std::vector<Complex> &got,
+                         const std::vector<std::complex<double>> &want)
+    {
+      double worst = 0.0;
+      double energy = 0.0;
+      for (size_t k = 0; k < want.size(); ++k)
+      {
+        std::complex<double> g(got[k].real(), got[k].imag());
+        worst = std::max(worst, std::abs(g - want[k]));
+        energy += std::norm(want[k]);
+      }
+      return worst / std::sqrt(energy / want.size());
+    }
+
+    // The radix-2 loop FFTProcessor::computeFFT runs for sizes without a
+    // specialized kernel, with its twiddles rounded once from double.
+    class GenericFFT
+    {
+    public:
+      explicit GenericFFT(int n) : n_(n), twiddles_(n / 2)
+      {
+        for (int k = 0; k < n / 2; ++k)
+        {
+          double angle = -2.0 * M_PI * k / n;
+          twiddles_[k] = Complex(static_cast<Real>(std::cos(angle)),
+                                 static_cast<Real>(std::sin(angle)));
+        }
+      }
+
+      void Transform(Complex *data) const
+      {
+        int j = 0;
+        for (int i = 0; i < n_; ++i)
+        {
+          if (i < j)
+            std::swap(data[i], data[j]);
+          int m = n_ >> 1;
+          while (j >= m && m > 0)
+          {
+            j -= m;
+            m >>= 1;
+          }
+          j += m;
+        }
+
+        for (int len = 2; len <= n_; len <<= 1)
+        {
+          int half = len >> 1;
+          int stride = n_ / len;
+          for (int i = 0; i < n_; i += len)
+          {
+            for (int k = 0; k < half; ++k)
+            {
+              Complex u = data[i + k];
+              Complex v = data[i + k + half] * twiddles_[k * stride];
+              data[i + k] = u + v;
+              data[i + k + half] = u - v;
+            }
+          }
+        }
+      }
+
+    private:
+      int n_;
+      std::vector<Complex> twiddles_;
+    };
+
+    TEST(FFTKernels, OnlyPowerOfTwoSizesFrom512To4096)
+    {
+      EXPECT_EQ(FindFFTKernel(256), nullptr);
+      EXPECT_EQ(FindFFTKernel(960), nullptr);
+      EXPECT_EQ(FindFFTKernel(8192), nullptr);
+      for (int n = 512; n <= 4096; n <<= 1)
+        EXPECT_NE(FindFFTKernel(n), nullptr) << n;
+    }
+
+    TEST(FFTKernels, MatchReferenceDFT)
+    {
+      for (int n = 512; n <= 4096; n <<= 1)
+      {
+        FFTKernel kernel = FindFFTKernel(n);
+        ASSERT_NE(kernel, nullptr);
+        std::vector<Complex> signal = RandomSignal(n, n);
+        std::vector<std::complex<double>> want = ReferenceDFT(signal);
+
+        std::vector<Complex> fast = signal;
+        kernel(fast.data());
+        std::vector<Complex> generic = signal;
+        GenericFFT(n).Transform(generic.data());
+
+        double fastError = RelativeError(fast, want);
+        double genericError = RelativeError(generic, want);
+        EXPECT_LE(fastError, kMaxError) << n;
+        // the fused radix-4 passes must not cost accuracy
+        EXPECT_LE(fastError, 2.0 * genericError) << n;
+      }
+    }
+
+    TEST(FFTKernels, SingleToneLandsInItsBin)
+    {
+      const int n = 1024;
+      const int bin = 37;
+      std::vector<Complex> data(n);
+      for (int t = 0; t < n; ++t)
+      {
+        double angle = 2.0 * M_PI * bin * t / n;
+        data[t] = Complex(static_cast<Real>(std::cos(angle)), static_cast<Real>(std::sin(angle)));
+      }
+      FindFFTKernel(n)(data.data());
+      for (int k = 0; k < n; ++k)
+      {
+        double expected = k == bin ? n : 0.0;
+        EXPECT_NEAR(std::abs(data[k]), expected, 1e-3) << k;
+      }
+    }
+
+    TEST(MixedRadixFFT, MatchesReferenceDFT)
+    {
+      const int sizes[] = {2, 3, 5, 48, 480, 540, 960, 1125, 1440, 1920, 2400, 3840};
+      for (int n : sizes)
+      {
+        ASSERT_TRUE(MixedRadixFFT::IsSupportedSize(n)) << n;
+        MixedRadixFFT fft;
+        ASSERT_TRUE(fft.Plan(n)) << n;
+        ASSERT_EQ(fft.size(), n);
+
+        std::vector<Complex> data = RandomSignal(n, n + 1);
+        std::vector<std::complex<double>> want = ReferenceDFT(data);
+        fft.Transform(data.data());
+        EXPECT_LE(RelativeError(data, want), kMaxError) << n;
+      }
+    }
+
+    TEST(MixedRadixFFT, RejectsUnsupportedSizes)
+    {
+      MixedRadixFFT fft;
+      for (int n : {0, 1, 7, 14, 1001})
+      {
+        EXPECT_FALSE(MixedRadixFFT::IsSupportedSize(n)) << n;
+        EXPECT_FALSE(fft.Plan(n)) << n;
+        EXPECT_EQ(fft.size(), 0);
+      }
+    }
+
+    // Best-of-rounds time per transform, in microseconds. The input is
+    // restored before every call so repeated transforms cannot overflow;
+    // both paths pay the same copy.
+    template <typename Transform>
+    double TimeTransform(int n, Transform transform)
+    {
+      const std::vector<Complex> signal = RandomSignal(n, 7);
+      std::vector<Complex> data(n);
+      const int iterations = 1000;
+      double best = 1e30;
+      for (int round = 0; round < 5; ++round)
+      {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+          std::copy(signal.begin(), signal.end(), data.begin());
+          transform(data.data());
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / iterations);
+      }
+      EXPECT_TRUE(std::isfinite(std::abs(data[1])));
+      return best;
+    }
+
+    // Reproduces the kernel-vs-generic-loop benchmark. Timing only asserts
+    // in optimized builds; a debug build still prints the numbers.
+    TEST(FFTKernels, FasterThanGenericLoop)
+    {
+      for (int n = 512; n <= 4096; n <<= 1)
+      {
+        FFTKernel kernel = FindFFTKernel(n);
+        GenericFFT generic(n);
+        double fast = TimeTransform(n, kernel);
+        double slow = TimeTransform(n, [&generic](Complex *data) { generic.Transform(data); });
+        std::printf("N=%-5d %7.1f us vs %7.1f us  (%.1fx)\n", n, fast, slow, slow / fast);
+#ifdef NDEBUG
+        EXPECT_LT(fast, slow) << n;
+#endif
+      }
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
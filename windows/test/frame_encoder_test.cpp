@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "frame_encoder.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // Mirror of lib/analysis/bin_decoder.dart, check for check
+    struct Decoded
+    {
+      bool keyframe = false;
+      uint32_t sequence = 0;
+      int entries = 0;
+    };
+
+    class TestDecoder
+    {
+    public:
+      std::vector<float> values;
+
+      bool Decode(const std::vector<uint8_t> &packet, Decoded *info = nullptr)
+      {
+        if (packet.size() < FrameEncoder::kHeaderBytes || packet[0] != 1)
+          return false;
+        uint8_t flags = packet[1];
+        uint16_t bands = 0;
+        uint32_t sequence = 0;
+        float scale = 0.0f;
+        uint16_t entries = 0;
+        std::memcpy(&bands, &packet[2], 2);
+        std::memcpy(&sequence, &packet[4], 4);
+        std::memcpy(&scale, &packet[8], 4);
+        std::memcpy(&entries, &packet[12], 2);
+
+        bool wide = (flags & 2) != 0;
+        bool keyframe = (flags & 1) != 0;
+        double step = scale / (wide ? 65535.0 : 255.0);
+        if (info)
+          *info = {keyframe, sequence, entries};
+
+        size_t valueBytes = wide ? 2 : 1;
+        size_t entryBytes = keyframe ? valueBytes : 2 + valueBytes;
+        if ((keyframe && entries != bands) ||
+            packet.size() < FrameEncoder::kHeaderBytes + entries * entryBytes)
+        {
+          sequence_ = -1;
+          return synced_ = false;
+        }
+
+        bool inOrder = sequence_ >= 0 && sequence == static_cast<uint32_t>(sequence_ + 1);
+        sequence_ = sequence;
+
+        size_t offset = FrameEncoder::kHeaderBytes;
+        if (keyframe)
+        {
+          values.assign(bands, 0.0f);
+          for (int b = 0; b < entries; ++b)
+          {
+            values[b] = static_cast<float>(read(packet, offset, wide) * step);
+            offset += wide ? 2 : 1;
+          }
+          return synced_ = true;
+        }
+
+        if (!synced_ || !inOrder || values.size() != bands)
+          return synced_ = false;
+        for (int i = 0; i < entries; ++i)
+        {
+          uint16_t band = 0;
+          std::memcpy(&band, &packet[FrameEncoder::kHeaderBytes + i * entryBytes], 2);
+          if (band >= bands)
+            return synced_ = false;
+        }
+        for (int i = 0; i < entries; ++i)
+        {
+          uint16_t band = 0;
+          std::memcpy(&band, &packet[offset], 2);
+          values[band] = static_cast<float>(read(packet, offset + 2, wide) * step);
+          offset += wide ? 4 : 3;
+        }
+        return true;
+      }
+
+    private:
+      int64_t sequence_ = -1;
+      bool synced_ = false;
+
+      static int read(const std::vector<uint8_t> &packet, size_t offset, bool wide)
+      {
+        if (!wide)
+          return packet[offset];
+        uint16_t value = 0;
+        std::memcpy(&value, &packet[offset], 2);
+        return value;
+      }
+    };
+
+    std::vector<Real> RandomBins(std::mt19937 &rng, int bands)
+    {
+      std::uniform_real_distribution<double> level(0.0, 1.0);
+      std::vector<Real> bins(bands);
+      for (Real &bin : bins)
+        bin = static_cast<Real>(level(rng));
+      return bins;
+    }
+
+    TEST(FrameEncoder, KeyframesFollowTheInterval)
+    {
+      FrameEncoder encoder;
+      encoder.Configure(BinEncoding::Q8, 0.01, 5);
+      TestDecoder decoder;
+      std::mt19937 rng(49);
+      for (int frame = 0; frame < 23; ++frame)
+      {
+        Decoded info;
+        ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 64)), &info));
+        EXPECT_EQ(info.sequence, static_cast<uint32_t>(frame));
+        EXPECT_EQ(info.keyframe, frame % 5 == 0) << frame;
+      }
+
+      // without a threshold every packet is a keyframe
+      encoder.Configure(BinEncoding::Q8, 0.0, 5);
+      for (int frame = 0; frame < 7; ++frame)
+      {
+        Decoded info;
+        ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 64)), &info));
+        EXPECT_TRUE(info.keyframe);
+      }
+    }
+
+    // Deltas carry only the bands that moved past the threshold from what the
+    // decoder holds; since the encoder tracks the decoded values exactly,
+    // the error stays within threshold + half a step however long it runs.
+    TEST(FrameEncoder, DeltasStayWithinTheThreshold)
+    {
+      for (BinEncoding encoding : {BinEncoding::Q8, BinEncoding::Q16})
+      {
+        const double threshold = 0.02;
+        FrameEncoder encoder;
+        encoder.Configure(encoding, threshold, 5000);
+        TestDecoder decoder;
+
+        std::mt19937 rng(7);
+        std::normal_distribution<double> walk(0.0, 0.01);
+        std::vector<Real> bins = RandomBins(rng, 48);
+        double qmax = encoding == BinEncoding::Q16 ? 65535.0 : 255.0;
+        for (int frame = 0; frame < 2000; ++frame)
+        {
+          for (Real &bin : bins)
+            bin = static_cast<Real>(std::clamp(bin + walk(rng), 0.0, 1.0));
+
+          Decoded info;
+          ASSERT_TRUE(decoder.Decode(encoder.Encode(bins), &info));
+          ASSERT_EQ(decoder.values.size(), bins.size());
+          for (size_t b = 0; b < bins.size(); ++b)
+            ASSERT_LE(std::fabs(decoder.values[b] - bins[b]), threshold + 0.5 / qmax + 1e-6)
+                << frame << " band " << b;
+        }
+
+        // a frame that moves nothing sends nothing
+        Decoded info;
+        ASSERT_TRUE(decoder.Decode(encoder.Encode(bins), &info));
+        EXPECT_FALSE(info.keyframe);
+        EXPECT_EQ(info.entries, 0);
+      }
+    }
+
+    // A lost packet leaves the decoder out of sync until the next keyframe,
+    // which RequestKeyframe forces.
+    TEST(FrameEncoder, SequenceGapWaitsForAKeyframe)
+    {
+      FrameEncoder encoder;
+      encoder.Configure(BinEncoding::Q8, 0.01, 1000);
+      TestDecoder decoder;
+      std::mt19937 rng(3);
+
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 32))));
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 32))));
+      encoder.Encode(RandomBins(rng, 32)); // lost
+      EXPECT_FALSE(decoder.Decode(encoder.Encode(RandomBins(rng, 32))));
+      EXPECT_FALSE(decoder.Decode(encoder.Encode(RandomBins(rng, 32))));
+
+      encoder.RequestKeyframe();
+      std::vector<Real> bins = RandomBins(rng, 32);
+      Decoded info;
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(bins), &info));
+      EXPECT_TRUE(info.keyframe);
+      for (size_t b = 0; b < bins.size(); ++b)
+        EXPECT_NEAR(decoder.values[b], bins[b], 0.5 / 255.0 + 1e-6);
+      EXPECT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 32))));
+    }
+
+    TEST(FrameEncoder, BandCountChangeSendsAKeyframe)
+    {
+      FrameEncoder encoder;
+      encoder.Configure(BinEncoding::Q16, 0.01, 1000);
+      TestDecoder decoder;
+      std::mt19937 rng(11);
+
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 64))));
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 64))));
+
+      Decoded info;
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 32)), &info));
+      EXPECT_TRUE(info.keyframe);
+      EXPECT_EQ(info.entries, 32);
+      EXPECT_EQ(decoder.values.size(), 32u);
+
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 32)), &info));
+      EXPECT_FALSE(info.keyframe);
+    }
+
+    // The checks bin_decoder.dart makes before applying a packet: truncated
+    // packets and out-of-range bands are refused, nothing is half applied,
+    // and the next keyframe resyncs.
+    TEST(FrameEncoder, MalformedPacketsAreRefused)
+    {
+      FrameEncoder encoder;
+      encoder.Configure(BinEncoding::Q8, 0.01, 1000);
+      TestDecoder decoder;
+      std::mt19937 rng(5);
+
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 16))));
+      std::vector<float> held = decoder.values;
+
+      std::vector<uint8_t> truncated = encoder.Encode(RandomBins(rng, 16));
+      ASSERT_GT(truncated.size(), static_cast<size_t>(FrameEncoder::kHeaderBytes));
+      truncated.pop_back();
+      EXPECT_FALSE(decoder.Decode(truncated));
+      EXPECT_EQ(decoder.values, held);
+
+      encoder.RequestKeyframe();
+      ASSERT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 16))));
+      held = decoder.values;
+
+      std::vector<Real> moved(16, Real(0));
+      moved[0] = Real(1);
+      moved[15] = Real(1);
+      std::vector<uint8_t> badBand = encoder.Encode(moved);
+      ASSERT_FALSE(badBand[1] & 1);
+      uint16_t entries = 0;
+      std::memcpy(&entries, &badBand[12], 2);
+      ASSERT_GE(entries, 2);
+      uint16_t outOfRange = 16;
+      std::memcpy(&badBand[FrameEncoder::kHeaderBytes + 3 * (entries - 1)], &outOfRange, 2);
+      EXPECT_FALSE(decoder.Decode(badBand));
+      EXPECT_EQ(decoder.values, held);
+
+      encoder.RequestKeyframe();
+      EXPECT_TRUE(decoder.Decode(encoder.Encode(RandomBins(rng, 16))));
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "frame_interpolator.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    constexpr double kFrameRate = 47.0;
+    constexpr double kDisplayRate = 144.0;
+
+    // Band b ramps linearly in time, with a different slope per band.
+    std::vector<Real> Ramp(double time, int bands)
+    {
+      std::vector<Real> bins(bands);
+      for (int b = 0; b < bands; ++b)
+        bins[b] = static_cast<Real>(0.1 + 0.02 * (b + 1) * time);
+      return bins;
+    }
+
+    TEST(FrameInterpolator, NothingBeforeTheFirstFrame)
+    {
+      FrameInterpolator interpolator;
+      std::vector<float> out;
+      EXPECT_EQ(interpolator.Sample(0.0, out), FrameSample::None);
+    }
+
+    TEST(FrameInterpolator, InterpolatesARampBetweenFrames)
+    {
+      const int bands = 8;
+      FrameInterpolator interpolator;
+      std::vector<float> out;
+      double worst = 0.0;
+      int frame = 0;
+      // the display trails the newest frame by one frame period
+      for (int tick = 0; tick < 2000; ++tick)
+      {
+        double now = tick / kDisplayRate;
+        while (frame / kFrameRate <= now)
+        {
+          double time = frame / kFrameRate;
+          interpolator.Push(time, Ramp(time, bands));
+          ++frame;
+        }
+        double display = now - 1.0 / kFrameRate;
+        if (display <= 0.0)
+          continue;
+
+        ASSERT_EQ(interpolator.Sample(display, out), FrameSample::Interpolated) << tick;
+        ASSERT_EQ(out.size(), static_cast<size_t>(bands));
+        std::vector<Real> want = Ramp(display, bands);
+        for (int b = 0; b < bands; ++b)
+          worst = std::max(worst, std::fabs(out[b] - static_cast<double>(want[b])));
+      }
+      EXPECT_LE(worst, 1e-6);
+      EXPECT_GT(interpolator.stats().interpolated, 1900);
+      EXPECT_EQ(interpolator.stats().extrapolated, 0);
+    }
+
+    TEST(FrameInterpolator, ExtrapolatesUpToTheLimitThenHolds)
+    {
+      FrameInterpolator interpolator;
+      interpolator.SetMaxExtrapolation(0.03);
+      interpolator.Push(1.0, {0.2f, 0.5f, 0.9f});
+      interpolator.Push(1.02, {0.3f, 0.5f, 0.95f});
+
+      std::vector<float> out;
+      ASSERT_EQ(interpolator.Sample(1.03, out), FrameSample::Extrapolated);
+      EXPECT_NEAR(out[0], 0.35f, 1e-6);
+      EXPECT_NEAR(out[1], 0.5f, 1e-6);
+      EXPECT_NEAR(out[2], 0.975f, 1e-6);
+
+      // a rising band stops at the top of the range
+      ASSERT_EQ(interpolator.Sample(1.049, out), FrameSample::Extrapolated);
+      EXPECT_NEAR(out[0], 0.445f, 1e-6);
+      EXPECT_EQ(out[2], 1.0f);
+
+      // past the limit the newest frame is held, not the extrapolated value
+      ASSERT_EQ(interpolator.Sample(1.051, out), FrameSample::Held);
+      EXPECT_EQ(out[0], 0.3f);
+      EXPECT_EQ(out[1], 0.5f);
+      EXPECT_EQ(out[2], 0.95f);
+      EXPECT_NEAR(interpolator.stats().lastLeadMs, 31.0, 1e-6);
+
+      ASSERT_EQ(interpolator.Sample(2.0, out), FrameSample::Held);
+      EXPECT_EQ(out[0], 0.3f);
+
+      InterpolatorStats stats = interpolator.stats();
+      EXPECT_EQ(stats.extrapolated, 2);
+      EXPECT_EQ(stats.held, 2);
+    }
+
+    TEST(FrameInterpolator, FallingBandStopsAtZero)
+    {
+      FrameInterpolator interpolator;
+      interpolator.Push(0.0, {0.1f});
+      interpolator.Push(0.01, {0.02f});
+      std::vector<float> out;
+      ASSERT_EQ(interpolator.Sample(0.02, out), FrameSample::Extrapolated);
+      EXPECT_EQ(out[0], 0.0f);
+    }
+
+    TEST(FrameInterpolator, HoldsTheOldestFrameBeforeTheRing)
+    {
+      FrameInterpolator interpolator;
+      for (int i = 0; i < 20; ++i)
+        interpolator.Push(i * 0.01, {static_cast<Real>(i * 0.01)});
+
+      // eight frames are kept: 0.12 .. 0.19
+      std::vector<float> out;
+      ASSERT_EQ(interpolator.Sample(0.115, out), FrameSample::Held);
+      EXPECT_NEAR(out[0], 0.12f, 1e-6);
+      ASSERT_EQ(interpolator.Sample(0.125, out), FrameSample::Interpolated);
+      EXPECT_NEAR(out[0], 0.125f, 1e-6);
+    }
+
+    TEST(FrameInterpolator, TimeThatDoesNotAdvanceRestartsTheHistory)
+    {
+      FrameInterpolator interpolator;
+      interpolator.Push(1.0, {0.2f});
+      interpolator.Push(1.1, {0.4f});
+
+      std::vector<float> out;
+      ASSERT_EQ(interpolator.Sample(1.05, out), FrameSample::Interpolated);
+
+      // a clock step back (device switch) drops the older frames
+      interpolator.Push(0.5, {0.8f});
+      ASSERT_EQ(interpolator.Sample(0.51, out), FrameSample::Held);
+      EXPECT_EQ(out[0], 0.8f);
+      ASSERT_EQ(interpolator.Sample(0.4, out), FrameSample::Held);
+      EXPECT_EQ(out[0], 0.8f);
+
+      // so does a repeated timestamp
+      interpolator.Push(0.6, {0.6f});
+      ASSERT_EQ(interpolator.Sample(0.55, out), FrameSample::Interpolated);
+      EXPECT_NEAR(out[0], 0.7f, 1e-6);
+      interpolator.Push(0.6, {0.1f});
+      ASSERT_EQ(interpolator.Sample(0.55, out), FrameSample::Held);
+      EXPECT_EQ(out[0], 0.1f);
+      ASSERT_EQ(interpolator.Sample(0.62, out), FrameSample::Held);
+      EXPECT_EQ(out[0], 0.1f);
+    }
+
+    TEST(FrameInterpolator, BandCountChangeRestartsTheHistory)
+    {
+      FrameInterpolator interpolator;
+      interpolator.Push(0.0, Ramp(0.0, 4));
+      interpolator.Push(0.02, Ramp(0.02, 4));
+      interpolator.Push(0.04, Ramp(0.04, 6));
+
+      std::vector<float> out;
+      ASSERT_EQ(interpolator.Sample(0.03, out), FrameSample::Held);
+      ASSERT_EQ(out.size(), 6u);
+      ASSERT_EQ(interpolator.Sample(0.045, out), FrameSample::Held);
+      ASSERT_EQ(out.size(), 6u);
+
+      interpolator.Push(0.06, Ramp(0.06, 6));
+      ASSERT_EQ(interpolator.Sample(0.05, out), FrameSample::Interpolated);
+      ASSERT_EQ(out.size(), 6u);
+      std::vector<Real> want = Ramp(0.05, 6);
+      for (int b = 0; b < 6; ++b)
+        EXPECT_NEAR(out[b], want[b], 1e-6) << b;
+    }
+
+    TEST(FrameInterpolator, ResetClearsFramesAndStats)
+    {
+      FrameInterpolator interpolator;
+      interpolator.Push(0.0, {0.5f});
+      std::vector<float> out;
+      interpolator.Sample(0.0, out);
+      EXPECT_EQ(interpolator.stats().held, 1);
+
+      interpolator.Reset();
+      EXPECT_EQ(interpolator.Sample(0.0, out), FrameSample::None);
+      EXPECT_EQ(interpolator.stats().held, 0);
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
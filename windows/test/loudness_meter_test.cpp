@@ -0,0 +1,180 @@
+#define _USE_MATH_DEFINES
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "loudness_meter.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // EBU Tech 3341 tolerances
+    constexpr double kLoudnessTolerance = 0.1; // LU
+    constexpr double kTruePeakOver = 0.2;      // dB
+    constexpr double kTruePeakUnder = 0.4;
+
+    struct Segment
+    {
+      double dbfs; // sine peak level, the same on both channels
+      double seconds;
+    };
+
+    // Feeds stereo 1 kHz sine segments in 10 ms packets, as the capture
+    // thread would.
+    void FeedSine(LoudnessMeter &meter, int rate, const std::vector<Segment> &segments)
+    {
+      const int packet = rate / 100;
+      std::vector<float> block(static_cast<size_t>(packet) * 2);
+      long long n = 0;
+      for (const Segment &segment : segments)
+      {
+        double amplitude = std::pow(10.0, segment.dbfs / 20.0);
+        long long frames = static_cast<long long>(std::llround(segment.seconds * rate));
+        for (long long done = 0; done < frames; done += packet)
+        {
+          int count = static_cast<int>(std::min<long long>(packet, frames - done));
+          for (int i = 0; i < count; ++i, ++n)
+          {
+            float v = static_cast<float>(amplitude * std::sin(2.0 * M_PI * 1000.0 * n / rate));
+            block[i * 2] = v;
+            block[i * 2 + 1] = v;
+          }
+          meter.Process(block.data(), count);
+        }
+      }
+    }
+
+    // Tech 3341 cases 1 and 2: a steady sine reads its level on all three
+    // meters, at the common device rates.
+    TEST(LoudnessMeter, SteadySineReadsItsLevel)
+    {
+      for (int rate : {44100, 48000, 96000})
+      {
+        for (double level : {-23.0, -33.0})
+        {
+          LoudnessMeter meter;
+          meter.Configure(rate, 2);
+          FeedSine(meter, rate, {{level, 20.0}});
+          EXPECT_NEAR(meter.momentary(), level, kLoudnessTolerance) << rate;
+          EXPECT_NEAR(meter.short_term(), level, kLoudnessTolerance) << rate;
+          EXPECT_NEAR(meter.integrated(), level, kLoudnessTolerance) << rate;
+        }
+      }
+    }
+
+    // Case 3: the relative gate removes the quiet head and tail.
+    TEST(LoudnessMeter, RelativeGate)
+    {
+      LoudnessMeter meter;
+      meter.Configure(48000, 2);
+      FeedSine(meter, 48000, {{-36.0, 10.0}, {-23.0, 60.0}, {-36.0, 10.0}});
+      EXPECT_NEAR(meter.integrated(), -23.0, kLoudnessTolerance);
+    }
+
+    // Case 4: the absolute gate removes the -72 dBFS parts as well.
+    TEST(LoudnessMeter, AbsoluteAndRelativeGates)
+    {
+      LoudnessMeter meter;
+      meter.Configure(48000, 2);
+      FeedSine(meter, 48000,
+               {{-72.0, 10.0}, {-36.0, 10.0}, {-23.0, 60.0}, {-36.0, 10.0}, {-72.0, 10.0}});
+      EXPECT_NEAR(meter.integrated(), -23.0, kLoudnessTolerance);
+    }
+
+    // Case 5: both louder and quieter blocks pass the gate and average.
+    TEST(LoudnessMeter, GatedAverage)
+    {
+      LoudnessMeter meter;
+      meter.Configure(48000, 2);
+      FeedSine(meter, 48000, {{-26.0, 20.0}, {-20.0, 20.1}, {-26.0, 20.0}});
+      EXPECT_NEAR(meter.integrated(), -23.0, kLoudnessTolerance);
+    }
+
+    TEST(LoudnessMeter, ResetRestartsIntegration)
+    {
+      LoudnessMeter meter;
+      meter.Configure(48000, 2);
+      FeedSine(meter, 48000, {{-33.0, 10.0}});
+      meter.Reset();
+      FeedSine(meter, 48000, {{-23.0, 10.0}});
+      EXPECT_NEAR(meter.integrated(), -23.0, kLoudnessTolerance);
+    }
+
+    // 1 kHz at -23 dBFS on one channel of an interleaved layout, then the
+    // integrated reading
+    double SingleChannelLoudness(int channels, uint32_t mask, int channel)
+    {
+      const int rate = 48000;
+      LoudnessMeter meter;
+      meter.Configure(rate, channels, mask);
+      std::vector<float> block(static_cast<size_t>(rate) * channels, 0.0f);
+      double amplitude = std::pow(10.0, -23.0 / 20.0);
+      for (int second = 0; second < 10; ++second)
+      {
+        for (int i = 0; i < rate; ++i)
+          block[static_cast<size_t>(i) * channels + channel] =
+              static_cast<float>(amplitude * std::sin(2.0 * M_PI * 1000.0 * i / rate));
+        meter.Process(block.data(), rate);
+      }
+      return meter.integrated();
+    }
+
+    // Weights follow the speaker bits, not the channel position: on a quad
+    // device (FL FR BL BR) the back channels are surrounds, and only LFE is
+    // left out.
+    TEST(LoudnessMeter, ChannelWeightsFollowTheSpeakerMask)
+    {
+      const uint32_t quad = 0x1 | 0x2 | 0x10 | 0x20;
+      const uint32_t surround51 = 0x1 | 0x2 | 0x4 | 0x8 | 0x10 | 0x20;
+      const double surroundGain = 10.0 * std::log10(1.41);
+
+      double front = SingleChannelLoudness(2, 0, 0);
+      EXPECT_NEAR(SingleChannelLoudness(4, quad, 2), front + surroundGain, 0.01);
+      EXPECT_NEAR(SingleChannelLoudness(4, quad, 3), front + surroundGain, 0.01);
+      EXPECT_NEAR(SingleChannelLoudness(4, 0, 3), front + surroundGain, 0.01); // default quad layout
+      EXPECT_NEAR(SingleChannelLoudness(6, surround51, 2), front, 0.01);      // centre
+      EXPECT_TRUE(std::isinf(SingleChannelLoudness(6, surround51, 3)));       // LFE
+      EXPECT_NEAR(SingleChannelLoudness(3, 0x1 | 0x2 | 0x100, 2), front + surroundGain, 0.01);
+    }
+
+    // Cases 15 to 18: sines whose samples miss the waveform peak by a known
+    // phase, scaled so the true peak is -6 dBTP. The sample peak is lower,
+    // by 3 dB for fs/4 at 45 degrees. The hold is reset after the first half
+    // second so the interpolator's ringing on the abrupt onset is not read.
+    TEST(LoudnessMeter, TruePeakBetweenSamples)
+    {
+      const int rate = 48000;
+      const double expected = -6.0;
+      struct Case
+      {
+        int divisor; // frequency = rate / divisor
+        double phaseDeg;
+      };
+      for (const Case &c : {Case{4, 0.0}, Case{4, 45.0}, Case{6, 60.0}, Case{8, 67.5}})
+      {
+        LoudnessMeter meter;
+        meter.Configure(rate, 2);
+
+        double amplitude = std::pow(10.0, expected / 20.0);
+        double phase = c.phaseDeg * M_PI / 180.0;
+        std::vector<float> block(static_cast<size_t>(rate) * 2);
+        for (int i = 0; i < rate; ++i)
+        {
+          float v = static_cast<float>(amplitude * std::sin(2.0 * M_PI * i / c.divisor + phase));
+          block[i * 2] = v;
+          block[i * 2 + 1] = v;
+        }
+        meter.Process(block.data(), rate / 2);
+        meter.Reset();
+        meter.Process(block.data() + rate, rate / 2);
+
+        EXPECT_LE(meter.true_peak_db(), expected + kTruePeakOver) << c.divisor;
+        EXPECT_GE(meter.true_peak_db(), expected - kTruePeakUnder) << c.divisor;
+      }
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
@@ -0,0 +1,213 @@
+#define _USE_MATH_DEFINES
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "fft_kernels.h"
+#include "peak_tracker.h"
+#include "window_functions.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    constexpr int kRate = 48000;
+    constexpr int kSize = 2048;
+    constexpr int kHop = 512;
+    constexpr double kHzPerBin = static_cast<double>(kRate) / kSize;
+
+    struct Tone
+    {
+      double frequency;
+      double level_db;
+      double vibrato_hz = 0.0;   // peak deviation
+      double vibrato_rate = 5.0; // Hz
+      double start = 0.0;        // seconds
+    };
+
+    // Phase-continuous mix of the tones; vibrato bends the instantaneous
+    // frequency sinusoidally.
+    std::vector<double> Render(const std::vector<Tone> &tones, int samples)
+    {
+      std::vector<double> out(samples, 0.0);
+      for (const Tone &tone : tones)
+      {
+        double amplitude = std::pow(10.0, tone.level_db / 20.0);
+        double phase = 0.0;
+        for (int n = 0; n < samples; ++n)
+        {
+          double t = static_cast<double>(n) / kRate;
+          double f = tone.frequency + tone.vibrato_hz * std::sin(2.0 * M_PI * tone.vibrato_rate * t);
+          if (t >= tone.start)
+            out[n] += amplitude * std::sin(phase);
+          phase += 2.0 * M_PI * f / kRate;
+        }
+      }
+      return out;
+    }
+
+    // |X[k]| for k < N/2 of the windowed frame starting at offset, scaled as
+    // the analysis path feeds the tracker.
+    std::vector<Real> Magnitudes(const std::vector<double> &signal, int offset)
+    {
+      const std::vector<Real> &window = GetWindow(WindowType::BlackmanHarris, kSize);
+      std::vector<Complex> data(kSize);
+      for (int n = 0; n < kSize; ++n)
+        data[n] = Complex(static_cast<Real>(signal[offset + n] * window[n]), 0);
+      FindFFTKernel(kSize)(data.data());
+
+      std::vector<Real> mags(kSize / 2);
+      for (int k = 0; k < kSize / 2; ++k)
+        mags[k] = std::abs(data[k]);
+      return mags;
+    }
+
+    const SpectralPeak *Near(const PeakTracker &tracker, double frequency)
+    {
+      for (int i = 0; i < tracker.count(); ++i)
+      {
+        if (std::fabs(tracker.peaks()[i].frequency - frequency) < 2.0 * kHzPerBin)
+          return &tracker.peaks()[i];
+      }
+      return nullptr;
+    }
+
+    TEST(PeakTracker, SubBinFrequencyAndLevel)
+    {
+      PeakTracker tracker;
+      tracker.Configure(8, kRate);
+      double worstHz = 0.0;
+      double worstDb = 0.0;
+      // a sweep across one bin, from on-bin to half-way between bins
+      for (int step = 0; step <= 20; ++step)
+      {
+        double frequency = 3333.3 + step * kHzPerBin / 20.0;
+        std::vector<double> signal = Render({{frequency, -20.0}}, kSize);
+        std::vector<Real> mags = Magnitudes(signal, 0);
+        tracker.Process(mags.data(), static_cast<int>(mags.size()));
+
+        ASSERT_GE(tracker.count(), 1) << frequency;
+        const SpectralPeak &peak = tracker.peaks()[0];
+        worstHz = std::max(worstHz, std::fabs(peak.frequency - frequency));
+        worstDb = std::max(worstDb, std::fabs(peak.level_db + 20.0));
+      }
+      // a bin is 23.4 Hz wide here
+      EXPECT_LE(worstHz, 0.05 * kHzPerBin);
+      EXPECT_LE(worstDb, 0.25);
+    }
+
+    TEST(PeakTracker, StrongestFirstAndFloorApplied)
+    {
+      PeakTracker tracker;
+      tracker.Configure(8, kRate, -60.0);
+      std::vector<double> signal =
+          Render({{500.0, -30.0}, {2000.0, -10.0}, {6000.0, -20.0}, {9000.0, -70.0}}, kSize);
+      std::vector<Real> mags = Magnitudes(signal, 0);
+      tracker.Process(mags.data(), static_cast<int>(mags.size()));
+
+      ASSERT_EQ(tracker.count(), 3);
+      EXPECT_NEAR(tracker.peaks()[0].frequency, 2000.0, 1.0);
+      EXPECT_NEAR(tracker.peaks()[1].frequency, 6000.0, 1.0);
+      EXPECT_NEAR(tracker.peaks()[2].frequency, 500.0, 1.0);
+      EXPECT_EQ(Near(tracker, 9000.0), nullptr);
+    }
+
+    TEST(PeakTracker, KeepsOnlyTheStrongestK)
+    {
+      PeakTracker tracker;
+      tracker.Configure(2, kRate);
+      std::vector<double> signal =
+          Render({{500.0, -30.0}, {2000.0, -10.0}, {6000.0, -20.0}}, kSize);
+      std::vector<Real> mags = Magnitudes(signal, 0);
+      tracker.Process(mags.data(), static_cast<int>(mags.size()));
+
+      ASSERT_EQ(tracker.count(), 2);
+      EXPECT_NEAR(tracker.peaks()[0].frequency, 2000.0, 1.0);
+      EXPECT_NEAR(tracker.peaks()[1].frequency, 6000.0, 1.0);
+    }
+
+    TEST(PeakTracker, IdSurvivesVibrato)
+    {
+      const int frames = 100;
+      PeakTracker tracker;
+      tracker.Configure(4, kRate);
+      Tone tone{1000.0, -20.0};
+      tone.vibrato_hz = 30.0;
+      std::vector<double> signal = Render({tone}, kSize + frames * kHop);
+
+      int id = -1;
+      for (int frame = 0; frame < frames; ++frame)
+      {
+        std::vector<Real> mags = Magnitudes(signal, frame * kHop);
+        tracker.Process(mags.data(), static_cast<int>(mags.size()));
+        ASSERT_EQ(tracker.count(), 1) << frame;
+
+        const SpectralPeak &peak = tracker.peaks()[0];
+        EXPECT_NEAR(peak.frequency, 1000.0, 35.0) << frame;
+        if (frame == 0)
+          id = peak.id;
+        ASSERT_EQ(peak.id, id) << frame;
+        EXPECT_EQ(peak.age, frame);
+      }
+    }
+
+    TEST(PeakTracker, AddedToneGetsANewId)
+    {
+      const int frames = 40;
+      const int onset = 20;
+      PeakTracker tracker;
+      tracker.Configure(8, kRate);
+      Tone added{5000.0, -25.0};
+      added.start = static_cast<double>(kSize + onset * kHop) / kRate;
+      std::vector<double> signal =
+          Render({{1000.0, -20.0}, {2500.0, -30.0}, added}, kSize + frames * kHop);
+
+      int low = -1;
+      int high = -1;
+      int fresh = -1;
+      for (int frame = 0; frame < frames; ++frame)
+      {
+        std::vector<Real> mags = Magnitudes(signal, frame * kHop);
+        tracker.Process(mags.data(), static_cast<int>(mags.size()));
+
+        const SpectralPeak *a = Near(tracker, 1000.0);
+        const SpectralPeak *b = Near(tracker, 2500.0);
+        ASSERT_NE(a, nullptr) << frame;
+        ASSERT_NE(b, nullptr) << frame;
+        if (frame == 0)
+        {
+          low = a->id;
+          high = b->id;
+          ASSERT_NE(low, high);
+        }
+        EXPECT_EQ(a->id, low) << frame;
+        EXPECT_EQ(b->id, high) << frame;
+        EXPECT_EQ(a->age, frame);
+        EXPECT_EQ(b->age, frame);
+
+        const SpectralPeak *c = Near(tracker, 5000.0);
+        if (frame <= onset)
+        {
+          EXPECT_EQ(c, nullptr) << frame;
+          continue;
+        }
+        ASSERT_NE(c, nullptr) << frame;
+        if (fresh < 0)
+        {
+          fresh = c->id;
+          EXPECT_NE(fresh, low);
+          EXPECT_NE(fresh, high);
+          EXPECT_EQ(c->age, 0);
+        }
+        EXPECT_EQ(c->id, fresh) << frame;
+      }
+      EXPECT_GE(fresh, 0);
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
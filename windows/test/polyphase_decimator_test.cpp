@@ -0,0 +1,103 @@
+#define _USE_MATH_DEFINES
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "polyphase_decimator.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // Level (dB) of a unit sine at frequency after decimation, from the RMS
+    // of the output past the filter's start-up. One second of input, pushed
+    // in 10 ms packets.
+    double SineGainDb(int in_rate, int out_rate, double frequency)
+    {
+      PolyphaseDecimator decimator;
+      decimator.Configure(in_rate, out_rate);
+
+      const int packet = in_rate / 100;
+      std::vector<float> input(packet);
+      std::vector<float> block;
+      std::vector<float> output;
+      for (int start = 0; start < in_rate; start += packet)
+      {
+        for (int i = 0; i < packet; ++i)
+          input[i] = static_cast<float>(std::sin(2.0 * M_PI * frequency * (start + i) / in_rate));
+        decimator.Process(input.data(), packet, block);
+        output.insert(output.end(), block.begin(), block.end());
+      }
+
+      double sum = 0.0;
+      size_t first = output.size() / 4;
+      for (size_t i = first; i < output.size(); ++i)
+        sum += static_cast<double>(output[i]) * output[i];
+      return 10.0 * std::log10(2.0 * sum / (output.size() - first));
+    }
+
+    struct Response
+    {
+      int inRate;
+      int outRate;
+      double passbandEdge; // flat up to here
+      std::vector<double> stopband;
+    };
+
+    // 96k -> 48k checks the frequencies that would alias into the band;
+    // 48k -> 44.1k has none below the input Nyquist, so it checks the band
+    // between the two Nyquists.
+    const Response kResponses[] = {
+        {96000, 48000, 18000.0, {26000.0, 30000.0, 35000.0, 40000.0, 47000.0}},
+        {48000, 44100, 16500.0, {22500.0, 23000.0, 23900.0}},
+    };
+
+    TEST(PolyphaseDecimator, UnityDcGain)
+    {
+      for (const Response &r : kResponses)
+      {
+        PolyphaseDecimator decimator;
+        decimator.Configure(r.inRate, r.outRate);
+        ASSERT_EQ(decimator.output_rate(), r.outRate);
+        std::vector<float> ones(r.inRate, 1.0f);
+        std::vector<float> output;
+        decimator.Process(ones.data(), r.inRate, output);
+        ASSERT_GT(output.size(), 1000u);
+        for (size_t i = output.size() / 4; i < output.size(); ++i)
+          EXPECT_NEAR(output[i], 1.0f, 1e-4f) << r.inRate << " -> " << r.outRate;
+      }
+    }
+
+    TEST(PolyphaseDecimator, FlatPassband)
+    {
+      for (const Response &r : kResponses)
+      {
+        for (double f = 100.0; f <= r.passbandEdge; f += 700.0)
+          EXPECT_NEAR(SineGainDb(r.inRate, r.outRate, f), 0.0, 0.01) << r.inRate << " Hz, " << f;
+      }
+    }
+
+    TEST(PolyphaseDecimator, StopbandRejection)
+    {
+      for (const Response &r : kResponses)
+      {
+        for (double f : r.stopband)
+          EXPECT_LT(SineGainDb(r.inRate, r.outRate, f), -80.0) << r.inRate << " Hz, " << f;
+      }
+    }
+
+    TEST(PolyphaseDecimator, BoundsTheDesign)
+    {
+      PolyphaseDecimator decimator;
+      decimator.Configure(48000, 47999); // near co-prime: L would be 47999
+      EXPECT_EQ(decimator.output_rate(), 48000);
+      decimator.Configure(48000, 100); // M would be 480
+      EXPECT_EQ(decimator.output_rate(), 8000);
+      decimator.Configure(44100, 48000); // no upsampling
+      EXPECT_TRUE(decimator.passthrough());
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include "mixed_radix_fft.h"
+#include "quality_governor.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // every rung must be a size FFTProcessor accepts and no larger than the
+    // baseline, or Configure would swap in its 2048 fallback
+    void ExpectLadderWithin(const QualityGovernor &governor, int baseline)
+    {
+      int previous = baseline;
+      for (const QualityMode &mode : governor.ladder())
+      {
+        EXPECT_TRUE(MixedRadixFFT::IsSupportedSize(mode.fftSize)) << mode.fftSize;
+        EXPECT_LE(mode.fftSize, previous);
+        previous = mode.fftSize;
+      }
+    }
+
+    TEST(QualityGovernor, SmallBaselineNeverGrows)
+    {
+      QualityGovernor governor;
+      governor.SetBaseline(256, 32);
+      ExpectLadderWithin(governor, 256);
+      for (const QualityMode &mode : governor.ladder())
+        EXPECT_EQ(mode.fftSize, 256);
+    }
+
+    TEST(QualityGovernor, OddBaselineStepsToSupportedSizes)
+    {
+      QualityGovernor governor;
+      governor.SetBaseline(1125, 64);
+      ExpectLadderWithin(governor, 1125);
+      const std::vector<QualityMode> &ladder = governor.ladder();
+      EXPECT_EQ(ladder.front().fftSize, 1125);
+      EXPECT_EQ(ladder[2].fftSize, 540);
+      EXPECT_EQ(ladder.back().fftSize, 512);
+    }
+
+    TEST(QualityGovernor, PowerOfTwoBaselineHalves)
+    {
+      QualityGovernor governor;
+      governor.SetBaseline(2048, 64);
+      ExpectLadderWithin(governor, 2048);
+      const std::vector<QualityMode> &ladder = governor.ladder();
+      EXPECT_EQ(ladder.front().fftSize, 2048);
+      EXPECT_EQ(ladder[2].fftSize, 1024);
+      EXPECT_EQ(ladder.back().fftSize, 512);
+    }
+
+    // 10 ms blocks, as the capture thread feeds the governor
+    constexpr double kPeriod = 0.01;
+
+    // Update calls with a constant load sample until the mode changes;
+    // limit + 1 if it never does
+    int UpdatesUntilChange(QualityGovernor &governor, double load, int limit)
+    {
+      for (int i = 1; i <= limit; ++i)
+      {
+        if (governor.Update(load * kPeriod, kPeriod))
+          return i;
+      }
+      return limit + 1;
+    }
+
+    // Load of one block at the current mode when the baseline costs base:
+    // proportional to the FFT size, and to the frame rate once it is capped
+    // below the ~100 frames/s of uncapped 10 ms blocks.
+    double ModeLoad(const QualityGovernor &governor, double base)
+    {
+      const QualityMode &top = governor.ladder().front();
+      const QualityMode &mode = governor.mode();
+      double rate = mode.frameIntervalMs == 0 ? 1.0 : 10.0 / mode.frameIntervalMs;
+      return base * mode.fftSize / top.fftSize * rate;
+    }
+
+    // mode changes over a long run where the load follows the mode
+    int ChangesOverRun(QualityGovernor &governor, double base, int updates)
+    {
+      int changes = 0;
+      for (int i = 0; i < updates; ++i)
+      {
+        double load = ModeLoad(governor, base);
+        if (governor.Update(load * kPeriod, kPeriod))
+          ++changes;
+      }
+      return changes;
+    }
+
+    TEST(QualityGovernor, HoldsModeDuringCooldown)
+    {
+      QualityGovernor governor(0.25);
+      governor.SetBaseline(2048, 64);
+      for (int i = 0; i < 100; ++i)
+        EXPECT_FALSE(governor.Update(4.0 * kPeriod, kPeriod));
+      EXPECT_EQ(governor.level(), 0);
+    }
+
+    // over budget: 100 cooldown updates, then 25 consecutive over-budget
+    // ones before the first step, and the same again for the next
+    TEST(QualityGovernor, StepsDownAfterTheDownHold)
+    {
+      QualityGovernor governor(0.25);
+      governor.SetBaseline(2048, 64);
+      EXPECT_EQ(UpdatesUntilChange(governor, 1.0, 1000), 125);
+      EXPECT_EQ(governor.level(), 1);
+      EXPECT_EQ(UpdatesUntilChange(governor, 1.0, 1000), 125);
+      EXPECT_EQ(governor.level(), 2);
+    }
+
+    TEST(QualityGovernor, BriefOverloadDoesNotStepDown)
+    {
+      QualityGovernor governor(0.25);
+      governor.SetBaseline(2048, 64);
+      UpdatesUntilChange(governor, 0.1, 100); // cooldown
+
+      // a burst of slow blocks that lifts the average over the budget for
+      // fewer updates than the down hold, then normal load again
+      EXPECT_EQ(UpdatesUntilChange(governor, 1.0, 10), 11);
+      EXPECT_GT(governor.load(), governor.budget());
+      EXPECT_EQ(UpdatesUntilChange(governor, 0.1, 2000), 2001);
+      EXPECT_EQ(governor.level(), 0);
+    }
+
+    // back up only after the cooldown and the long up hold, and only while
+    // the next level is predicted to fit in half the budget
+    TEST(QualityGovernor, StepsUpOnlyWithHeadroom)
+    {
+      QualityGovernor governor(0.25);
+      governor.SetBaseline(2048, 64);
+      ASSERT_EQ(UpdatesUntilChange(governor, 1.0, 1000), 125);
+      ASSERT_EQ(governor.level(), 1);
+
+      int updates = UpdatesUntilChange(governor, 0.01, 5000);
+      EXPECT_GE(updates, 100 + 300);
+      EXPECT_LE(updates, 1000);
+      EXPECT_EQ(governor.level(), 0);
+
+      // level 0 runs twice the frames of level 1: a steady 0.07 predicts
+      // 0.14 there, above half the 0.25 budget, so the mode stays
+      QualityGovernor held(0.25);
+      held.SetBaseline(2048, 64);
+      ASSERT_EQ(UpdatesUntilChange(held, 1.0, 1000), 125);
+      UpdatesUntilChange(held, 0.07, 1000); // let the average settle
+      EXPECT_EQ(UpdatesUntilChange(held, 0.07, 5000), 5001);
+      EXPECT_EQ(held.level(), 1);
+    }
+
+    // a load that sits right at the budget edge settles instead of flapping
+    TEST(QualityGovernor, NoFlappingAtTheBudgetEdge)
+    {
+      QualityGovernor over(0.25);
+      over.SetBaseline(2048, 64);
+      EXPECT_EQ(ChangesOverRun(over, 0.26, 100000), 1);
+      EXPECT_EQ(over.level(), 1);
+
+      QualityGovernor under(0.25);
+      under.SetBaseline(2048, 64);
+      EXPECT_EQ(ChangesOverRun(under, 0.24, 100000), 0);
+      EXPECT_EQ(under.level(), 0);
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
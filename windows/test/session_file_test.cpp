@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "session_reader.h"
+#include "session_recorder.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    const int kBins = 16;
+    const int kPeaks = 2;
+
+    std::string TempPath(const char *name)
+    {
+      return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    std::vector<uint8_t> ReadFile(const std::string &path)
+    {
+      std::ifstream in(path, std::ios::binary);
+      return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::string &path, const std::vector<uint8_t> &bytes)
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    // count frames at the given spacing; bin b of frame i is i + b / 100.
+    // Appends are paced like the capture thread's, so the writer keeps up
+    // and nothing is dropped.
+    void Record(const std::string &path, int count, double spacing)
+    {
+      SessionRecorder recorder;
+      ASSERT_TRUE(recorder.Open(path, 48000, 2048, kBins, kPeaks));
+      std::vector<float> bins(kBins);
+      std::vector<SessionPeak> peaks(kPeaks);
+      float features[kSessionFeatures];
+      for (int i = 0; i < count; ++i)
+      {
+        for (int b = 0; b < kBins; ++b)
+          bins[b] = static_cast<float>(i + b / 100.0);
+        for (int p = 0; p < kPeaks; ++p)
+          peaks[p] = {p, i, 440.0f * (p + 1), -6.0f * p};
+        for (int f = 0; f < kSessionFeatures; ++f)
+          features[f] = static_cast<float>(f);
+        // the last frame is short, so variable counts are covered
+        int binCount = i + 1 == count ? kBins / 2 : kBins;
+        recorder.Append(i * spacing, bins.data(), binCount, peaks.data(), i % (kPeaks + 1), features);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      recorder.Close();
+      EXPECT_FALSE(recorder.write_error());
+      EXPECT_EQ(recorder.dropped(), 0u);
+    }
+
+    SessionFooter FooterOf(const std::vector<uint8_t> &bytes)
+    {
+      SessionFooter footer;
+      std::memcpy(&footer, bytes.data() + bytes.size() - sizeof(footer), sizeof(footer));
+      return footer;
+    }
+
+    TEST(SessionFile, RoundTrip)
+    {
+      std::string path = TempPath("sav_round_trip.savs");
+      Record(path, 300, 1.0 / 60.0);
+
+      SessionReader reader;
+      ASSERT_TRUE(reader.Open(path));
+      EXPECT_EQ(reader.frame_count(), 300);
+      EXPECT_EQ(reader.header().analysisRate, 48000u);
+      EXPECT_EQ(reader.header().fftSize, 2048u);
+      EXPECT_EQ(reader.header().binCapacity, static_cast<uint32_t>(kBins));
+      EXPECT_EQ(reader.header().peakCapacity, static_cast<uint32_t>(kPeaks));
+      EXPECT_NEAR(reader.duration(), 299.0 / 60.0, 1e-9);
+
+      SessionFrame frame;
+      for (int i = 0; i < 300; ++i)
+      {
+        ASSERT_TRUE(reader.ReadFrame(i, frame));
+        EXPECT_EQ(frame.seq, static_cast<uint64_t>(i));
+        EXPECT_DOUBLE_EQ(frame.time, i / 60.0);
+        ASSERT_EQ(frame.bins.size(), static_cast<size_t>(i == 299 ? kBins / 2 : kBins));
+        EXPECT_FLOAT_EQ(frame.bins[1], static_cast<float>(i + 0.01));
+        ASSERT_EQ(frame.peaks.size(), static_cast<size_t>(i % (kPeaks + 1)));
+        for (size_t p = 0; p < frame.peaks.size(); ++p)
+        {
+          EXPECT_EQ(frame.peaks[p].id, static_cast<int32_t>(p));
+          EXPECT_EQ(frame.peaks[p].age, i);
+        }
+        EXPECT_FLOAT_EQ(frame.features[kFeatureChroma], static_cast<float>(kFeatureChroma));
+      }
+      EXPECT_FALSE(reader.ReadFrame(300, frame));
+      EXPECT_FALSE(reader.ReadFrame(-1, frame));
+
+      reader.Close();
+      std::remove(path.c_str());
+    }
+
+    // Index buckets are 100 ms and frames fall exactly on 50 ms steps, so
+    // every other frame starts a bucket.
+    TEST(SessionFile, SeekAtBucketEdges)
+    {
+      std::string path = TempPath("sav_seek.savs");
+      Record(path, 41, 0.05);
+
+      SessionReader reader;
+      ASSERT_TRUE(reader.Open(path));
+      ASSERT_EQ(reader.frame_count(), 41);
+
+      EXPECT_EQ(reader.Seek(0.0), 0);
+      EXPECT_EQ(reader.Seek(0.1), 2);
+      EXPECT_EQ(reader.Seek(0.0999), 1);
+      EXPECT_EQ(reader.Seek(3 * 0.05), 3); // as recorded, a hair above 0.15
+      EXPECT_EQ(reader.Seek(0.15), 2);
+      EXPECT_EQ(reader.Seek(1.0), 20);
+      EXPECT_EQ(reader.Seek(2.0), 40);
+      EXPECT_EQ(reader.Seek(2.05), 40);
+      EXPECT_EQ(reader.Seek(1e300), 40);
+      EXPECT_EQ(reader.Seek(std::numeric_limits<double>::infinity()), 40);
+      EXPECT_EQ(reader.Seek(-1.0), 0);
+      EXPECT_EQ(reader.Seek(std::numeric_limits<double>::quiet_NaN()), 0);
+
+      // every frame is found from its own timestamp
+      for (int i = 0; i < 41; ++i)
+        EXPECT_EQ(reader.Seek(reader.FrameTime(i)), i);
+
+      reader.Close();
+      std::remove(path.c_str());
+    }
+
+    // A recording cut off mid-frame, without index or footer: the whole
+    // frames stay readable and the index is rebuilt.
+    TEST(SessionFile, FooterlessTornTail)
+    {
+      std::string path = TempPath("sav_torn.savs");
+      Record(path, 100, 1.0 / 60.0);
+
+      std::vector<uint8_t> bytes = ReadFile(path);
+      SessionFooter footer = FooterOf(bytes);
+      uint32_t frameBytes = SessionFrameBytes(kBins, kPeaks);
+      bytes.resize(sizeof(SessionHeader) + 80 * frameBytes + frameBytes / 2);
+      WriteFile(path, bytes);
+      EXPECT_EQ(footer.frameCount, 100u);
+
+      SessionReader reader;
+      ASSERT_TRUE(reader.Open(path));
+      EXPECT_EQ(reader.frame_count(), 80);
+      EXPECT_EQ(reader.Seek(0.5), 30);
+      EXPECT_EQ(reader.Seek(100.0), 79);
+      SessionFrame frame;
+      ASSERT_TRUE(reader.ReadFrame(79, frame));
+      EXPECT_EQ(frame.seq, 79u);
+
+      reader.Close();
+      std::remove(path.c_str());
+    }
+
+    // A footer-less file whose next frame holds a garbage time ends there
+    // instead of indexing up to that time.
+    TEST(SessionFile, FooterlessGarbageTime)
+    {
+      std::string path = TempPath("sav_garbage.savs");
+      Record(path, 50, 1.0 / 60.0);
+
+      std::vector<uint8_t> bytes = ReadFile(path);
+      uint32_t frameBytes = SessionFrameBytes(kBins, kPeaks);
+      bytes.resize(sizeof(SessionHeader) + 50 * frameBytes);
+      double garbage = 1e12;
+      std::memcpy(bytes.data() + sizeof(SessionHeader) + 40 * frameBytes + kFrameTimeOffset, &garbage,
+                  sizeof(garbage));
+      WriteFile(path, bytes);
+
+      SessionReader reader;
+      ASSERT_TRUE(reader.Open(path));
+      EXPECT_EQ(reader.frame_count(), 40);
+      EXPECT_EQ(reader.Seek(1e12), 39);
+
+      reader.Close();
+      std::remove(path.c_str());
+    }
+
+    // Footers whose index cannot be trusted are ignored; the index is
+    // rebuilt from the frames and seeking stays inside the file.
+    TEST(SessionFile, CorruptedFooterIsRebuilt)
+    {
+      std::string path = TempPath("sav_corrupt.savs");
+      Record(path, 120, 1.0 / 60.0);
+      const std::vector<uint8_t> good = ReadFile(path);
+      SessionFooter footer = FooterOf(good);
+      ASSERT_GE(footer.indexEntries, 3u);
+
+      auto patchEntry = [&](std::vector<uint8_t> &bytes, uint64_t entry, uint64_t value)
+      {
+        std::memcpy(bytes.data() + footer.indexOffset + entry * sizeof(uint64_t), &value, sizeof(value));
+      };
+      auto patchFooter = [&](std::vector<uint8_t> &bytes, const SessionFooter &patched)
+      {
+        std::memcpy(bytes.data() + bytes.size() - sizeof(patched), &patched, sizeof(patched));
+      };
+
+      std::vector<std::vector<uint8_t>> files;
+      {
+        std::vector<uint8_t> bytes = good; // entry past the frames
+        patchEntry(bytes, 1, 1000000);
+        files.push_back(bytes);
+      }
+      {
+        std::vector<uint8_t> bytes = good; // entries going backwards
+        patchEntry(bytes, 2, 0);
+        files.push_back(bytes);
+      }
+      {
+        std::vector<uint8_t> bytes = good; // frame count that would wrap the offsets
+        SessionFooter patched = footer;
+        patched.frameCount = ~0ull / 4;
+        patchFooter(bytes, patched);
+        files.push_back(bytes);
+      }
+      {
+        std::vector<uint8_t> bytes = good; // index that does not fit the file
+        SessionFooter patched = footer;
+        patched.indexEntries = ~0ull / 2;
+        patchFooter(bytes, patched);
+        files.push_back(bytes);
+      }
+
+      for (const std::vector<uint8_t> &bytes : files)
+      {
+        WriteFile(path, bytes);
+        SessionReader reader;
+        ASSERT_TRUE(reader.Open(path));
+        // the rebuild stops at the index, which reads as a torn frame
+        EXPECT_GE(reader.frame_count(), 119);
+        EXPECT_LE(reader.frame_count(), 120);
+        for (double time : {0.0, 0.5, 1.0, 1.5, 1.99, 1e9})
+        {
+          int64_t frame = reader.Seek(time);
+          ASSERT_GE(frame, 0);
+          ASSERT_LT(frame, reader.frame_count());
+          EXPECT_LE(reader.FrameTime(frame), std::max(time, 0.0));
+        }
+        SessionFrame frame;
+        EXPECT_TRUE(reader.ReadFrame(reader.frame_count() - 1, frame));
+      }
+
+      std::remove(path.c_str());
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
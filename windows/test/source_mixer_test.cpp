@@ -0,0 +1,95 @@
+#define _USE_MATH_DEFINES
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "source_mixer.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // Two synthetic devices on independent clocks: a 48 kHz master and a
+    // 44.1 kHz source whose crystal runs 150 ppm fast. Both deliver 10 ms
+    // packets with random delivery jitter; the timestamps passed along are
+    // the exact capture times on the master clock, as QPC stamps would be.
+    TEST(SourceMixer, TracksDriftBetweenMismatchedClocks)
+    {
+      const int masterRate = 48000;
+      const int sourceRate = 44100;
+      const double driftPpm = 150.0;
+      const int masterFrames = masterRate / 100;
+      const int sourceFrames = sourceRate / 100;
+      const double sourceClock = sourceRate * (1.0 + driftPpm * 1e-6);
+      const double jitterSec = 0.003;
+      const double settleSec = 180.0;
+      const double runSec = 900.0;
+
+      SourceMixer mixer;
+      mixer.Configure(masterRate, 2);
+      int source = mixer.AddSource(1.0f);
+
+      std::mt19937 rng(45);
+      std::uniform_real_distribution<double> jitter(0.0, jitterSec);
+
+      std::vector<float> master(static_cast<size_t>(masterFrames) * 2, 0.0f);
+      std::vector<float> packet(static_cast<size_t>(sourceFrames) * 2);
+      uint64_t sourceWritten = 0;
+      int64_t masterPackets = 0;
+
+      // capture time of the first frame of the next packet, and when it is
+      // handed to the application
+      double sourceTime = 0.0;
+      double sourceDue = sourceFrames / sourceClock + jitter(rng);
+      double masterTime = 0.0;
+      double masterDue = static_cast<double>(masterFrames) / masterRate + jitter(rng);
+
+      double minFill = 1e9;
+      double maxFill = -1e9;
+      while (masterTime < runSec)
+      {
+        if (sourceDue <= masterDue)
+        {
+          for (int i = 0; i < sourceFrames; ++i)
+          {
+            float v = static_cast<float>(0.25 * std::sin(2.0 * M_PI * 440.0 * (sourceWritten + i) / sourceRate));
+            packet[i * 2] = v;
+            packet[i * 2 + 1] = v;
+          }
+          mixer.Push(source, packet.data(), sourceFrames, 2, sourceRate, sourceTime);
+          sourceWritten += sourceFrames;
+          sourceTime = sourceWritten / sourceClock;
+          sourceDue = (sourceWritten + sourceFrames) / sourceClock + jitter(rng);
+        }
+        else
+        {
+          mixer.Mix(master.data(), masterFrames, masterTime);
+          ++masterPackets;
+          masterTime = static_cast<double>(masterPackets * masterFrames) / masterRate;
+          masterDue = masterTime + static_cast<double>(masterFrames) / masterRate + jitter(rng);
+
+          if (masterTime >= settleSec)
+          {
+            MixSourceStats stats = mixer.source_stats(source);
+            minFill = std::min(minFill, stats.fillMs);
+            maxFill = std::max(maxFill, stats.fillMs);
+          }
+        }
+      }
+
+      MixSourceStats stats = mixer.source_stats(source);
+      EXPECT_EQ(stats.rate, sourceRate);
+      EXPECT_NEAR(stats.driftPpm, driftPpm, 1.0);
+      EXPECT_NEAR(minFill, 20.0, 0.1);
+      EXPECT_NEAR(maxFill, 20.0, 0.1);
+      EXPECT_EQ(stats.underruns, 0);
+      EXPECT_EQ(stats.overruns, 0);
+      EXPECT_EQ(stats.resyncs, 0);
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "spectrum_kernels.h"
+
+namespace system_audio_visualizer
+{
+  namespace test
+  {
+
+    // Bounds stated in spectrum_kernels.h, checked against libm in double.
+    constexpr double kLog2Range = 4e-6;  // whole sweep, 1e-30..1e30
+    constexpr double kLog2NearOne = 2e-7;
+    constexpr double kMagnitude = 1.2e-7; // relative to hypot
+    constexpr double kPowerDb = 3e-5;     // levels within +-150 dB
+    constexpr double kPowerDbFloor = 5e-5; // down to the -300 dB floor
+
+    TEST(SpectrumKernels, FastLog2MatchesLibm)
+    {
+      double worst = 0.0;
+      double worstNearOne = 0.0;
+      for (double x = 1e-30; x < 1e30; x *= 1.0001)
+      {
+        float value = static_cast<float>(x);
+        double error = std::fabs(FastLog2(value) - std::log2(static_cast<double>(value)));
+        worst = std::max(worst, error);
+        if (value >= 0.5f && value <= 2.0f)
+          worstNearOne = std::max(worstNearOne, error);
+      }
+      EXPECT_LE(worst, kLog2Range);
+      EXPECT_LE(worstNearOne, kLog2NearOne);
+    }
+
+#ifndef SAV_DSP_DOUBLE
+    TEST(SpectrumKernels, FastPassMatchesLibm)
+    {
+      // not a multiple of four, so the scalar tail is covered too
+      const int n = 4099;
+      std::mt19937 rng(7);
+      std::uniform_real_distribution<double> exponent(-7.5, 7.5);
+      std::uniform_real_distribution<double> phase(0.0, 6.283185307179586);
+
+      std::vector<Complex> data(n);
+      for (Complex &bin : data)
+        bin = std::polar(static_cast<Real>(std::pow(10.0, exponent(rng))),
+                         static_cast<Real>(phase(rng)));
+
+      std::vector<Real> mags(n);
+      std::vector<Real> powerDb(n);
+      Real peak = SpectrumPass(data.data(), n, mags.data(), powerDb.data(), SpectrumMath::Fast);
+
+      double expectedPeak = 0.0;
+      for (int k = 0; k < n; ++k)
+      {
+        double re = data[k].real();
+        double im = data[k].imag();
+        double magnitude = std::hypot(re, im);
+        double db = 10.0 * std::log10(std::max(re * re + im * im, 1e-30));
+        expectedPeak = std::max(expectedPeak, magnitude);
+
+        EXPECT_LE(std::fabs(mags[k] - magnitude), kMagnitude * magnitude) << "bin " << k;
+        EXPECT_LE(std::fabs(powerDb[k] - db), kPowerDb) << "bin " << k;
+      }
+      EXPECT_LE(std::fabs(peak - expectedPeak), kMagnitude * expectedPeak);
+    }
+
+    TEST(SpectrumKernels, FastPassNearTheFloor)
+    {
+      // the float result itself rounds by up to ~1.5e-5 dB out here
+      std::vector<Complex> data{Complex(0, 0), Complex(1e-13f, 0), Complex(3e-12f, 4e-12f), Complex(1e-15f, 0)};
+      std::vector<Real> mags(data.size());
+      std::vector<Real> powerDb(data.size());
+      SpectrumPass(data.data(), static_cast<int>(data.size()), mags.data(), powerDb.data(), SpectrumMath::Fast);
+
+      for (size_t k = 0; k < data.size(); ++k)
+      {
+        double re = data[k].real();
+        double im = data[k].imag();
+        double db = 10.0 * std::log10(std::max(re * re + im * im, 1e-30));
+        EXPECT_LE(std::fabs(powerDb[k] - db), kPowerDbFloor) << "bin " << k;
+      }
+    }
+#endif
+
+    TEST(SpectrumKernels, ExactPassIsLibm)
+    {
+      std::vector<Complex> data{Complex(3, 4), Complex(0, 0), Complex(-1, 1e-3f)};
+      std::vector<Real> mags(data.size());
+      std::vector<Real> powerDb(data.size());
+      Real peak = SpectrumPass(data.data(), static_cast<int>(data.size()), mags.data(), powerDb.data(),
+                               SpectrumMath::Exact);
+
+      EXPECT_EQ(peak, Real(5));
+      for (size_t k = 0; k < data.size(); ++k)
+      {
+        Real re = data[k].real();
+        Real im = data[k].imag();
+        EXPECT_EQ(mags[k], std::hypot(re, im));
+        // the floor constant is a float in both builds
+        EXPECT_EQ(powerDb[k], Real(10) * std::log10(std::max(re * re + im * im, Real(1e-30f))));
+      }
+    }
+
+  } // namespace test
+} // namespace system_audio_visualizer
@@ -5,8 +5,10 @@
 #include <mmreg.h>
 #include <avrt.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -17,6 +19,21 @@
 #define LOG(x) std::cout << "[WASAPI] " << x << std::endl;
 
 static bool TryCoInitialize(DWORD flags, bool &needsUninit);
+static UINT64 QpcNow100ns();
+
+// speaker bits of an extensible mix format; 0 for a plain WAVEFORMATEX
+static uint32_t ChannelMaskOf(const WAVEFORMATEX *format)
+{
+    if (format->wFormatTag != WAVE_FORMAT_EXTENSIBLE ||
+        format->cbSize < sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX))
+        return 0;
+    return reinterpret_cast<const WAVEFORMATEXTENSIBLE *>(format)->dwChannelMask;
+}
+
+// Loopback streams do not signal the event while nothing is rendered, so
+// waits time out after a few periods; an idle wakeup then delivers a silent
+// block when idle fill is on (see SetIdleFill).
+static const DWORD kSilentWakeupPeriods = 4;
 
 // ---------------------------------------------------------
 // Device change notification client
@@ -24,8 +41,8 @@ static bool TryCoInitialize(DWORD flags, bool &needsUninit);
 class DeviceNotificationClient : public IMMNotificationClient
 {
 public:
-    explicit DeviceNotificationClient(std::function<void()> cb)
-        : ref_(1), cb_(std::move(cb)) {}
+    DeviceNotificationClient(EDataFlow flow, std::function<void()> cb)
+        : ref_(1), flow_(flow), cb_(std::move(cb)) {}
 
     ULONG STDMETHODCALLTYPE AddRef() override { return InterlockedIncrement(&ref_); }
     ULONG STDMETHODCALLTYPE Release() override
@@ -53,7 +70,7 @@ public:
     // IMMNotificationClient
     HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR) override
     {
-        if (flow == eRender && role == eConsole)
+        if (flow == flow_ && role == eConsole)
         {
             LOG("Default device changed.");
             if (cb_)
@@ -69,23 +86,45 @@ public:
 
 private:
     LONG ref_;
+    EDataFlow flow_;
     std::function<void()> cb_;
 };
 
+// ---------------------------------------------------------
+// One opened endpoint. A device switch opens and starts the next
+// endpoint while the current one is still held, so both briefly coexist.
+// ---------------------------------------------------------
+struct Endpoint
+{
+    IMMDevice *device = nullptr;
+    IAudioClient *audio = nullptr;
+    IAudioCaptureClient *capture = nullptr;
+    WAVEFORMATEX *format = nullptr;
+    HANDLE event = nullptr; // signaled by the audio engine per period
+    bool eventDriven = false;
+    DWORD periodMs = 10;
+};
+
+static bool OpenEndpoint(IMMDeviceEnumerator *enumerator, EDataFlow flow, Endpoint &ep);
+static void CloseEndpoint(Endpoint &ep);
+
 // ---------------------------------------------------------
 // WasapiCapture::Impl — keep private
 // ---------------------------------------------------------
 struct WasapiCapture::Impl
 {
-    Impl()
-        : device(nullptr),
-          audio(nullptr),
-          capture(nullptr),
-          format(nullptr),
+    explicit Impl(CaptureEndpoint kind)
+        : flow(kind == CaptureEndpoint::Microphone ? eCapture : eRender),
           enumerator(nullptr),
           notifier(nullptr),
+          switchEvent(CreateEventW(nullptr, FALSE, FALSE, nullptr)),
+          switchRequestedAt(0),
+          realtimeClass(RealtimeClass::Audio),
           running(false),
-          sampleRate(48000) {}
+          idleFill(false),
+          sampleRate(48000),
+          channels(2),
+          channelMask(0) {}
 
     ~Impl()
     {
@@ -98,38 +137,52 @@ struct WasapiCapture::Impl
 
         if (notifier)
             notifier->Release();
+        CloseEndpoint(current);
         if (enumerator)
             enumerator->Release();
-        if (format)
-            CoTaskMemFree(format);
-        if (capture)
-            capture->Release();
-        if (audio)
-            audio->Release();
-        if (device)
-            device->Release();
+        if (switchEvent)
+            CloseHandle(switchEvent);
     }
 
-    IMMDevice *device;
-    IAudioClient *audio;
-    IAudioCaptureClient *capture;
-    WAVEFORMATEX *format;
+    Endpoint current;
+    EDataFlow flow; // eRender: loopback of the render device
 
     IMMDeviceEnumerator *enumerator;
     DeviceNotificationClient *notifier;
 
+    // device changes are only flagged on the notification thread; the
+    // capture thread performs the switch between packets
+    HANDLE switchEvent;
+    std::atomic<UINT64> switchRequestedAt; // QPC 100 ns, 0 when none pending
+
+    RealtimeClass realtimeClass;
+
     std::atomic<bool> running;
+    std::atomic<bool> idleFill;
     std::thread thread;
-    int sampleRate;
+    std::atomic<int> sampleRate;
+    std::atomic<int> channels;
+    std::atomic<uint32_t> channelMask;
 
-    std::function<void(const float *, int)> callback;
+    std::function<void(const float *, int, double)> callback;
+    std::function<void(int, int, uint32_t)> formatCallback;
     std::mutex cbLock;
+
+    std::vector<float> silence; // reused for silent packets
+
+    CaptureStats stats;
+    DeadlineMonitor deadlines;
+    mutable std::mutex statsLock;
+
+    // capture thread only: opens the new default endpoint, starts it, then
+    // retires the old one. On failure the old endpoint keeps running.
+    bool SwitchEndpoint();
 };
 
 // ---------------------------------------------------------
 // Constructor
 // ---------------------------------------------------------
-WasapiCapture::WasapiCapture() : impl_(new Impl) {}
+WasapiCapture::WasapiCapture(CaptureEndpoint endpoint) : impl_(new Impl(endpoint)) {}
 
 WasapiCapture::~WasapiCapture()
 {
@@ -137,51 +190,21 @@ WasapiCapture::~WasapiCapture()
 }
 
 // ---------------------------------------------------------
-// Internal helper (now *inside* class, so no access errors)
+// Called on the COM notification thread: no audio work here
 // ---------------------------------------------------------
 void WasapiCapture::HandleDeviceChange()
 {
-    LOG("Handling device change...");
-
-    bool wasRunning = impl_->running;
-
-    Stop();
-
-    // Release previous objects
-    if (impl_->capture)
-    {
-        impl_->capture->Release();
-        impl_->capture = nullptr;
-    }
-    if (impl_->audio)
-    {
-        impl_->audio->Release();
-        impl_->audio = nullptr;
-    }
-    if (impl_->device)
-    {
-        impl_->device->Release();
-        impl_->device = nullptr;
-    }
-    if (impl_->format)
+    if (!impl_->running)
     {
-        CoTaskMemFree(impl_->format);
-        impl_->format = nullptr;
+        // the next Initialize() opens whatever is default then
+        LOG("Device changed while stopped.");
+        return;
     }
 
-    LOG("Reinitializing after device change...");
-    if (Initialize())
-    {
-        if (wasRunning)
-        {
-            std::function<void(const float *, int)> cb;
-            {
-                std::lock_guard<std::mutex> lock(impl_->cbLock);
-                cb = impl_->callback;
-            }
-            Start(cb);
-        }
-    }
+    LOG("Scheduling device switch...");
+    UINT64 expected = 0;
+    impl_->switchRequestedAt.compare_exchange_strong(expected, QpcNow100ns());
+    SetEvent(impl_->switchEvent);
 }
 
 // ---------------------------------------------------------
@@ -191,6 +214,9 @@ bool WasapiCapture::Initialize()
 {
     LOG("Initialize()");
 
+    if (impl_->running)
+        return true;
+
     bool needUninit = false;
     TryCoInitialize(COINIT_MULTITHREADED, needUninit);
 
@@ -205,55 +231,208 @@ bool WasapiCapture::Initialize()
         if (FAILED(hr))
             return false;
 
-        impl_->notifier = new DeviceNotificationClient([this]()
+        impl_->notifier = new DeviceNotificationClient(impl_->flow, [this]()
                                                        { HandleDeviceChange(); });
         impl_->enumerator->RegisterEndpointNotificationCallback(impl_->notifier);
     }
 
+    // a restart reopens the current default device
+    CloseEndpoint(impl_->current);
+    if (!OpenEndpoint(impl_->enumerator, impl_->flow, impl_->current))
+    {
+        CloseEndpoint(impl_->current);
+        return false;
+    }
+
+    impl_->sampleRate = impl_->current.format->nSamplesPerSec;
+    impl_->channels = impl_->current.format->nChannels;
+    impl_->channelMask = ChannelMaskOf(impl_->current.format);
+    impl_->switchRequestedAt = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->statsLock);
+        impl_->stats = CaptureStats();
+        impl_->deadlines.Reset();
+        impl_->stats.eventDriven = impl_->current.eventDriven;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------
+// Endpoint setup / teardown
+// ---------------------------------------------------------
+static bool OpenEndpoint(IMMDeviceEnumerator *enumerator, EDataFlow flow, Endpoint &ep)
+{
+    HRESULT hr;
+
     // Get default device
-    hr = impl_->enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &impl_->device);
+    hr = enumerator->GetDefaultAudioEndpoint(flow, eConsole, &ep.device);
     if (FAILED(hr))
         return false;
 
     // Activate client
-    hr = impl_->device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
-                                 reinterpret_cast<void **>(&impl_->audio));
+    hr = ep.device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
+                             reinterpret_cast<void **>(&ep.audio));
     if (FAILED(hr))
         return false;
 
     // Mix format
-    hr = impl_->audio->GetMixFormat(&impl_->format);
+    hr = ep.audio->GetMixFormat(&ep.format);
     if (FAILED(hr))
         return false;
 
-    impl_->sampleRate = impl_->format->nSamplesPerSec;
+    REFERENCE_TIME defaultPeriod = 0;
+    REFERENCE_TIME minPeriod = 0;
+    if (SUCCEEDED(ep.audio->GetDevicePeriod(&defaultPeriod, &minPeriod)) && defaultPeriod > 0)
+        ep.periodMs = std::max<DWORD>(1, static_cast<DWORD>(defaultPeriod / 10000));
 
-    // Loopback initialization
-    hr = impl_->audio->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        AUDCLNT_STREAMFLAGS_LOOPBACK,
-        0, 0,
-        impl_->format,
-        nullptr);
+    // Render devices are captured in loopback; recording devices directly
+    DWORD streamFlags = flow == eRender ? AUDCLNT_STREAMFLAGS_LOOPBACK : 0;
 
-    if (FAILED(hr))
-        return false;
+    // Shared-mode initialization, event-driven where the engine allows it
+    ep.event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    ep.eventDriven = false;
+    if (ep.event)
+    {
+        hr = ep.audio->Initialize(
+            AUDCLNT_SHAREMODE_SHARED,
+            streamFlags | AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+            0, 0,
+            ep.format,
+            nullptr);
+
+        if (SUCCEEDED(hr) && SUCCEEDED(ep.audio->SetEventHandle(ep.event)))
+        {
+            ep.eventDriven = true;
+        }
+        else
+        {
+            // a client cannot be initialized twice; start over with a fresh one
+            LOG("Event-driven capture unavailable, using timed waits");
+            ep.audio->Release();
+            ep.audio = nullptr;
+            hr = ep.device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
+                                     reinterpret_cast<void **>(&ep.audio));
+            if (FAILED(hr))
+                return false;
+        }
+    }
+
+    if (!ep.eventDriven)
+    {
+        hr = ep.audio->Initialize(
+            AUDCLNT_SHAREMODE_SHARED,
+            streamFlags,
+            0, 0,
+            ep.format,
+            nullptr);
+
+        if (FAILED(hr))
+            return false;
+    }
 
     // Capture service
-    hr = impl_->audio->GetService(__uuidof(IAudioCaptureClient),
-                                  reinterpret_cast<void **>(&impl_->capture));
+    hr = ep.audio->GetService(__uuidof(IAudioCaptureClient),
+                              reinterpret_cast<void **>(&ep.capture));
     if (FAILED(hr))
         return false;
 
     return true;
 }
 
+static void CloseEndpoint(Endpoint &ep)
+{
+    if (ep.capture)
+        ep.capture->Release();
+    if (ep.audio)
+        ep.audio->Release();
+    if (ep.device)
+        ep.device->Release();
+    if (ep.format)
+        CoTaskMemFree(ep.format);
+    if (ep.event)
+        CloseHandle(ep.event);
+    ep = Endpoint();
+}
+
+// ---------------------------------------------------------
+// Device switch (capture thread)
+// ---------------------------------------------------------
+bool WasapiCapture::Impl::SwitchEndpoint()
+{
+    LOG("Switching to the new default device...");
+
+    // pre-warm: the new stream is capturing before the old one stops
+    Endpoint next;
+    if (!OpenEndpoint(enumerator, flow, next) || FAILED(next.audio->Start()))
+    {
+        LOG("New device unavailable, staying on the current one");
+        CloseEndpoint(next);
+        return false;
+    }
+
+    current.audio->Stop();
+    CloseEndpoint(current);
+    current = next;
+
+    int rate = current.format->nSamplesPerSec;
+    int ch = current.format->nChannels;
+    uint32_t mask = ChannelMaskOf(current.format);
+    bool formatChanged = rate != sampleRate || ch != channels || mask != channelMask;
+    sampleRate = rate;
+    channels = ch;
+    channelMask = mask;
+
+    // downstream adapts before the first packet in the new format
+    if (formatChanged)
+    {
+        std::function<void(int, int, uint32_t)> cb;
+        {
+            std::lock_guard<std::mutex> lock(cbLock);
+            cb = formatCallback;
+        }
+        if (cb)
+            cb(rate, ch, mask);
+    }
+
+    std::lock_guard<std::mutex> lock(statsLock);
+    stats.eventDriven = current.eventDriven;
+    stats.deviceSwitches++;
+    return true;
+}
+
+// ---------------------------------------------------------
+// Real-time class of the capture thread
+// ---------------------------------------------------------
+void WasapiCapture::SetRealtime(RealtimeClass cls)
+{
+    impl_->realtimeClass = cls;
+}
+
+// ---------------------------------------------------------
+// Silent blocks while the endpoint delivers nothing
+// ---------------------------------------------------------
+void WasapiCapture::SetIdleFill(bool enabled)
+{
+    impl_->idleFill = enabled;
+}
+
+// ---------------------------------------------------------
+// Format change after a device switch
+// ---------------------------------------------------------
+void WasapiCapture::SetFormatCallback(std::function<void(int sampleRate, int channels, uint32_t channelMask)> cb)
+{
+    std::lock_guard<std::mutex> lock(impl_->cbLock);
+    impl_->formatCallback = std::move(cb);
+}
+
 // ---------------------------------------------------------
 // Start capture
 // ---------------------------------------------------------
-bool WasapiCapture::Start(std::function<void(const float *, int)> cb)
+bool WasapiCapture::Start(std::function<void(const float *, int, double)> cb)
 {
-    if (!impl_->audio || !impl_->capture)
+    if (!impl_->current.audio || !impl_->current.capture)
         return false;
 
     {
@@ -270,46 +449,130 @@ bool WasapiCapture::Start(std::function<void(const float *, int)> cb)
         bool needUninit = false;
         TryCoInitialize(COINIT_MULTITHREADED, needUninit);
 
-        impl_->audio->Start();
+        // DSP runs inside the callback, so this also covers the analysis
+        RealtimeScope realtime(impl_->realtimeClass);
+        {
+            std::lock_guard<std::mutex> lock(impl_->statsLock);
+            impl_->stats.realtime = realtime.mode();
+        }
 
-        WAVEFORMATEX* wf = impl_->format;
-        int ch = wf->nChannels;
+        Endpoint* ep = &impl_->current;
+        ep->audio->Start();
 
+        double meanLatency = 0.0;
+        bool switched = false; // awaiting the first packet of a new endpoint
+        double deliveredUntil = ClockNow(); // end of the last block handed out
+
+        // Block until the engine signals a period, a device switch is
+        // requested, or the timed fallback elapses; then drain every queued
+        // packet before waiting again.
         while (impl_->running) {
-            UINT32 packet = 0;
-            impl_->capture->GetNextPacketSize(&packet);
-            if (!packet) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            DWORD timeout = ep->eventDriven ? ep->periodMs * kSilentWakeupPeriods : ep->periodMs;
+            HANDLE waits[2];
+            DWORD count = 0;
+            if (impl_->switchEvent) waits[count++] = impl_->switchEvent;
+            if (ep->event) waits[count++] = ep->event;
+
+            DWORD woke = WAIT_TIMEOUT;
+            if (count) woke = WaitForMultipleObjects(count, waits, FALSE, timeout);
+            else Sleep(timeout);
+
+            if (impl_->switchEvent && woke == WAIT_OBJECT_0) {
+                switched = impl_->SwitchEndpoint();
+                if (!switched) impl_->switchRequestedAt = 0;
                 continue;
             }
 
-            BYTE* data;
-            UINT32 frames;
-            DWORD flags;
-            impl_->capture->GetBuffer(&data, &frames, &flags, nullptr, nullptr);
+            int ch = ep->format->nChannels;
+            double rate = (double)ep->format->nSamplesPerSec;
 
-            size_t total = (size_t)frames * ch;
-            std::vector<float> out(total);
-
-            if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
-                std::fill(out.begin(), out.end(), 0.f);
-            } else {
-                float* f = (float*)data;
-                for (size_t i = 0; i < total; i++) out[i] = f[i];
+            int64_t drained = 0;
+            UINT32 packet = 0;
+            while (impl_->running &&
+                   SUCCEEDED(ep->capture->GetNextPacketSize(&packet)) && packet) {
+                BYTE* data;
+                UINT32 frames;
+                DWORD flags;
+                UINT64 qpcPosition = 0;
+                if (FAILED(ep->capture->GetBuffer(&data, &frames, &flags, nullptr, &qpcPosition)))
+                    break;
+
+                // latency from the packet's device timestamp to processing
+                UINT64 now = QpcNow100ns();
+                double latencyMs = qpcPosition && now > qpcPosition ? (double)(now - qpcPosition) / 10000.0 : 0.0;
+
+                const float* samples = (const float*)data;
+                int total = (int)frames * ch;
+                if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+                    if ((int)impl_->silence.size() < total) impl_->silence.resize(total);
+                    std::fill(impl_->silence.begin(), impl_->silence.begin() + total, 0.f);
+                    samples = impl_->silence.data();
+                }
+
+                std::function<void(const float*, int, double)> cb;
+                {
+                    std::lock_guard<std::mutex> lock(impl_->cbLock);
+                    cb = impl_->callback;
+                }
+
+                double time = (double)(qpcPosition ? qpcPosition : now) / 1e7;
+                cb(samples, total, time);
+                deliveredUntil = time + frames / rate;
+
+                ep->capture->ReleaseBuffer(frames);
+                drained++;
+
+                // the packet's work must finish within the audio it covers
+                double usedSec = (double)(QpcNow100ns() - now) / 1e7;
+
+                // first packet after a switch closes the gap measurement
+                UINT64 requested = switched ? impl_->switchRequestedAt.exchange(0) : 0;
+                switched = false;
+
+                std::lock_guard<std::mutex> lock(impl_->statsLock);
+                CaptureStats& st = impl_->stats;
+                if (requested && now > requested)
+                    st.lastSwitchGapMs = (double)(now - requested) / 10000.0;
+                impl_->deadlines.Record(frames / rate, usedSec);
+                st.deadlineMisses = impl_->deadlines.misses();
+                st.worstLatenessMs = impl_->deadlines.worst_lateness_ms();
+                if (st.packets == 0) meanLatency = latencyMs;
+                meanLatency += 0.05 * (latencyMs - meanLatency);
+                st.jitterMs += 0.05 * (std::fabs(latencyMs - meanLatency) - st.jitterMs);
+                st.lastLatencyMs = latencyMs;
+                st.maxLatencyMs = std::max(st.maxLatencyMs, latencyMs);
+                st.packets++;
             }
 
-            std::function<void(const float*, int)> cb;
-            {
-                std::lock_guard<std::mutex> lock(impl_->cbLock);
-                cb = impl_->callback;
+            // nothing arrived: cover the gap with silence ending now, so a
+            // consumer clocked by this stream (the microphone mix) keeps going
+            bool filled = false;
+            if (!drained && impl_->idleFill && impl_->running) {
+                double nowSec = ClockNow();
+                int frames = (int)std::min((nowSec - deliveredUntil) * rate, rate / 10.0);
+                if (frames > 0) {
+                    int total = frames * ch;
+                    if ((int)impl_->silence.size() < total) impl_->silence.resize(total);
+                    std::fill(impl_->silence.begin(), impl_->silence.begin() + total, 0.f);
+
+                    std::function<void(const float*, int, double)> cb;
+                    {
+                        std::lock_guard<std::mutex> lock(impl_->cbLock);
+                        cb = impl_->callback;
+                    }
+                    cb(impl_->silence.data(), total, nowSec - frames / rate);
+                    filled = true;
+                }
+                deliveredUntil = nowSec;
             }
 
-            cb(out.data(), (int)out.size());
-
-            impl_->capture->ReleaseBuffer(frames);
+            std::lock_guard<std::mutex> lock(impl_->statsLock);
+            impl_->stats.wakeups++;
+            if (!drained) impl_->stats.idleWakeups++;
+            if (filled) impl_->stats.idleFills++;
         }
 
-        impl_->audio->Stop();
+        ep->audio->Stop();
         if (needUninit) CoUninitialize(); });
 
     return true;
@@ -333,6 +596,52 @@ int WasapiCapture::sample_rate() const
     return impl_->sampleRate;
 }
 
+// ---------------------------------------------------------
+// Channel count
+// ---------------------------------------------------------
+int WasapiCapture::channels() const
+{
+    return impl_->channels;
+}
+
+// ---------------------------------------------------------
+// Speaker positions
+// ---------------------------------------------------------
+uint32_t WasapiCapture::channel_mask() const
+{
+    return impl_->channelMask;
+}
+
+// ---------------------------------------------------------
+// Scheduling stats
+// ---------------------------------------------------------
+CaptureStats WasapiCapture::stats() const
+{
+    std::lock_guard<std::mutex> lock(impl_->statsLock);
+    return impl_->stats;
+}
+
+// ---------------------------------------------------------
+// Capture clock (QPC, seconds)
+// ---------------------------------------------------------
+double WasapiCapture::ClockNow()
+{
+    return (double)QpcNow100ns() / 1e7;
+}
+
+// ---------------------------------------------------------
+// QPC clock in the 100 ns units used by GetBuffer positions
+// ---------------------------------------------------------
+static UINT64 QpcNow100ns()
+{
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    UINT64 f = (UINT64)freq.QuadPart;
+    UINT64 t = (UINT64)now.QuadPart;
+    return (t / f) * 10000000ULL + (t % f) * 10000000ULL / f;
+}
+
 // ---------------------------------------------------------
 // TryCoInitialize
 // ---------------------------------------------------------
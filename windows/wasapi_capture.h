@@ -1,22 +1,83 @@
 #ifndef WASAPI_CAPTURE_H_
 #define WASAPI_CAPTURE_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 
+#include "realtime_thread.h"
+
+// Capture-thread scheduling counters
+struct CaptureStats
+{
+    bool eventDriven = false; // false: timed waits at the device period
+    int64_t wakeups = 0;      // returns from the readiness wait
+    int64_t idleWakeups = 0;  // wakeups that found no packet
+    int64_t idleFills = 0;    // silent blocks synthesized on idle wakeups
+    int64_t packets = 0;
+    // device timestamp of a packet -> start of its processing
+    double lastLatencyMs = 0.0;
+    double maxLatencyMs = 0.0;
+    double jitterMs = 0.0; // mean absolute deviation of the latency
+
+    // real-time scheduling of the capture/DSP thread
+    const char *realtime = "none"; // RealtimeScope::mode()
+    int64_t deadlineMisses = 0;    // packets processed slower than real time
+    double worstLatenessMs = 0.0;
+
+    int64_t deviceSwitches = 0;
+    double lastSwitchGapMs = 0.0; // device-change notification -> first new packet
+};
+
+// Which default endpoint a capture follows
+enum class CaptureEndpoint
+{
+    Loopback,   // what the default render device plays
+    Microphone, // the default recording device
+};
+
 class WasapiCapture
 {
 public:
-    WasapiCapture();
+    explicit WasapiCapture(CaptureEndpoint endpoint = CaptureEndpoint::Loopback);
     ~WasapiCapture();
 
     bool Initialize();
-    bool Start(std::function<void(const float *samples, int sampleCount)> callback);
+
+    // scheduling class of the capture thread (applied by the next Start)
+    void SetRealtime(RealtimeClass cls);
+
+    // time is the capture time of the first frame in seconds on the QPC
+    // clock, so streams from different devices can be lined up
+    bool Start(std::function<void(const float *samples, int sampleCount, double time)> callback);
     void Stop();
 
+    // When on, a wakeup that finds no packet hands the callback a silent
+    // block covering the time since the last delivered audio (at most
+    // 100 ms), stamped on ClockNow(). Loopback streams deliver nothing while
+    // the render device is idle; this keeps whatever they clock running.
+    void SetIdleFill(bool enabled);
+
+    // current time on the clock the callback's time uses
+    static double ClockNow();
+
     int sample_rate() const;
+    // channels per interleaved frame handed to the callback
+    int channels() const;
+    // SPEAKER_* bits of those channels in order; 0 when the mix format is
+    // not WAVEFORMATEXTENSIBLE (the default layout for the count applies)
+    uint32_t channel_mask() const;
+
+    CaptureStats stats() const;
+
+    // Called after a device switch changed the rate, channel count or
+    // speaker layout, on the capture thread and before the first packet in
+    // the new format.
+    void SetFormatCallback(std::function<void(int sampleRate, int channels, uint32_t channelMask)> callback);
 
-    // Called internally when default audio device changes
+    // Called internally when default audio device changes. Only schedules
+    // the switch; the capture thread opens and starts the new endpoint
+    // before releasing the old one, so the stream never stops.
     void HandleDeviceChange();
 
 private:
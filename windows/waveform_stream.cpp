@@ -0,0 +1,108 @@
+#include "waveform_stream.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define SAV_HAVE_SSE 1
+#endif
+
+namespace
+{
+    // min/max of a contiguous run, 4 lanes at a time
+    void minMaxRun(const float *x, int n, float &lo, float &hi)
+    {
+        int i = 0;
+#ifdef SAV_HAVE_SSE
+        if (n >= 4)
+        {
+            __m128 vlo = _mm_loadu_ps(x);
+            __m128 vhi = vlo;
+            for (i = 4; i + 4 <= n; i += 4)
+            {
+                __m128 v = _mm_loadu_ps(x + i);
+                vlo = _mm_min_ps(vlo, v);
+                vhi = _mm_max_ps(vhi, v);
+            }
+            float l[4];
+            float h[4];
+            _mm_storeu_ps(l, vlo);
+            _mm_storeu_ps(h, vhi);
+            lo = std::min(lo, std::min(std::min(l[0], l[1]), std::min(l[2], l[3])));
+            hi = std::max(hi, std::max(std::max(h[0], h[1]), std::max(h[2], h[3])));
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+    }
+}
+
+WaveformStream::WaveformStream() : span_(0), pos_(0)
+{
+    Configure(48000, 50, 512, 256);
+}
+
+void WaveformStream::Configure(int sample_rate, int span_ms, int envelope_points, int scope_points)
+{
+    envelope_points = std::max(1, envelope_points);
+    scope_points = std::max(1, scope_points);
+    span_ = std::max({1, sample_rate / 1000 * std::max(1, span_ms), envelope_points, scope_points});
+
+    mono_.assign(span_, 0.0f);
+    left_.assign(span_, 0.0f);
+    right_.assign(span_, 0.0f);
+    pos_ = 0;
+
+    envMin_.assign(envelope_points, 0.0f);
+    envMax_.assign(envelope_points, 0.0f);
+    scopeL_.assign(scope_points, 0.0f);
+    scopeR_.assign(scope_points, 0.0f);
+}
+
+void WaveformStream::Push(const float *samples, int frames, int channels)
+{
+    int rightOffset = channels >= 2 ? 1 : 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        float l = samples[i * channels];
+        float r = samples[i * channels + rightOffset];
+        left_[pos_] = l;
+        right_[pos_] = r;
+        mono_[pos_] = 0.5f * (l + r);
+        pos_ = (pos_ + 1) % span_;
+    }
+}
+
+// min/max over ring positions [start, start + count), split at the wrap
+void WaveformStream::reduce(int start, int count, float &lo, float &hi) const
+{
+    lo = mono_[start % span_];
+    hi = lo;
+    int first = std::min(count, span_ - start % span_);
+    minMaxRun(mono_.data() + start % span_, first, lo, hi);
+    if (count > first)
+        minMaxRun(mono_.data(), count - first, lo, hi);
+}
+
+void WaveformStream::Build()
+{
+    // the ring holds exactly one span; pos_ is the oldest sample
+    int points = static_cast<int>(envMin_.size());
+    for (int p = 0; p < points; ++p)
+    {
+        int begin = static_cast<int>(static_cast<long long>(span_) * p / points);
+        int end = static_cast<int>(static_cast<long long>(span_) * (p + 1) / points);
+        reduce(pos_ + begin, std::max(1, end - begin), envMin_[p], envMax_[p]);
+    }
+
+    int scopePoints = static_cast<int>(scopeL_.size());
+    for (int p = 0; p < scopePoints; ++p)
+    {
+        int idx = (pos_ + static_cast<int>(static_cast<long long>(span_) * p / scopePoints)) % span_;
+        scopeL_[p] = left_[idx];
+        scopeR_[p] = right_[idx];
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef WAVEFORM_STREAM_H_
+#define WAVEFORM_STREAM_H_
+
+#include <vector>
+
+// Time-domain visuals built from a native sample ring: a min/max envelope of
+// the mono mix (oscilloscope) and a strided L/R point cloud (vectorscope),
+// each with a fixed point count per frame regardless of the device rate.
+class WaveformStream
+{
+public:
+    WaveformStream();
+
+    // span_ms of history is reduced to envelope_points min/max pairs and
+    // scope_points L/R pairs
+    void Configure(int sample_rate, int span_ms, int envelope_points, int scope_points);
+
+    // interleaved device frames; the first two channels are used
+    void Push(const float *samples, int frames, int channels);
+
+    // recompute the outputs from the newest span of the ring
+    void Build();
+
+    const std::vector<float> &envelope_min() const { return envMin_; }
+    const std::vector<float> &envelope_max() const { return envMax_; }
+    const std::vector<float> &scope_left() const { return scopeL_; }
+    const std::vector<float> &scope_right() const { return scopeR_; }
+
+private:
+    int span_;
+    std::vector<float> mono_;
+    std::vector<float> left_;
+    std::vector<float> right_;
+    int pos_;
+
+    std::vector<float> envMin_;
+    std::vector<float> envMax_;
+    std::vector<float> scopeL_;
+    std::vector<float> scopeR_;
+
+    void reduce(int start, int count, float &lo, float &hi) const;
+};
+
+#endif // WAVEFORM_STREAM_H_
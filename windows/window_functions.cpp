@@ -0,0 +1,102 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "window_functions.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace
+{
+    using WindowKey = std::tuple<WindowType, int, double>;
+
+    // sum_k a_k * cos(2*pi*k*n/N) with alternating signs
+    double cosineSum(const double *a, int terms, int n, int N)
+    {
+        double x = 2.0 * M_PI * n / N;
+        double sum = 0.0;
+        double sign = 1.0;
+        for (int k = 0; k < terms; ++k)
+        {
+            sum += sign * a[k] * cos(k * x);
+            sign = -sign;
+        }
+        return sum;
+    }
+
+    std::vector<Real> makeWindow(WindowType type, int N, double beta)
+    {
+        static const double kHann[] = {0.5, 0.5};
+        static const double kHamming[] = {0.54, 0.46};
+        static const double kBlackmanHarris[] = {0.35875, 0.48829, 0.14128, 0.01168};
+        static const double kFlatTop[] = {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+
+        std::vector<double> w(N);
+        for (int n = 0; n < N; ++n)
+        {
+            switch (type)
+            {
+            case WindowType::Hamming:
+                w[n] = cosineSum(kHamming, 2, n, N);
+                break;
+            case WindowType::BlackmanHarris:
+                w[n] = cosineSum(kBlackmanHarris, 4, n, N);
+                break;
+            case WindowType::FlatTop:
+                w[n] = cosineSum(kFlatTop, 5, n, N);
+                break;
+            case WindowType::Kaiser:
+            {
+                // periodic: evaluate the symmetric N+1 window, drop the last point
+                double r = 2.0 * n / N - 1.0;
+                w[n] = BesselI0(beta * sqrt(1.0 - r * r)) / BesselI0(beta);
+                break;
+            }
+            default:
+                w[n] = cosineSum(kHann, 2, n, N);
+                break;
+            }
+        }
+
+        double gain = 0.0;
+        for (double v : w)
+            gain += v;
+        gain /= N;
+
+        std::vector<Real> out(N);
+        for (int n = 0; n < N; ++n)
+            out[n] = static_cast<Real>(w[n] / gain);
+        return out;
+    }
+}
+
+double BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; ++k)
+    {
+        double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+const std::vector<Real> &GetWindow(WindowType type, int size, double kaiser_beta)
+{
+    static std::mutex lock;
+    static std::map<WindowKey, std::unique_ptr<std::vector<Real>>> cache;
+
+    if (type != WindowType::Kaiser)
+        kaiser_beta = 0.0;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::unique_ptr<std::vector<Real>> &entry = cache[WindowKey(type, size, kaiser_beta)];
+    if (!entry)
+        entry = std::make_unique<std::vector<Real>>(makeWindow(type, size, kaiser_beta));
+    return *entry;
+}
@@ -0,0 +1,26 @@
+#ifndef WINDOW_FUNCTIONS_H_
+#define WINDOW_FUNCTIONS_H_
+
+#include <vector>
+
+#include "dsp_types.h"
+
+enum class WindowType
+{
+    Hann,
+    Hamming,
+    BlackmanHarris, // 4-term, -92 dB sidelobes
+    Kaiser,
+    FlatTop, // amplitude-accurate, wide main lobe
+};
+
+// Periodic (DFT-even) analysis window, generated once per (type, size, beta)
+// and cached for the lifetime of the process. Coefficients are divided by
+// the window's coherent gain, so a sine reads the same amplitude whichever
+// window is selected. The reference stays valid forever.
+const std::vector<Real> &GetWindow(WindowType type, int size, double kaiser_beta = 8.6);
+
+// zeroth-order modified Bessel function of the first kind (Kaiser windows)
+double BesselI0(double x);
+
+#endif // WINDOW_FUNCTIONS_H_